@@ -0,0 +1,125 @@
+// Times listing a catalog through the TUI console and reports records per
+// second on stderr. Run once per console, since the buffered one turns off
+// stdio sync for the whole process:
+//
+//   ConsoleListingBench new list 1000000 > /dev/null
+//   ConsoleListingBench old browse 1000000 > listing.txt
+//
+// `list` shows every record with one formatted line after it, with no input.
+// `browse` steps through them with `UserInterface::show_images`, answering
+// "Next image" from prepared input, so every record also prints the menu
+// and waits for a read.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "csc/Console.hpp"
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/UserInterface.hpp"
+#include "csc/date.hpp"
+
+namespace {
+
+/// \brief The console before output was buffered: each call goes straight to
+/// `std::cout`, formatted output through a temporary string, with stdio sync
+/// left on.
+class IostreamConsole final : public csc::UserInterface {
+ public:
+  void put(std::string_view message) const override { std::cout << message; }
+  void putln(std::string_view message) const override {
+    std::cout << message << '\n';
+  }
+  void show_image(const csc::ImageRecord& image) const override {
+    std::cout << image << '\n';
+  }
+  void clear_screen() const override { std::cout << "\033[2J\033[1;1H"; }
+  std::string& read_input(std::string& buf) const override {  // NOLINT
+    std::getline(std::cin, buf);
+    return buf;
+  }
+  void wait_for_enter() const noexcept override {
+    char c;
+    while (std::cin.get(c), c != '\n') {
+    }
+  }
+};
+
+auto catalog(std::size_t size) -> csc::ImageAlbum {
+  constexpr std::string_view Words[]{"sunset", "beach",  "mountain", "city",
+                                     "night",  "forest", "river",    "snow"};
+  csc::ImageAlbum::ImageCollection images;
+  images.reserve(size);
+  for (std::size_t i{0}; i < size; ++i) {
+    images.emplace_back(
+        std::format("{} {} {}", Words[i % 8], Words[(i / 8) % 8], i),
+        std::format("Taken on a walk by the {}.", Words[(i / 64) % 8]),
+        csc::ImageRecord::Genre::from_index(i % 9),
+        csc::ImageRecord::DateType{
+            std::chrono::year{2023} / std::chrono::January /
+                std::chrono::day{static_cast<unsigned>((i % 28) + 1)},
+            csc::date::Time{static_cast<std::uint32_t>((i % 86400) * 1000)}},
+        "thumbnail.png");
+  }
+  return csc::ImageAlbum{std::move(images)};
+}
+
+auto list(const csc::UserInterface& ui, const csc::ImageAlbum& album)
+    -> void {
+  std::size_t shown{0};
+  for (const auto& image : album) {
+    ui.show_image(image);
+    ui.println("Image {} of {}, id {}", ++shown, album.size(), image.get_id());
+  }
+}
+
+auto browse(const csc::UserInterface& ui, const csc::ImageAlbum& album)
+    -> void {
+  std::string answers;
+  for (std::size_t i{1}; i < album.size(); ++i) {
+    answers += "1\n";
+  }
+  answers += "3\n";
+  std::istringstream input{answers};
+  auto* const stdin_buffer{std::cin.rdbuf(input.rdbuf())};
+  ui.show_images(album);
+  std::cin.rdbuf(stdin_buffer);
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  if (argc != 4) {
+    std::cerr << "usage: " << argv[0] << " old|new list|browse records\n";
+    return EXIT_FAILURE;
+  }
+  const std::string_view console{argv[1]};
+  const std::string_view mode{argv[2]};
+  const auto album{catalog(std::stoull(argv[3]))};
+
+  using Clock = std::chrono::steady_clock;
+  const auto run = [&](const auto& ui) {
+    const auto start{Clock::now()};
+    (mode == "browse" ? browse : list)(ui, album);
+    if constexpr (requires { ui.flush(); }) {
+      ui.flush();
+    }
+    std::cout.flush();
+    return Clock::now() - start;
+  };
+  const auto elapsed{console == "old" ? run(IostreamConsole{})
+                                      : run(csc::console::Console{})};
+
+  const auto seconds{std::chrono::duration<double>(elapsed).count()};
+  std::cerr << std::format("{} {}: {} records in {:.3f} s, {:.0f} records/s\n",
+                           console, mode, album.size(), seconds,
+                           static_cast<double>(album.size()) / seconds);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#ifndef CSC_ALBUMCURSOR_HPP
+#define CSC_ALBUMCURSOR_HPP
+
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageRecord.hpp"
+
+namespace csc {
+
+/// \brief A position for browsing an album one record at a time, stepping
+/// over removed records. It only reads the album, so any number of cursors
+/// can share one, and browsing the catalog or a cached result copies nothing.
+/// The album must outlive the cursor and stay unchanged while it is used.
+class AlbumCursor {
+ public:
+  inline AlbumCursor() noexcept = default;
+  explicit inline AlbumCursor(const ImageAlbum& album) noexcept
+      : images_{album.get_images()} {}
+  explicit inline AlbumCursor(std::span<const ImageRecord> images) noexcept
+      : images_{images} {}
+
+  /// \throws std::out_of_range if there are no live records.
+  inline auto first() -> const ImageRecord& {
+    for (std::size_t at{0}; at < images_.size(); ++at) {
+      if (not images_[at].is_removed()) {
+        return images_[current_ = at];
+      }
+    }
+    throw std::out_of_range{"No images."};
+  }
+
+  /// \throws std::out_of_range if this is the last one, without moving.
+  inline auto next() -> const ImageRecord& {
+    for (auto next{current_ + 1}; next < images_.size(); ++next) {
+      if (not images_[next].is_removed()) {
+        return images_[current_ = next];
+      }
+    }
+    throw std::out_of_range{"No next image."};
+  }
+
+  /// \throws std::out_of_range if this is the first one, without moving.
+  inline auto previous() -> const ImageRecord& {
+    for (auto previous{current_}; previous-- > 0;) {
+      if (not images_[previous].is_removed()) {
+        return images_[current_ = previous];
+      }
+    }
+    throw std::out_of_range{"No previous image."};
+  }
+
+  /// \brief The record last returned; `first()` must have been called.
+  [[nodiscard]] inline auto current() const -> const ImageRecord& {
+    return images_[current_];
+  }
+
+ private:
+  std::span<const ImageRecord> images_;
+  std::size_t current_{0};
+};
+
+}  // namespace csc
+
+#endif  // CSC_ALBUMCURSOR_HPP
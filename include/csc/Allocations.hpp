@@ -0,0 +1,16 @@
+#ifndef CSC_ALLOCATIONS_HPP
+#define CSC_ALLOCATIONS_HPP
+
+#include <cstdint>
+
+namespace csc::allocations {
+
+/// \brief Calls to `operator new` made by this thread so far. Defined along
+/// with the counting `operator new` in `src/Allocations.cpp`, which only the
+/// programs that watch their allocations link: QUBImages, the GUI and the
+/// tests.
+auto count() noexcept -> std::uint64_t;
+
+}  // namespace csc::allocations
+
+#endif  // CSC_ALLOCATIONS_HPP
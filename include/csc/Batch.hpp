@@ -0,0 +1,45 @@
+#ifndef CSC_BATCH_HPP
+#define CSC_BATCH_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+namespace csc {
+
+class ImageManager;
+
+namespace batch {
+
+/// \brief Runs one query per line from `queries` against `manager` and writes
+/// one JSON object per query (JSON Lines) to `out`.
+///
+/// Each line is a verb followed by its arguments:
+///   id <id>
+///   title <text>
+///   description <text>
+///   genre <genre name>
+///   tags <query>                 (e.g. beach|coast sunset -night)
+///   dates <from> <to>            (ISO-8601, e.g. 2023-01-01T00:00:00)
+///   facets <day | month | year> [tags <query> | dates <from> <to>]
+///   add <title>\t<description>\t<genre name>\t<date>\t<thumbnail path>
+///       [\t<tags>]
+///   remove <id>
+///   tag <id> <tags>, untag <id> <tags>
+///   export <csv | jsonl> <path> (writes the whole catalog to path)
+///   snapshot <path>              (writes every index to path)
+///   load <catalog> <snapshot>    (replaces the catalog, reading the indexes
+///                                 from the snapshot if it is current)
+///   allocations <search>         (e.g. allocations tags beach; counts the
+///                                 heap allocations of one of the searches
+///                                 above, with and without an arena)
+/// Blank lines and lines starting with `#` are skipped.
+///
+/// \return The number of queries that failed.
+auto run(ImageManager& manager, std::istream& queries,
+         std::ostream& out) -> std::size_t;
+
+}  // namespace batch
+}  // namespace csc
+
+#endif  // CSC_BATCH_HPP
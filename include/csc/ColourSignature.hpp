@@ -0,0 +1,195 @@
+#ifndef CSC_COLOURSIGNATURE_HPP
+#define CSC_COLOURSIGNATURE_HPP
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "csc/Snapshot.hpp"
+
+namespace csc::colour {
+
+/// Four levels per RGB channel.
+constexpr std::size_t Bins{64};
+
+/// \brief Share of the opaque pixels in each colour bin, in 255ths. 64 bytes
+/// per image, and comparable with a single L1 distance.
+using Signature = std::array<std::uint8_t, Bins>;
+
+/// Largest possible `distance` between two signatures (plus rounding).
+constexpr unsigned MaxDistance{2 * 255 + Bins};
+
+/// \brief L1 distance; the loop compiles to packed absolute differences.
+inline auto distance(const Signature& a, const Signature& b) noexcept
+    -> unsigned {
+  unsigned total{0};
+  for (std::size_t i{0}; i < Bins; ++i) {
+    total += static_cast<unsigned>(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+  }
+  return total;
+}
+
+/// \brief Signature of `pixel_count` 8-bit RGBA pixels. Mostly transparent
+/// pixels (alpha below 128) are not counted.
+auto signature_rgba(std::span<const unsigned char> rgba,
+                    std::size_t pixel_count) noexcept -> Signature;
+
+struct Match {
+  std::size_t id;
+  unsigned distance;
+};
+
+/// \brief Vantage-point tree: each node splits the rest of its subtree at the
+/// median distance from its own signature, so k-nearest queries prune whole
+/// subtrees with the triangle inequality. Immutable once built.
+class VpTree {
+ public:
+  using Id = std::size_t;
+  /// A plain struct rather than a pair, so nodes can be mapped from disk.
+  struct Item {
+    Id id;
+    Signature signature;
+  };
+
+  VpTree() noexcept = default;
+  explicit VpTree(std::vector<Item> items);
+
+  /// \brief Adds the entries `accept(id, signature)` allows to the max-heap
+  /// `best` (by distance), keeping it at no more than `k` entries.
+  template <typename Accept>
+    requires(std::predicate<Accept&, Id, const Signature&>)
+  inline auto nearest(const Signature& query, std::size_t k, Accept& accept,
+                      std::vector<Match>& best) const -> void {
+    if (k != 0) {
+      search(nodes_.empty() ? None : 0, query, k, accept, best);
+    }
+  }
+
+  /// \brief Keeps `best` a max-heap of the `k` closest matches offered.
+  static inline auto offer(std::vector<Match>& best, std::size_t k,
+                           Match match) -> void {
+    if (best.size() == k) {
+      if (match.distance >= best.front().distance) {
+        return;
+      }
+      std::ranges::pop_heap(best, {}, &Match::distance);
+      best.pop_back();
+    }
+    best.push_back(match);
+    std::ranges::push_heap(best, {}, &Match::distance);
+  }
+
+  /// \brief The distance a candidate must beat to get into `best`.
+  static inline auto bound(const std::vector<Match>& best,
+                           std::size_t k) noexcept -> unsigned {
+    return best.size() < k ? MaxDistance + 1 : best.front().distance;
+  }
+
+  inline auto size() const noexcept -> std::size_t { return nodes_.size(); }
+
+  auto save(snapshot::Writer& writer) const -> void;
+  /// \brief Reads the nodes in place from `snapshot`.
+  auto load(const snapshot::Snapshot& snapshot) -> void;
+
+ private:
+  static constexpr std::uint32_t None{UINT32_MAX};
+
+  struct Node {
+    Item item;
+    /// Median distance from `item` to the rest of the subtree; `inside`
+    /// holds the nearer half.
+    unsigned threshold{0};
+    std::uint32_t inside{None};
+    std::uint32_t outside{None};
+  };
+
+  template <typename Accept>
+  inline auto search(std::uint32_t at, const Signature& query, std::size_t k,
+                     Accept& accept, std::vector<Match>& best) const -> void {
+    if (at == None) {
+      return;
+    }
+    const auto& node{nodes_[at]};
+    const auto d{distance(query, node.item.signature)};
+    if (accept(node.item.id, node.item.signature)) {
+      offer(best, k, {node.item.id, d});
+    }
+
+    // Visit the side the query falls in first; it tightens the bound the
+    // other side is then tested against.
+    if (d <= node.threshold) {
+      search(node.inside, query, k, accept, best);
+      if (d + bound(best, k) >= node.threshold) {
+        search(node.outside, query, k, accept, best);
+      }
+    } else {
+      search(node.outside, query, k, accept, best);
+      if (d <= node.threshold + bound(best, k)) {
+        search(node.inside, query, k, accept, best);
+      }
+    }
+  }
+
+  snapshot::Mappable<Node> nodes_;
+};
+
+/// \brief A `VpTree` plus a short unsorted list of recent additions. Removed
+/// or changed entries are left in place and filtered by the caller; the owner
+/// rebuilds once either the list or the stale entries grow past a fraction of
+/// the tree, so inserts cost amortised O(log n).
+class SignatureIndex {
+ public:
+  using Id = VpTree::Id;
+  using Item = VpTree::Item;
+
+  inline auto insert(Id id, const Signature& signature) -> void {
+    pending_.owned().push_back({.id = id, .signature = signature});
+  }
+  inline auto note_stale() noexcept -> void { ++stale_; }
+
+  inline auto needs_rebuild() const noexcept -> bool {
+    const auto slack{std::max<std::size_t>(MinSlack, tree_.size() / 8)};
+    return pending_.size() > slack or stale_ > slack;
+  }
+  auto rebuild(std::vector<Item> live) -> void;
+  auto clear() noexcept -> void;
+
+  auto save(snapshot::Writer& writer) const -> void;
+  /// \brief Reads the tree and pending list in place from `snapshot` until
+  /// the next change.
+  auto load(const snapshot::Snapshot& snapshot) -> void;
+
+  /// \return Up to `k` accepted entries, nearest first.
+  template <typename Accept>
+    requires(std::predicate<Accept&, Id, const Signature&>)
+  inline auto nearest(const Signature& query, std::size_t k,
+                      Accept&& accept) const -> std::vector<Match> {
+    std::vector<Match> best;
+    best.reserve(k);
+    tree_.nearest(query, k, accept, best);
+    for (const auto& [id, signature] : pending_) {
+      if (k != 0 and accept(id, signature)) {
+        VpTree::offer(best, k, {id, distance(query, signature)});
+      }
+    }
+    std::ranges::sort_heap(best, {}, &Match::distance);
+    return best;
+  }
+
+ private:
+  /// Below this a linear scan of the pending list is cheaper than a rebuild.
+  static constexpr std::size_t MinSlack{1024};
+
+  VpTree tree_;
+  snapshot::Mappable<Item> pending_;
+  std::size_t stale_{0};
+};
+
+}  // namespace csc::colour
+
+#endif  // CSC_COLOURSIGNATURE_HPP
@@ -11,8 +11,12 @@ class Command {
  public:
   enum class Tag : unsigned char {
     AddImage,
+    UpdateImage,
+    RemoveImage,
+    ImportImages,
     SearchImage,
     DisplayAllImages,
+    ShowStats,
     Exit,
   };
 
@@ -1,26 +1,43 @@
 #ifndef CSC_CONSOLE_HPP
 #define CSC_CONSOLE_HPP
 
+#include <cstddef>
+#include <string>
+
 #include "csc/UserInterface.hpp"
 
 namespace csc {  // NOLINT
 namespace console {
 
+/// \brief Terminal front end. Output is formatted into one reusable buffer and
+/// written to `std::cout` in large chunks; the buffer is flushed before any
+/// blocking read so prompts are always visible.
 class Console : public UserInterface {
  public:
-  Console() = default;
-  ~Console() override = default;
+  static constexpr std::size_t FlushThreshold{64UZ * 1024UZ};
+
+  Console();
+  ~Console() override;
 
   void put(std::string_view message) const override;
   void putln(std::string_view message) const override;
 
+  void vput(std::string_view fmt, std::format_args args) const override;
+  void vputln(std::string_view fmt, std::format_args args) const override;
+
   void show_image(const ImageRecord& image) const override;
   void clear_screen() const override;
   std::string& read_input(std::string& buf) const override;  // NOLINT
 
   void wait_for_enter() const noexcept override;
 
+  void flush() const;
+
  private:
+  void flush_if_full() const;
+  void write_buffer() const;
+
+  mutable std::string buffer_;
 };
 
 }  // namespace console
@@ -0,0 +1,26 @@
+#ifndef CSC_CONTENTHASH_HPP
+#define CSC_CONTENTHASH_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace csc::content {
+
+/// \brief XXH64 of a file's bytes. Identifies a thumbnail by what it holds
+/// rather than by which of its paths, copies or links it was reached through.
+using Hash = std::uint64_t;
+
+/// \brief XXH64 of `bytes` with seed 0, bit-for-bit compatible with the
+/// reference implementation.
+auto hash_bytes(std::span<const unsigned char> bytes) noexcept -> Hash;
+
+/// \brief Hashes the whole of the file at `path`.
+/// \return Nothing if it cannot be read.
+auto hash_file(const std::filesystem::path& path) noexcept
+    -> std::optional<Hash>;
+
+}  // namespace csc::content
+
+#endif  // CSC_CONTENTHASH_HPP
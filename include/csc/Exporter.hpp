@@ -0,0 +1,80 @@
+#ifndef CSC_EXPORTER_HPP
+#define CSC_EXPORTER_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "csc/ImageRecord.hpp"
+
+namespace csc::exporter {
+
+enum class Format : unsigned char {
+  /// RFC 4180, with a header row.
+  Csv,
+  /// One JSON object per line.
+  JsonLines,
+};
+
+/// \brief Streams records to a `std::ostream` or a file descriptor.
+///
+/// Records are formatted one at a time into a reused buffer that is written
+/// out whenever it passes `FlushThreshold`, so memory stays bounded no matter
+/// how many records are exported.
+class Exporter {
+ public:
+  static constexpr std::size_t FlushThreshold{256UZ * 1024UZ};
+
+  Exporter(std::ostream& out, Format format);
+  /// \brief Writes to an already open file descriptor, which is not closed.
+  Exporter(int fd, Format format);
+  ~Exporter() noexcept;
+
+  Exporter(const Exporter&) = delete;
+  Exporter(Exporter&&) = delete;
+  auto operator=(const Exporter&) -> Exporter& = delete;
+  auto operator=(Exporter&&) -> Exporter& = delete;
+
+  auto write(const ImageRecord& image) -> void;
+
+  template <typename Records>
+  inline auto write_all(const Records& records) -> void {
+    for (const auto& image : records) {
+      write(image);
+    }
+  }
+
+  /// \throws std::system_error if the file descriptor write fails.
+  auto flush() -> void;
+
+  inline auto records_written() const noexcept -> std::size_t {
+    return records_written_;
+  }
+
+ private:
+  auto write_out() -> void;
+
+  std::variant<std::ostream*, int> sink_;
+  Format format_;
+  std::string buffer_;
+  std::size_t records_written_{0};
+};
+
+/// \brief Appends `text` as a quoted, escaped JSON string.
+auto append_json_string(std::string& out, std::string_view text) -> void;
+/// \brief Appends `image` as a single line JSON object (no newline).
+auto append_json_record(std::string& out, const ImageRecord& image) -> void;
+
+/// \brief Appends `text` as a CSV field, quoted only when it has to be.
+auto append_csv_field(std::string& out, std::string_view text) -> void;
+/// \brief Appends `image` as a CSV row (no newline).
+auto append_csv_record(std::string& out, const ImageRecord& image) -> void;
+/// \brief The column names matching `append_csv_record`.
+constexpr std::string_view CsvHeader{
+    "id,title,description,genre,date_taken,thumbnail_path,tags"};
+
+}  // namespace csc::exporter
+
+#endif  // CSC_EXPORTER_HPP
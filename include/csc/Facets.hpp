@@ -0,0 +1,141 @@
+#ifndef CSC_FACETS_HPP
+#define CSC_FACETS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/Snapshot.hpp"
+
+namespace csc::facet {
+
+/// \brief How finely dates are bucketed.
+enum class Period : std::uint8_t {
+  Day,
+  Month,
+  Year,
+};
+
+constexpr std::size_t PeriodCount{3};
+
+constexpr inline auto period_name(Period period) noexcept -> std::string_view {
+  constexpr std::array<std::string_view, PeriodCount> Names{"day", "month",
+                                                            "year"};
+  return Names[static_cast<std::size_t>(period)];
+}
+auto period_from_name(std::string_view name) noexcept -> std::optional<Period>;
+
+/// \brief A day as days since 1970-01-01, a month as `year * 12 + month - 1`,
+/// or a year as itself, so buckets sort in date order.
+using Bucket = std::int32_t;
+
+auto bucket_of(const std::chrono::year_month_day& date, Period period) noexcept
+    -> Bucket;
+/// \brief `YYYY-MM-DD`, `YYYY-MM` or `YYYY`.
+auto format_bucket(Bucket bucket, Period period) -> std::string;
+
+/// \brief Records per genre, by `ImageRecord::Genre::index()`.
+using GenreCounts = std::array<std::uint32_t, ImageRecord::Genre::Count>;
+
+struct Row {
+  Bucket bucket;
+  GenreCounts genres{};
+
+  [[nodiscard]] auto total() const noexcept -> std::uint64_t;
+};
+
+/// \brief Counts of a set of records by genre, and by period and genre.
+struct Facets {
+  Period period{Period::Year};
+  std::uint64_t total{0};
+  GenreCounts genres{};
+  /// Ascending; only buckets with records.
+  std::vector<Row> rows{};
+};
+
+/// \brief Builds `Facets` one record at a time. Records arriving in date
+/// order, as albums hold them, extend the last row; others find theirs by
+/// binary search.
+class Counter {
+ public:
+  explicit Counter(Period period) noexcept { facets_.period = period; }
+
+  inline auto add(const ImageRecord& image) -> void {
+    const auto bucket{bucket_of(image.get_date_taken().get_date(),
+                                facets_.period)};
+    auto& rows{facets_.rows};
+    Row* row{nullptr};
+    if (not rows.empty() and rows.back().bucket == bucket) {
+      row = &rows.back();
+    } else {
+      row = &find_or_insert(bucket);
+    }
+    const auto genre{image.get_genre().index()};
+    ++row->genres[genre];
+    ++facets_.genres[genre];
+    ++facets_.total;
+  }
+
+  [[nodiscard]] inline auto take() noexcept -> Facets {
+    return std::move(facets_);
+  }
+
+ private:
+  auto find_or_insert(Bucket bucket) -> Row&;
+
+  Facets facets_;
+};
+
+/// \brief Counts the live records of `images` in one pass, without copying
+/// any of them.
+auto count(const ImageAlbum& images, Period period) -> Facets;
+
+/// \brief Adds the counts of `from`, which must use the same period, to
+/// `into`.
+auto merge(Facets& into, const Facets& from) -> void;
+
+/// \brief One line per genre, then one per bucket with its total and
+/// non-zero genres.
+auto write_text(std::ostream& out, const Facets& facets) -> void;
+
+/// \brief Whole-catalog counts per day, month and year and per genre, kept up
+/// to date as records come and go, so reading them costs O(buckets) however
+/// large the catalog.
+class Rollup {
+ public:
+  auto add(const ImageRecord& image) -> void;
+  /// \brief Uncounts a record previously added; empty buckets are dropped.
+  auto remove(const ImageRecord& image) -> void;
+  auto clear() noexcept -> void;
+
+  [[nodiscard]] auto facets(Period period) const -> Facets;
+  [[nodiscard]] inline auto genres() const noexcept -> const GenreCounts& {
+    return genres_;
+  }
+  [[nodiscard]] inline auto total() const noexcept -> std::uint64_t {
+    return total_;
+  }
+
+  auto save(snapshot::Writer& writer) const -> void;
+  /// \brief Reads the rows in place from `snapshot` until the next change.
+  auto load(const snapshot::Snapshot& snapshot) -> void;
+
+ private:
+  /// Sorted by bucket; one array per `Period`.
+  std::array<snapshot::Mappable<Row>, PeriodCount> rows_;
+  GenreCounts genres_{};
+  std::uint64_t total_{0};
+};
+
+}  // namespace csc::facet
+
+#endif  // CSC_FACETS_HPP
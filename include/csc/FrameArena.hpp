@@ -0,0 +1,68 @@
+#ifndef CSC_FRAMEARENA_HPP
+#define CSC_FRAMEARENA_HPP
+
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace csc::frame {
+
+/// \brief Bump allocator for text that lives until the end of a frame.
+/// Allocating moves a pointer; `reset` frees everything at once. A frame that
+/// overflows the block takes extra blocks, and the next `reset` replaces them
+/// all with one block big enough for that frame, so once the arena has seen
+/// the busiest frame it stops touching the heap.
+class Arena {
+ public:
+  static constexpr std::size_t InitialCapacity{16UZ * 1024UZ};
+
+  Arena() : Arena{InitialCapacity} {}
+  explicit Arena(std::size_t capacity);
+
+  /// \brief Uninitialised storage, valid until `reset`. `alignment` must be a
+  /// power of two no stricter than `std::max_align_t`'s.
+  auto allocate(std::size_t bytes,
+                std::size_t alignment = alignof(std::max_align_t)) -> void*;
+
+  /// \brief A NUL-terminated copy of `text`, valid until `reset`.
+  auto copy(std::string_view text) -> std::string_view;
+
+  /// \brief Formats into the arena. The result is NUL terminated, so its
+  /// `data()` can be handed to C APIs, and valid until `reset`.
+  auto vformat(std::string_view fmt, std::format_args args)
+      -> std::string_view;
+  template <typename... Args>
+  inline auto format(const std::format_string<Args...> fmt, Args&&... args)
+      -> std::string_view {
+    return vformat(fmt.get(), std::make_format_args(args...));
+  }
+
+  /// \brief Frees everything allocated since the last reset.
+  auto reset() -> void;
+
+  [[nodiscard]] inline auto used() const noexcept -> std::size_t {
+    return used_ + overflow_bytes_;
+  }
+  [[nodiscard]] inline auto capacity() const noexcept -> std::size_t {
+    return capacity_;
+  }
+
+ private:
+  std::unique_ptr<std::byte[]> block_;
+  std::size_t capacity_;
+  std::size_t used_{0};
+  /// Blocks taken this frame after `block_` filled up.
+  std::vector<std::unique_ptr<std::byte[]>> overflow_;
+  std::size_t overflow_bytes_{0};
+  /// Formatting goes here first, as the length is not known up front. Keeps
+  /// its capacity between frames.
+  std::string scratch_;
+};
+
+}  // namespace csc::frame
+
+#endif  // CSC_FRAMEARENA_HPP
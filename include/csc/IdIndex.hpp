@@ -0,0 +1,79 @@
+#ifndef CSC_IDINDEX_HPP
+#define CSC_IDINDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "csc/Snapshot.hpp"
+
+namespace csc {
+
+/// \brief Record id to slot, as one open-addressed array of pairs probed
+/// linearly and kept at most half full. Being a single flat array rather than
+/// a node per record, a snapshot maps it back in place.
+class IdIndex {
+ public:
+  [[nodiscard]] inline auto find(std::size_t id) const noexcept
+      -> std::optional<std::size_t> {
+    if (entries_.empty()) {
+      return std::nullopt;
+    }
+    const auto mask{entries_.size() - 1};
+    for (auto at{home(id) & mask};; at = (at + 1) & mask) {
+      const auto& entry{entries_[at]};
+      if (entry.id == id) {
+        return entry.slot;
+      }
+      if (entry.id == Empty) {
+        return std::nullopt;
+      }
+    }
+  }
+  /// \throws std::out_of_range if there is no such id.
+  [[nodiscard]] auto at(std::size_t id) const -> std::size_t;
+
+  /// \brief Adds `id` or moves it to `slot`.
+  auto assign(std::size_t id, std::size_t slot) -> void;
+  /// \return false if there was no such id.
+  auto erase(std::size_t id) -> bool;
+  auto clear() noexcept -> void;
+
+  [[nodiscard]] inline auto size() const noexcept -> std::size_t {
+    return size_;
+  }
+
+  auto save(snapshot::Writer& writer) const -> void;
+  /// \brief Reads the table in place from `snapshot` until the next change.
+  auto load(const snapshot::Snapshot& snapshot) -> void;
+
+ private:
+  struct Entry {
+    std::uint64_t id;
+    std::uint64_t slot;
+  };
+
+  /// Record ids count up from zero and never get here.
+  static constexpr std::uint64_t Empty{UINT64_MAX};
+  static constexpr std::size_t MinCapacity{16};
+
+  /// splitmix64 finaliser, so runs of ids do not pile into one cluster.
+  static constexpr inline auto home(std::uint64_t x) noexcept -> std::size_t {
+    x ^= x >> 30U;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27U;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31U;
+    return static_cast<std::size_t>(x);
+  }
+
+  auto grow() -> void;
+
+  /// A power of two long, or empty.
+  snapshot::Mappable<Entry> entries_;
+  std::size_t size_{0};
+};
+
+}  // namespace csc
+
+#endif  // CSC_IDINDEX_HPP
@@ -3,32 +3,110 @@
 
 #include <algorithm>
 #include <concepts>
+#include <cstddef>
 #include <cstring>
+#include <iterator>
+#include <memory_resource>
 #include <ostream>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "csc/ImageRecord.hpp"
+#include "csc/Trace.hpp"
 #include "csc/core.h"
 
 namespace csc {
 
 class ImageAlbum {
  public:
-  using ImageCollection = std::vector<ImageRecord>;
+  /// \brief Records and their strings share the collection's memory
+  /// resource: a pool for a long-lived catalog, or a monotonic buffer for
+  /// results thrown away together.
+  using ImageCollection = std::pmr::vector<ImageRecord>;
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+
+  /// \brief Walks the album in date order, stepping over removed records.
+  class Iterator {
+   public:
+    using Base = ImageCollection::const_iterator;
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ImageRecord;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ImageRecord*;
+    using reference = const ImageRecord&;
+
+    inline Iterator() noexcept = default;
+    inline Iterator(Base it, Base end) noexcept : it_{it}, end_{end} {
+      skip_removed();
+    }
+
+    inline auto operator*() const noexcept -> reference { return *it_; }
+    inline auto operator->() const noexcept -> pointer { return &*it_; }
+
+    inline auto operator++() noexcept -> Iterator& {
+      ++it_;
+      skip_removed();
+      return *this;
+    }
+    inline auto operator++(int) noexcept -> Iterator {
+      auto copy{*this};
+      ++*this;
+      return copy;
+    }
+
+    friend inline auto operator==(const Iterator& self,
+                                  const Iterator& other) noexcept -> bool {
+      return self.it_ == other.it_;
+    }
+
+   private:
+    inline auto skip_removed() noexcept -> void {
+      while (it_ != end_ and it_->is_removed()) {
+        ++it_;
+      }
+    }
+
+    Base it_;
+    Base end_;
+  };
 
   explicit inline ImageAlbum(ImageCollection images = {}) noexcept
-      : images_(std::move(images)) {}
+      : images_(std::move(images)),
+        removed_count_{static_cast<std::size_t>(std::ranges::count_if(
+            images_, &ImageRecord::is_removed))} {}
+
+  /// \brief An empty album whose records will come from `allocator`.
+  explicit inline ImageAlbum(allocator_type allocator) noexcept
+      : images_(allocator) {}
 
   constexpr ImageAlbum(const ImageAlbum& other) noexcept = default;
-  constexpr ImageAlbum(ImageAlbum&& other) noexcept = default;
+  /// \brief Leaves `other` empty, tombstones and all.
+  inline ImageAlbum(ImageAlbum&& other) noexcept
+      : images_(std::move(other.images_)),
+        removed_count_{std::exchange(other.removed_count_, 0)} {}
+  inline ImageAlbum(const ImageAlbum& other, allocator_type allocator)
+      : images_(other.images_, allocator),
+        removed_count_{other.removed_count_} {}
   auto operator=(const ImageAlbum& other) noexcept -> ImageAlbum& = default;
-  auto operator=(ImageAlbum&& other) noexcept -> ImageAlbum& = default;
+  inline auto operator=(ImageAlbum&& other) noexcept -> ImageAlbum& {
+    images_ = std::move(other.images_);
+    removed_count_ = std::exchange(other.removed_count_, 0);
+    // Records are moved one by one, not stolen, between memory resources.
+    other.images_.clear();
+    return *this;
+  }
 
   template <typename... Args>
     requires(std::is_same_v<Args, ImageRecord> and ...)
   explicit inline ImageAlbum(Args&&... images) noexcept
       : images_{std::forward<Args>(images)...} {}
 
+  inline auto get_allocator() const noexcept -> allocator_type {
+    return images_.get_allocator();
+  }
+
   MAYBE_CONSTEXPR inline auto get_images() const noexcept
       -> const ImageCollection& {
     return images_;
@@ -37,59 +115,97 @@ class ImageAlbum {
     return images_;
   }
 
-  inline auto get_first_image() -> const ImageRecord& {
-    current_image_ = 0ULL;
-    return images_.at(current_image_);
+  /// \brief Inserts in date order.
+  /// \return The slot the record now occupies in `get_images()`.
+  inline auto emplace(ImageRecord&& image) -> std::size_t {
+    CSC_TRACE_SCOPE("ImageAlbum::emplace");
+    auto it{
+        std::lower_bound(images_.begin(), images_.end(), image, std::less{})};
+    it = images_.insert(it, std::move(image));
+    return static_cast<std::size_t>(it - images_.begin());
+  }
+  inline auto emplace(const ImageRecord& image) -> std::size_t {
+    CSC_TRACE_SCOPE("ImageAlbum::emplace");
+    auto it{
+        std::lower_bound(images_.begin(), images_.end(), image, std::less{})};
+    it = images_.insert(it, image);
+    return static_cast<std::size_t>(it - images_.begin());
+  }
+
+  template <typename... MyArgs>
+    requires(std::constructible_from<ImageAlbum, MyArgs...>)
+  inline auto emplace(MyArgs&&... args) -> std::size_t {
+    return emplace(ImageRecord{std::forward<MyArgs>(args)...});
   }
 
-  inline auto get_next_image() -> const ImageRecord& {
-    if (current_image_ >= images_.size() - 1) {
-      throw std::out_of_range{"No next image."};
+  /// \brief Inserts a whole batch in date order with one sort and one merge,
+  /// rather than shifting the tail once per record.
+  /// \return The first slot whose record changed.
+  inline auto emplace_all(ImageCollection&& images) -> std::size_t {
+    CSC_TRACE_SCOPE("ImageAlbum::emplace_all");
+    if (images.empty()) {
+      return images_.size();
     }
-    return images_[++current_image_];
+    std::ranges::stable_sort(images, std::less{});
+    const auto first_changed{std::ranges::upper_bound(images_, images.front(),
+                                                      std::less{}) -
+                             images_.begin()};
+    const auto middle{static_cast<std::ptrdiff_t>(images_.size())};
+
+    images_.reserve(images_.size() + images.size());
+    std::ranges::move(images, std::back_inserter(images_));
+    std::inplace_merge(images_.begin() + first_changed,
+                       images_.begin() + middle, images_.end(), std::less{});
+    return static_cast<std::size_t>(first_changed);
   }
 
-  inline auto get_previous_image() -> const ImageRecord& {
-    if (current_image_ == 0) {
-      throw std::out_of_range{"No previous image."};
+  /// \brief Tombstones the record in `slot`; it stays in `get_images()` until
+  /// the next `compact()`.
+  inline auto remove_at(std::size_t slot) -> void {
+    auto& image{images_.at(slot)};
+    if (not image.removed_) {
+      image.removed_ = true;
+      ++removed_count_;
     }
-    return images_[--current_image_];
   }
 
-  inline auto emplace(ImageRecord&& image) -> void {
-    auto it{
-        std::lower_bound(images_.begin(), images_.end(), image, std::less{})};
-    images_.insert(it, std::move(image));
-  }
-  inline auto emplace(const ImageRecord& image) -> void {
-    auto it{
-        std::lower_bound(images_.begin(), images_.end(), image, std::less{})};
-    images_.insert(it, image);
+  /// \brief Drops every tombstoned record. Shifts the slots of the rest.
+  inline auto compact() -> void {
+    if (removed_count_ != 0) {
+      std::erase_if(images_, &ImageRecord::is_removed);
+      removed_count_ = 0;
+    }
   }
 
-  template <typename... MyArgs>
-    requires(std::constructible_from<ImageAlbum, MyArgs...>)
-  inline auto emplace(MyArgs&&... args) -> void {
-    emplace(ImageRecord{std::forward<MyArgs>(args)...});
+  MAYBE_CONSTEXPR inline auto removed_count() const noexcept -> std::size_t {
+    return removed_count_;
   }
 
-  inline auto is_empty() const noexcept -> bool { return images_.empty(); }
+  inline auto is_empty() const noexcept -> bool { return size() == 0; }
 
   explicit inline operator std::string() const noexcept {
     std::string result;
+    auto out{std::back_inserter(result)};
 
-    for (const auto& image : images_) {
-      result += image.to_string() + "\n";
+    for (const auto& image : *this) {
+      if (not result.empty()) {
+        result += '\n';
+      }
+      out = image.format_to(out);
     }
-    result.erase(result.end() - 1);
     return result;
   }
 
-  MAYBE_CONSTEXPR inline auto begin() const noexcept { return images_.begin(); }
-  MAYBE_CONSTEXPR inline auto end() const noexcept { return images_.end(); }
+  inline auto begin() const noexcept -> Iterator {
+    return {images_.begin(), images_.end()};
+  }
+  inline auto end() const noexcept -> Iterator {
+    return {images_.end(), images_.end()};
+  }
 
+  /// \brief Number of live (not removed) records.
   MAYBE_CONSTEXPR inline auto size() const noexcept -> std::size_t {
-    return images_.size();
+    return images_.size() - removed_count_;
   }
 
  private:
@@ -97,9 +213,7 @@ class ImageAlbum {
                          const ImageAlbum& album) -> std::ostream&;
 
   ImageCollection images_;
-
-  /// \brief Iterator for the images in the album.
-  std::size_t current_image_{0};
+  std::size_t removed_count_{0};
 };
 
 inline auto operator<<(std::ostream& os,
@@ -112,7 +226,9 @@ inline auto operator<<(std::ostream& os,
 }
 inline auto operator<<(std::ostream& os,
                        const ImageAlbum& album) -> std::ostream& {
-  os << album.images_;
+  for (const auto& image : album) {
+    os << image << "\n";
+  }
   return os;
 }
 
@@ -0,0 +1,84 @@
+#ifndef CSC_IMAGEINFO_HPP
+#define CSC_IMAGEINFO_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace csc {
+
+/// \brief What the image file's header says about it. Default constructed
+/// (`Format::Unknown`) until the file has been probed.
+struct ImageInfo {
+  enum class Format : unsigned char {
+    Unknown,
+    Png,
+    Jpeg,
+  };
+
+  enum class Orientation : unsigned char {
+    Landscape,
+    Portrait,
+    Square,
+  };
+
+  Format format{Format::Unknown};
+  std::uint32_t width{0};
+  std::uint32_t height{0};
+  /// Colour channels as stb_image would decode them (1 to 4).
+  std::uint8_t channels{0};
+  std::uintmax_t file_size{0};
+
+  constexpr inline auto is_known() const noexcept -> bool {
+    return format != Format::Unknown;
+  }
+
+  /// \brief Width over height, or 0 if the size is not known.
+  constexpr inline auto aspect_ratio() const noexcept -> double {
+    if (height == 0) {
+      return 0.0;
+    }
+    return static_cast<double>(width) / static_cast<double>(height);
+  }
+
+  constexpr inline auto orientation() const noexcept -> Orientation {
+    if (width > height) {
+      return Orientation::Landscape;
+    }
+    return width < height ? Orientation::Portrait : Orientation::Square;
+  }
+
+  constexpr inline auto format_name() const noexcept -> std::string_view {
+    switch (format) {
+      case Format::Png:
+        return "PNG";
+      case Format::Jpeg:
+        return "JPEG";
+      case Format::Unknown:
+        break;
+    }
+    return "Unknown";
+  }
+
+  static constexpr inline auto orientation_from_name(
+      std::string_view name) noexcept -> std::optional<Orientation> {
+    if (name == "landscape") {
+      return Orientation::Landscape;
+    }
+    if (name == "portrait") {
+      return Orientation::Portrait;
+    }
+    if (name == "square") {
+      return Orientation::Square;
+    }
+    return std::nullopt;
+  }
+
+  friend constexpr inline auto operator==(const ImageInfo&,
+                                          const ImageInfo&) noexcept
+      -> bool = default;
+};
+
+}  // namespace csc
+
+#endif  // CSC_IMAGEINFO_HPP
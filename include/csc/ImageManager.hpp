@@ -1,56 +1,310 @@
 #ifndef CSC_IMAGEMANAGER_HPP
 #define CSC_IMAGEMANAGER_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <optional>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "csc/ColourSignature.hpp"
+#include "csc/Facets.hpp"
+#include "csc/IdIndex.hpp"
 #include "csc/ImageAlbum.hpp"
+#include "csc/ImageInfo.hpp"
 #include "csc/ImageRecord.hpp"
+#include "csc/Metrics.hpp"
+#include "csc/PerceptualHash.hpp"
+#include "csc/PrefixIndex.hpp"
+#include "csc/Snapshot.hpp"
+#include "csc/Tags.hpp"
+#include "csc/Trace.hpp"
 #include "csc/core.h"
 
 namespace csc {
 
 #define NO_DISCARD [[nodiscard]]
+
+/// \brief Names one state of a catalog. Every change takes a fresh number from
+/// a process-wide counter, so two catalogs share a version only while one is
+/// an unchanged copy of the other, and anything cached against a version can
+/// never be served for a different state.
+class CatalogVersion {
+ public:
+  inline CatalogVersion() noexcept : value_{next()} {}
+  CatalogVersion(const CatalogVersion&) noexcept = default;
+  auto operator=(const CatalogVersion&) noexcept -> CatalogVersion& = default;
+  /// A moved-from catalog has changed too.
+  inline CatalogVersion(CatalogVersion&& other) noexcept
+      : value_{other.value_} {
+    other.bump();
+  }
+  inline auto operator=(CatalogVersion&& other) noexcept -> CatalogVersion& {
+    value_ = other.value_;
+    other.bump();
+    return *this;
+  }
+  ~CatalogVersion() noexcept = default;
+
+  inline auto bump() noexcept -> void { value_ = next(); }
+  NO_DISCARD inline auto value() const noexcept -> std::uint64_t {
+    return value_;
+  }
+
+ private:
+  static inline auto next() noexcept -> std::uint64_t {
+    static std::atomic<std::uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  std::uint64_t value_;
+};
+
 class ImageManager {
  private:
   friend class ImageManager;
 
  public:
-  constexpr inline auto take_album() noexcept -> decltype(auto) {
+  /// Compact once this fraction of the stored slots are tombstones.
+  static constexpr double CompactionThreshold{0.25};
+
+  inline auto take_album() noexcept -> ImageAlbum {
+    version_.bump();
+    clear_indexes();
     return std::move(album_);
   }
 
   inline ImageManager() noexcept = default;
+  /// \brief The catalog's records and their strings are allocated from
+  /// `resource`, such as a `std::pmr::unsynchronized_pool_resource` that
+  /// outlives the manager. Indexes still use the global heap.
+  explicit inline ImageManager(std::pmr::memory_resource* resource) noexcept
+      : album_{ImageAlbum::allocator_type{resource}} {}
   template <typename... Args>
     requires(std::is_same_v<Args, ImageRecord> and ...)
   explicit inline ImageManager(Args&&... images) noexcept
-      : album_(std::forward<ImageRecord>(images)...) {}
+      : album_(std::forward<ImageRecord>(images)...) {
+    build_indexes();
+  }
+
+  /// \brief Replaces the catalog with `images`. When the snapshot at `path`
+  /// was saved from these same records, every index is read from it in place
+  /// and the records take back the ids they had then; otherwise the indexes
+  /// are built as usual.
+  /// \return Whether the snapshot was used.
+  inline auto load(ImageAlbum::ImageCollection&& images,
+                   const std::filesystem::path& path) -> bool {
+    CSC_TRACE_SCOPE("ImageManager::load");
+    version_.bump();
+    clear_indexes();
+    std::ranges::stable_sort(images, std::less{});
+    album_ = ImageAlbum{std::move(images)};
+    metrics::library().inserted.add(album_.size());
+
+    if (auto opened = snapshot::Snapshot::open(path);
+        opened and opened->fingerprint() == snapshot::fingerprint(album_)) {
+      try {
+        adopt(std::make_shared<const snapshot::Snapshot>(std::move(*opened)));
+        return true;
+      } catch (const std::exception&) {
+        // Laid out by another build; fall back to building.
+        clear_indexes();
+      }
+    }
+    build_indexes();
+    return false;
+  }
 
-  inline auto add_image(ImageRecord&& image) noexcept -> void {
-    album_.emplace(std::move(image));
+  /// \brief Compacts, then writes every index to `path` for a later `load`
+  /// of the same records.
+  /// \throws std::runtime_error if the file cannot be written.
+  inline auto save_snapshot(const std::filesystem::path& path) -> void {
+    CSC_TRACE_SCOPE("ImageManager::save_snapshot");
+    compact();
+    std::vector<std::uint64_t> ids;
+    ids.reserve(album_.size());
+    for (const auto& image : album_) {
+      ids.push_back(image.get_id());
+    }
+
+    snapshot::Writer writer;
+    writer.add(snapshot::Section::Records,
+               std::span<const std::uint64_t>{ids});
+    writer.add_value(snapshot::Section::NextId,
+                     std::uint64_t{ImageRecord::next_id});
+    id_index_.save(writer);
+    similar_index_.save(writer);
+    colour_index_.save(writer);
+    title_index_.save(writer);
+    tag_index_.save(writer);
+    rollup_.save(writer);
+    writer.write(path, snapshot::fingerprint(album_));
+  }
+
+  /// \throws std::overflow_error if the record's id does not fit the tag
+  /// index. Nothing is changed.
+  inline auto add_image(ImageRecord&& image) -> void {
+    static_cast<void>(tag_id(image));
+    version_.bump();
+    index_similar(image);
+    index_colour(image);
+    title_index_.insert(image.get_title());
+    index_tags(image);
+    rollup_.add(image);
+    reindex_from(album_.emplace(std::move(image)));
+    rebuild_colour_index_if_needed();
+    metrics::library().inserted.add();
   }
   template <typename... Args>
-  inline auto add_image(Args&&... args) noexcept -> void {
-    album_.emplace(std::forward<Args>(args)...);
+  inline auto add_image(Args&&... args) -> void {
+    add_image(ImageRecord{std::forward<Args>(args)...});
+  }
+
+  /// \brief Adds a batch of records, reindexing once for the whole batch.
+  /// \throws std::overflow_error, changing nothing, if any record's id does
+  /// not fit the tag index.
+  inline auto add_images(ImageAlbum::ImageCollection&& images) -> void {
+    for (const auto& image : images) {
+      static_cast<void>(tag_id(image));
+    }
+    version_.bump();
+    metrics::library().inserted.add(images.size());
+    for (const auto& image : images) {
+      index_similar(image);
+      index_colour(image);
+      title_index_.insert(image.get_title());
+      index_tags(image);
+      rollup_.add(image);
+    }
+    reindex_from(album_.emplace_all(std::move(images)));
+    rebuild_colour_index_if_needed();
+  }
+
+  /// \brief Tombstones the record with `id`. It disappears from every search
+  /// immediately and its slot is reclaimed by a later compaction.
+  /// \return false if there is no such record.
+  inline auto remove_image(const std::size_t id) -> bool {
+    const auto found{id_index_.find(id)};
+    if (not found) {
+      return false;
+    }
+    version_.bump();
+    const auto& image{album_.get_images()[*found]};
+    if (image.get_colour_signature()) {
+      colour_index_.note_stale();
+    }
+    title_index_.erase(image.get_title());
+    unindex_tags(image);
+    rollup_.remove(image);
+    album_.remove_at(*found);
+    id_index_.erase(id);
+    compact_if_needed();
+    rebuild_colour_index_if_needed();
+    metrics::library().removed.add();
+    return true;
+  }
+
+  /// \brief Applies `edit` to the record with `id`. A record whose date
+  /// changes is moved to its new place in date order, keeping its id.
+  /// \return false if there is no such record.
+  template <typename Edit>
+    requires(std::invocable<Edit, ImageRecord&>)
+  inline auto update_image(const std::size_t id, Edit&& edit) -> bool {
+    const auto found{id_index_.find(id)};
+    if (not found) {
+      return false;
+    }
+    version_.bump();
+    const auto slot{*found};
+    auto& images{album_.get_images()};
+
+    auto updated{images[slot]};
+    std::invoke(std::forward<Edit>(edit), updated);
+    updated.id_ = id;
+    // The old tree entry goes stale; searches check the live hash.
+    if (updated.get_perceptual_hash() != images[slot].get_perceptual_hash()) {
+      index_similar(updated);
+    }
+    if (updated.get_colour_signature() != images[slot].get_colour_signature()) {
+      if (images[slot].get_colour_signature()) {
+        colour_index_.note_stale();
+      }
+      index_colour(updated);
+    }
+    if (updated.get_title() != images[slot].get_title()) {
+      title_index_.erase(images[slot].get_title());
+      title_index_.insert(updated.get_title());
+    }
+    if (updated.get_genre() != images[slot].get_genre() or
+        updated.get_tags() != images[slot].get_tags()) {
+      unindex_tags(images[slot]);
+      index_tags(updated);
+    }
+    if (updated.get_genre() != images[slot].get_genre() or
+        updated.get_date_taken().get_date() !=
+            images[slot].get_date_taken().get_date()) {
+      rollup_.remove(images[slot]);
+      rollup_.add(updated);
+    }
+
+    if (updated.get_date_taken() == images[slot].get_date_taken()) {
+      images[slot] = std::move(updated);
+    } else {
+      album_.remove_at(slot);
+      reindex_from(album_.emplace(std::move(updated)));
+      compact_if_needed();
+    }
+    rebuild_colour_index_if_needed();
+    metrics::library().updated.add();
+    return true;
+  }
+
+  /// \brief Reclaims the slots of removed records. Records move to other
+  /// slots, so this is a new `version()` if anything was removed.
+  inline auto compact() -> void {
+    if (album_.removed_count() != 0) {
+      version_.bump();
+      album_.compact();
+      reindex_from(0);
+      rebuild_similar_index();
+      rebuild_colour_index();
+    }
   }
 
   NO_DISCARD inline auto search_id(const std::size_t id) const noexcept
       -> std::optional<const ImageRecord*> {
-    for (const auto& image : album_) {
-      if (image.get_id() == id) {
-        return &image;
-      }
+    CSC_TRACE_SCOPE("ImageManager::search_id");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Id)};
+    const auto found{id_index_.find(id)};
+    if (not found) {
+      return std::nullopt;
     }
-    return std::nullopt;
+    return &album_.get_images()[*found];
   }
 
   NO_DISCARD inline auto search_title(
-      const std::string_view title) const noexcept -> ImageAlbum {
+      const std::string_view title,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const noexcept -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_title");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Title)};
     std::vector<const ImageRecord*> out;
-    ImageAlbum album;
+    ImageAlbum album{ImageAlbum::allocator_type{resource}};
     for (const auto& image : album_) {
       if (image.get_title().find(title) != std::string_view::npos) {
         album.emplace(image);
@@ -59,9 +313,14 @@ class ImageManager {
     return std::move(album);
   }
   NO_DISCARD inline auto search_description(
-      const std::string_view title) const noexcept -> ImageAlbum {
+      const std::string_view title,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const noexcept -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_description");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Description)};
     std::vector<const ImageRecord*> out;
-    ImageAlbum album;
+    ImageAlbum album{ImageAlbum::allocator_type{resource}};
     for (const auto& image : album_) {
       if (image.get_description().find(title) != std::string_view::npos) {
         album.emplace(image);
@@ -71,8 +330,13 @@ class ImageManager {
   }
 
   NO_DISCARD inline auto search_genre(
-      const ImageRecord::Genre& genre) const noexcept -> ImageAlbum {
-    ImageAlbum album;
+      const ImageRecord::Genre& genre,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const noexcept -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_genre");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Genre)};
+    ImageAlbum album{ImageAlbum::allocator_type{resource}};
     for (const auto& image : album_) {
       if (image.get_genre() == genre) {
         album.emplace(image);
@@ -81,10 +345,131 @@ class ImageManager {
     return std::move(album);
   }
 
+  /// \brief Records matching a tag query, in date order. Genres count as
+  /// their built-in tags.
+  NO_DISCARD inline auto search_tags(
+      const tags::Query& query,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_tags");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Tags)};
+    const auto matches{tag_index_.evaluate(query)};
+    std::pmr::vector<std::size_t> slots{resource};
+    slots.reserve(matches.cardinality());
+    matches.for_each(
+        [&](std::uint32_t id) { slots.push_back(id_index_.at(id)); });
+    std::ranges::sort(slots);
+
+    ImageAlbum::ImageCollection images{resource};
+    images.reserve(slots.size());
+    for (const auto slot : slots) {
+      images.push_back(album_.get_images()[slot]);
+    }
+    return ImageAlbum{std::move(images)};
+  }
+  NO_DISCARD inline auto search_tags(
+      const std::string_view query,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const -> ImageAlbum {
+    return search_tags(tags::parse_query(query), resource);
+  }
+
+  NO_DISCARD inline auto tag_index() const noexcept -> const tags::TagIndex& {
+    return tag_index_;
+  }
+
+  /// \brief Whole-catalog counts by genre and by `period` and genre, read
+  /// from rollups kept up to date on every change: O(buckets).
+  NO_DISCARD inline auto facets(const facet::Period period) const
+      -> facet::Facets {
+    return rollup_.facets(period);
+  }
+  NO_DISCARD inline auto genre_counts() const noexcept
+      -> const facet::GenreCounts& {
+    return rollup_.genres();
+  }
+
+  /// \brief Counts of the records `predicate` accepts, in one pass over the
+  /// catalog and without copying any of them.
+  template <typename Predicate>
+    requires(std::predicate<Predicate, const ImageRecord&>)
+  NO_DISCARD inline auto facets_if(Predicate&& predicate,
+                                   const facet::Period period) const
+      -> facet::Facets {
+    CSC_TRACE_SCOPE("ImageManager::facets_if");
+    facet::Counter counter{period};
+    for (const auto& image : album_) {
+      if (std::invoke(predicate, image)) {
+        counter.add(image);
+      }
+    }
+    return counter.take();
+  }
+
+  /// \brief Counts of the records matching a tag query, read straight from
+  /// the matching ids.
+  NO_DISCARD inline auto facets(const tags::Query& query,
+                                const facet::Period period) const
+      -> facet::Facets {
+    CSC_TRACE_SCOPE("ImageManager::facets");
+    const auto& images{album_.get_images()};
+    facet::Counter counter{period};
+    tag_index_.evaluate(query).for_each([&](std::uint32_t id) {
+      counter.add(images[id_index_.at(id)]);
+    });
+    return counter.take();
+  }
+
+  /// \brief The `k` records whose colour signatures are closest to
+  /// `signature`, in date order. See `nearest_colours` for them ranked.
+  NO_DISCARD inline auto search_colour(
+      const colour::Signature& signature, const std::size_t k,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_colour");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Colour)};
+    std::pmr::vector<std::size_t> slots{resource};
+    for (const auto& match : nearest_colours(signature, k)) {
+      slots.push_back(id_index_.at(match.id));
+    }
+    std::ranges::sort(slots);
+
+    ImageAlbum::ImageCollection images{resource};
+    images.reserve(slots.size());
+    for (const auto slot : slots) {
+      images.push_back(album_.get_images()[slot]);
+    }
+    return ImageAlbum{std::move(images)};
+  }
+
+  /// \brief Ids of the `k` records whose colour signatures are closest to
+  /// `signature`, nearest first, found through a vantage-point tree.
+  NO_DISCARD inline auto nearest_colours(const colour::Signature& signature,
+                                         const std::size_t k) const
+      -> std::vector<colour::Match> {
+    const auto& images{album_.get_images()};
+    // An id edited back to an old signature can be in the index twice.
+    std::unordered_set<std::size_t> seen;
+    return colour_index_.nearest(
+        signature, k,
+        [&](std::size_t id, const colour::Signature& indexed) {
+          const auto found{id_index_.find(id)};
+          return found and
+                 images[*found].get_colour_signature() == indexed and
+                 seen.insert(id).second;
+        });
+  }
+
   NO_DISCARD inline auto search_between_dates(
-      const date::DateTime& start,
-      const date::DateTime& end) const noexcept -> ImageAlbum {
-    ImageAlbum album;
+      const date::DateTime& start, const date::DateTime& end,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const noexcept -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_between_dates");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Date)};
+    ImageAlbum album{ImageAlbum::allocator_type{resource}};
     for (const auto& image : album_) {
       const auto date = image.get_date_taken();
       if (date >= start && date <= end) {
@@ -94,14 +479,143 @@ class ImageManager {
     return std::move(album);
   }
 
+  /// \brief Records whose perceptual hash is within `max_distance` bits of
+  /// `hash`, found through a BK-tree rather than a scan.
+  NO_DISCARD inline auto search_similar(
+      const phash::Hash hash,
+      const unsigned max_distance = phash::DefaultMaxDistance,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_similar");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Similar)};
+    const auto& images{album_.get_images()};
+    std::pmr::vector<std::size_t> slots{resource};
+    similar_index_.for_each_within(
+        hash, max_distance, [&](std::size_t id, unsigned) {
+          const auto found{id_index_.find(id)};
+          if (not found) {
+            return;
+          }
+          const auto current{images[*found].get_perceptual_hash()};
+          if (current and phash::distance(*current, hash) <= max_distance) {
+            slots.push_back(*found);
+          }
+        });
+
+    // Slots are in date order; an id edited back to an old hash can be in
+    // the tree twice.
+    std::ranges::sort(slots);
+    const auto [first, last] = std::ranges::unique(slots);
+    slots.erase(first, last);
+
+    ImageAlbum::ImageCollection similar{resource};
+    similar.reserve(slots.size());
+    for (const auto slot : slots) {
+      similar.push_back(images[slot]);
+    }
+    return ImageAlbum{std::move(similar)};
+  }
+
+  /// \brief Ids of near-duplicate pictures, grouped. See
+  /// `phash::find_clusters`.
+  NO_DISCARD inline auto duplicate_clusters(
+      const unsigned max_distance = phash::DefaultMaxDistance,
+      const std::size_t threads = 0) const
+      -> std::vector<std::vector<std::size_t>> {
+    return phash::find_clusters(perceptual_hashes(), max_distance, threads);
+  }
+
+  /// \brief The id and hash of every live record that has been hashed.
+  NO_DISCARD inline auto perceptual_hashes() const
+      -> std::vector<std::pair<std::size_t, phash::Hash>> {
+    std::vector<std::pair<std::size_t, phash::Hash>> hashes;
+    for (const auto& image : album_) {
+      if (const auto hash = image.get_perceptual_hash()) {
+        hashes.emplace_back(image.get_id(), *hash);
+      }
+    }
+    return hashes;
+  }
+
+  /// \brief Titles and title words starting with `prefix`, most used
+  /// first, without regard to ASCII case.
+  NO_DISCARD inline auto suggest_titles(
+      const std::string_view prefix,
+      const std::size_t n = suggest::MaxSuggestions) const
+      -> std::vector<suggest::Suggestion> {
+    return title_index_.complete(prefix, n);
+  }
+
+  NO_DISCARD inline auto title_index() const noexcept
+      -> const suggest::PrefixIndex& {
+    return title_index_;
+  }
+
+  /// \brief Sets the library gauges that describe this catalog.
+  inline auto sample_metrics() const noexcept -> void {
+    const auto& library{metrics::library()};
+    const auto bytes{title_index_.bytes()};
+    library.catalog_size.set(static_cast<std::int64_t>(size()));
+    library.title_index_bytes.set(static_cast<std::int64_t>(bytes));
+    library.title_index_bytes_per_title.set(static_cast<std::int64_t>(
+        bytes / std::max<std::size_t>(title_index_.titles(), 1)));
+  }
+
+  /// \brief Records whose probed size is at least `width` by `height`.
+  /// Records that were never probed do not match.
+  NO_DISCARD inline auto search_min_size(
+      const std::uint32_t width, const std::uint32_t height,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const noexcept -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_min_size");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Size)};
+    return search_if(
+        [width, height](const ImageRecord& image) {
+          const auto& info{image.get_info()};
+          return info.is_known() and info.width >= width and
+                 info.height >= height;
+        },
+        resource);
+  }
+
+  NO_DISCARD inline auto search_orientation(
+      const ImageInfo::Orientation orientation,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const noexcept -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_orientation");
+    const metrics::ScopedLatency latency{
+        metrics::library().search(metrics::Search::Orientation)};
+    return search_if(
+        [orientation](const ImageRecord& image) {
+          const auto& info{image.get_info()};
+          return info.is_known() and info.orientation() == orientation;
+        },
+        resource);
+  }
+
+  /// \brief Every live record `predicate` accepts, in date order.
+  template <typename Predicate>
+    requires(std::predicate<Predicate, const ImageRecord&>)
+  NO_DISCARD inline auto search_if(
+      Predicate&& predicate,
+      std::pmr::memory_resource* resource =
+          std::pmr::get_default_resource()) const -> ImageAlbum {
+    CSC_TRACE_SCOPE("ImageManager::search_if");
+    ImageAlbum::ImageCollection images{resource};
+    for (const auto& image : album_) {
+      if (std::invoke(predicate, image)) {
+        images.push_back(image);
+      }
+    }
+    return ImageAlbum{std::move(images)};
+  }
+
   NO_DISCARD MAYBE_CONSTEXPR inline auto get_all_images() const noexcept
       -> const ImageAlbum& {
     return album_;
   }
-  NO_DISCARD MAYBE_CONSTEXPR inline auto get_all_images() noexcept
-      -> ImageAlbum& {
-    return album_;
-  }
 
   NO_DISCARD MAYBE_CONSTEXPR inline auto is_empty() const noexcept -> bool {
     return album_.is_empty();
@@ -111,13 +625,175 @@ class ImageManager {
     return album_.size();
   }
 
+  /// \brief Changes whenever a record is added, removed or edited.
+  NO_DISCARD inline auto version() const noexcept -> std::uint64_t {
+    return version_.value();
+  }
+
  private:
   friend inline auto operator<<(std::ostream& os,
                                 const ImageManager& manager) -> std::ostream& {
     return os << manager.album_;
   }
 
+  inline auto clear_indexes() noexcept -> void {
+    id_index_.clear();
+    similar_index_.clear();
+    colour_index_.clear();
+    title_index_.clear();
+    tag_index_.clear();
+    rollup_.clear();
+    snapshot_.reset();
+  }
+
+  inline auto build_indexes() -> void {
+    reindex_from(0);
+    rebuild_similar_index();
+    rebuild_colour_index();
+    for (const auto& image : album_) {
+      title_index_.insert(image.get_title());
+      index_tags(image);
+      rollup_.add(image);
+    }
+  }
+
+  /// \brief Points every index into `snapshot` and renumbers the records to
+  /// match it. Nothing is renumbered if any section is unreadable.
+  inline auto adopt(std::shared_ptr<const snapshot::Snapshot> snapshot)
+      -> void {
+    auto& images{album_.get_images()};
+    const auto ids{
+        snapshot->section<std::uint64_t>(snapshot::Section::Records)};
+    if (ids.size() != images.size()) {
+      throw std::runtime_error{"Snapshot is of another catalog"};
+    }
+    id_index_.load(*snapshot);
+    similar_index_.load(*snapshot);
+    colour_index_.load(*snapshot);
+    title_index_.load(*snapshot);
+    tag_index_.load(*snapshot);
+    rollup_.load(*snapshot);
+
+    for (std::size_t slot{0}; slot < images.size(); ++slot) {
+      images[slot].id_ = ids[slot];
+    }
+    // Later records must not reuse ids the snapshot's catalog handed out.
+    const auto next{snapshot->value<std::uint64_t>(snapshot::Section::NextId)};
+    auto current{ImageRecord::next_id.load()};
+    while (current < next and
+           not ImageRecord::next_id.compare_exchange_weak(current, next)) {
+    }
+    snapshot_ = std::move(snapshot);
+  }
+
+  /// \brief Inserting into the album shifts every later record along a slot,
+  /// so the id index is refreshed from the first slot that moved.
+  inline auto reindex_from(const std::size_t first_slot) -> void {
+    const auto& images{album_.get_images()};
+    for (auto slot{first_slot}; slot < images.size(); ++slot) {
+      if (not images[slot].is_removed()) {
+        id_index_.assign(images[slot].get_id(), slot);
+      }
+    }
+  }
+
+  inline auto index_similar(const ImageRecord& image) -> void {
+    if (const auto hash = image.get_perceptual_hash()) {
+      similar_index_.insert(*hash, image.get_id());
+    }
+  }
+
+  /// \brief `image`'s id as the tag index's 32-bit bitmaps hold it. Ids come
+  /// from a process-wide counter and are never reused, so a long session can
+  /// run past 2^32 of them even with a small catalog; such a record is
+  /// refused rather than aliasing another in the index.
+  /// \throws std::overflow_error if the id does not fit.
+  static inline auto tag_id(const ImageRecord& image) -> tags::TagIndex::Id {
+    if (image.get_id() > std::numeric_limits<tags::TagIndex::Id>::max()) {
+      throw std::overflow_error{"Record id " + std::to_string(image.get_id()) +
+                                " is too large for the tag index"};
+    }
+    return static_cast<tags::TagIndex::Id>(image.get_id());
+  }
+
+  inline auto index_tags(const ImageRecord& image) -> void {
+    const auto id{tag_id(image)};
+    tag_index_.insert(id);
+    tag_index_.tag(id, image.get_genre().tag());
+    for (const auto tag : image.get_tags()) {
+      tag_index_.tag(id, tag);
+    }
+  }
+
+  inline auto unindex_tags(const ImageRecord& image) -> void {
+    const auto id{tag_id(image)};
+    tag_index_.erase(id);
+    tag_index_.untag(id, image.get_genre().tag());
+    for (const auto tag : image.get_tags()) {
+      tag_index_.untag(id, tag);
+    }
+  }
+
+  inline auto index_colour(const ImageRecord& image) -> void {
+    if (const auto& signature = image.get_colour_signature()) {
+      colour_index_.insert(image.get_id(), *signature);
+    }
+  }
+
+  inline auto rebuild_colour_index() -> void {
+    std::vector<colour::VpTree::Item> live;
+    for (const auto& image : album_) {
+      if (const auto& signature = image.get_colour_signature()) {
+        live.emplace_back(image.get_id(), *signature);
+      }
+    }
+    colour_index_.rebuild(std::move(live));
+  }
+
+  /// \brief VP-trees are built whole, so additions wait in a short list and
+  /// stale entries are skipped until either grows past a fraction of the tree.
+  inline auto rebuild_colour_index_if_needed() -> void {
+    if (colour_index_.needs_rebuild()) {
+      rebuild_colour_index();
+    }
+  }
+
+  /// \brief BK-trees cannot delete, so removed and re-hashed records are
+  /// dropped by rebuilding whenever the album is compacted.
+  inline auto rebuild_similar_index() -> void {
+    similar_index_.clear();
+    for (const auto& image : album_) {
+      index_similar(image);
+    }
+  }
+
+  inline auto compact_if_needed() -> void {
+    const auto stored{album_.get_images().size()};
+    if (static_cast<double>(album_.removed_count()) >
+        CompactionThreshold * static_cast<double>(stored)) {
+      compact();
+    }
+  }
+
   ImageAlbum album_;
+  CatalogVersion version_;
+  /// \brief Record id to its slot in `album_.get_images()`.
+  IdIndex id_index_;
+  /// \brief Perceptual hash to record id. May hold stale entries until the
+  /// next compaction.
+  phash::BkTree similar_index_;
+  /// \brief Colour signature to record id. May hold stale entries until the
+  /// next rebuild.
+  colour::SignatureIndex colour_index_;
+  /// \brief Titles and their words, for completion.
+  suggest::PrefixIndex title_index_;
+  /// \brief Tag to the ids of the records carrying it.
+  tags::TagIndex tag_index_;
+  /// \brief Counts by day, month and year and genre.
+  facet::Rollup rollup_;
+  /// \brief The mapped file indexes read from until they next change; shared
+  /// so copies of the manager keep it mapped.
+  std::shared_ptr<const snapshot::Snapshot> snapshot_;
 };
 #undef NO_DISCARD
 
@@ -0,0 +1,29 @@
+#ifndef CSC_IMAGEPROBE_HPP
+#define CSC_IMAGEPROBE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+#include "csc/ImageInfo.hpp"
+#include "csc/ImageRecord.hpp"
+
+namespace csc::probe {
+
+/// \brief Reads the size and channel count of a PNG or JPEG from its header
+/// alone: the IHDR chunk of a PNG, or the first SOF segment of a JPEG (seeking
+/// past any metadata segments before it). Nothing is decoded.
+/// \return Nothing if the file cannot be read or is neither format.
+auto probe_file(const std::filesystem::path& path) noexcept
+    -> std::optional<ImageInfo>;
+
+/// \brief Probes each record's thumbnail on up to `threads` threads (0 picks
+/// one per core) and stores the result with `ImageRecord::set_info`.
+/// \return How many files could be probed.
+auto probe_all(std::span<ImageRecord> images,
+               std::size_t threads = 0) -> std::size_t;
+
+}  // namespace csc::probe
+
+#endif  // CSC_IMAGEPROBE_HPP
@@ -1,11 +1,23 @@
 #ifndef CSC_IMAGERECORD_HPP
 #define CSC_IMAGERECORD_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
+#include <format>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
 #include <ostream>
+#include <span>
 #include <string>
 #include <string_view>
 
+#include "csc/ColourSignature.hpp"
+#include "csc/ImageInfo.hpp"
+#include "csc/Paths.hpp"
+#include "csc/Tags.hpp"
 #include "csc/core.h"
 #include "csc/date.hpp"
 
@@ -13,10 +25,13 @@ namespace csc {
 
 class ImageRecord {
  private:
-  static size_t next_id;
+  static std::atomic<std::size_t> next_id;
 
  public:
   using DateType = date::DateTime;
+  /// \brief Titles and descriptions are allocated through this, so records in
+  /// a `std::pmr` container live in the container's memory resource.
+  using allocator_type = std::pmr::polymorphic_allocator<>;
 
   class Genre {
    private:
@@ -116,6 +131,61 @@ class ImageRecord {
       RETURN_DESCRIPTION();
     }
 
+    static constexpr std::size_t Count{9};
+
+    MAYBE_CONSTEXPR inline auto index() const noexcept -> std::size_t {
+      return static_cast<std::size_t>(tag_);
+    }
+    /// \brief Inverse of `index()`; `index` must be below `Count`.
+    MAYBE_CONSTEXPR inline static auto from_index(std::size_t index) noexcept
+        -> Genre {
+      return Genre(static_cast<Tag>(index));
+    }
+    /// \brief The built-in tag standing for the genre.
+    MAYBE_CONSTEXPR inline auto tag() const noexcept -> tags::TagId {
+      return static_cast<tags::TagId>(tag_);
+    }
+
+    MAYBE_CONSTEXPR inline auto name() const noexcept -> std::string_view {
+      switch (tag_) {
+        case Tag::Astronomy:
+          return "Astronomy";
+        case Tag::Architecture:
+          return "Architecture";
+        case Tag::Sport:
+          return "Sport";
+        case Tag::Landscape:
+          return "Landscape";
+        case Tag::Portrait:
+          return "Portrait";
+        case Tag::Nature:
+          return "Nature";
+        case Tag::Aerial:
+          return "Aerial";
+        case Tag::Food:
+          return "Food";
+        case Tag::Other:
+          return "Other";
+      }
+      return "Other";
+    }
+
+    /// \brief Case-insensitive lookup by `name()`.
+    static inline auto from_name(std::string_view name) noexcept
+        -> std::optional<Genre> {
+      static constexpr auto Lower = [](unsigned char c) {
+        return (c >= 'A' and c <= 'Z') ? static_cast<char>(c - 'A' + 'a')
+                                       : static_cast<char>(c);
+      };
+      for (std::size_t i{0}; i < Count; ++i) {
+        const auto genre{from_index(i)};
+        if (std::ranges::equal(genre.name(), name, {}, Lower, Lower)) {
+          return genre;
+        }
+      }
+      return std::nullopt;
+    }
+
     //  private:
     Tag tag_;
   };
@@ -134,24 +204,72 @@ class ImageRecord {
   // }
 
   auto to_string() const noexcept -> std::string;
+  /// \brief Same text as `to_string`, written to `out` without a temporary.
+  template <std::output_iterator<char> Out>
+  inline auto format_to(Out out) const -> Out {
+    out = std::format_to(
+        out, "Id: {}, Title: {}, Description: {}, Genre: {}, Date taken: ", id_,
+        title_, description_, genre_.to_string());
+    out = date_taken_.format_to(out);
+    if (info_.is_known()) {
+      out = std::format_to(out, ", Size: {}x{} {}", info_.width, info_.height,
+                           info_.format_name());
+    }
+    if (not tags_.empty()) {
+      out = std::format_to(out, ", Tags: {}", tags::format_list(tags_));
+    }
+    return out;
+  }
   explicit inline operator std::string() const noexcept { return to_string(); }
 
-  constexpr inline auto set_title(std::string title) noexcept -> void {
-    title_ = std::move(title);
+  inline auto set_title(std::string_view title) -> void {
+    title_.assign(title);
   }
-  constexpr inline auto set_description(std::string description) noexcept
-      -> void {
-    description_ = std::move(description);
+  inline auto set_description(std::string_view description) -> void {
+    description_.assign(description);
   }
   constexpr inline auto set_genre(Genre genre) noexcept -> void {
     genre_ = genre;
   }
-  constexpr inline auto set_thumbnail_path(
-      std::filesystem::path&& path) noexcept -> void {
-    thumbnail_path_ = std::move(path);
+  inline auto set_tags(tags::TagSet tags) noexcept -> void {
+    tags_ = std::move(tags);
+  }
+  inline auto add_tag(tags::TagId tag) -> bool { return tags_.insert(tag); }
+  inline auto remove_tag(tags::TagId tag) noexcept -> bool {
+    return tags_.erase(tag);
+  }
+  inline auto set_thumbnail_path(const std::filesystem::path& path) -> void {
+    thumbnail_path_ = paths::dictionary().intern(path);
+  }
+  inline auto set_date_taken(DateType date) noexcept -> void {
+    date_taken_ = date;
+  }
+  constexpr inline auto set_perceptual_hash(
+      std::optional<std::uint64_t> hash) noexcept -> void {
+    perceptual_hash_ = hash;
+  }
+  constexpr inline auto set_content_hash(
+      std::optional<std::uint64_t> hash) noexcept -> void {
+    content_hash_ = hash;
+  }
+  constexpr inline auto set_colour_signature(
+      const std::optional<colour::Signature>& signature) noexcept -> void {
+    colour_signature_ = signature;
+  }
+  /// \brief Usually filled in by `probe::probe_file` when the record is added.
+  constexpr inline auto set_info(const ImageInfo& info) noexcept -> void {
+    info_ = info;
   }
 
   constexpr inline auto get_id() const noexcept -> std::size_t { return id_; }
+  /// \brief The most recently handed out record id.
+  static inline auto last_id() noexcept -> std::size_t { return next_id - 1; }
+  /// \brief Numbers `images` in the order given, for records built out of
+  /// order, e.g. on several threads. `first` is what `last_id() + 1` was
+  /// before any of them were built; their own ids are kept as the range if no
+  /// other record took one meanwhile, and a fresh range is taken otherwise.
+  static auto renumber(std::span<ImageRecord> images,
+                       std::size_t first) noexcept -> void;
   constexpr inline auto get_title() const noexcept -> std::string_view {
     return title_;
   }
@@ -159,36 +277,90 @@ class ImageRecord {
     return description_;
   }
   constexpr inline auto get_genre() const noexcept -> Genre { return genre_; }
+  /// \brief The record's own tags; its genre's built-in tag is implied.
+  inline auto get_tags() const noexcept -> const tags::TagSet& {
+    return tags_;
+  }
+  /// \brief Whether the record carries `tag`, counting its genre.
+  inline auto has_tag(tags::TagId tag) const noexcept -> bool {
+    return genre_.tag() == tag or tags_.contains(tag);
+  }
   constexpr inline auto get_date_taken() const noexcept -> DateType {
     return date_taken_;
   }
-  constexpr inline auto get_thumbnail_path() const noexcept
-      -> const std::filesystem::path& {
+  /// \brief Decoded from `paths::dictionary()`; compare
+  /// `get_thumbnail_id` instead wherever an id will do.
+  inline auto get_thumbnail_path() const -> std::filesystem::path {
+    return paths::dictionary().path(thumbnail_path_);
+  }
+  /// \brief Equal for two records exactly when their paths are spelled the
+  /// same.
+  constexpr inline auto get_thumbnail_id() const noexcept -> paths::PathId {
     return thumbnail_path_;
   }
+  constexpr inline auto get_info() const noexcept -> const ImageInfo& {
+    return info_;
+  }
+  /// \brief The `phash::Hash` of the thumbnail, once it has been decoded.
+  constexpr inline auto get_perceptual_hash() const noexcept
+      -> std::optional<std::uint64_t> {
+    return perceptual_hash_;
+  }
+  /// \brief The `content::Hash` of the thumbnail file's bytes, once read.
+  constexpr inline auto get_content_hash() const noexcept
+      -> std::optional<std::uint64_t> {
+    return content_hash_;
+  }
+  constexpr inline auto get_colour_signature() const noexcept
+      -> const std::optional<colour::Signature>& {
+    return colour_signature_;
+  }
+  /// \brief Whether the record has been deleted from its album but not yet
+  /// compacted away.
+  constexpr inline auto is_removed() const noexcept -> bool {
+    return removed_;
+  }
 
-  ImageRecord(std::string title, std::string description, Genre genre,
-              DateType time, std::filesystem::path thumbnail_path);
+  ImageRecord(std::string_view title, std::string_view description,
+              Genre genre, DateType time,
+              const std::filesystem::path& thumbnail_path,
+              allocator_type allocator = {});
 
   ImageRecord(const ImageRecord& other) noexcept = default;
   ImageRecord(ImageRecord&& other) noexcept = default;
+  ImageRecord(const ImageRecord& other, allocator_type allocator);
+  /// \brief Copies the strings unless `allocator` uses the same resource.
+  ImageRecord(ImageRecord&& other, allocator_type allocator);
   auto operator=(const ImageRecord& other) noexcept -> ImageRecord& = default;
   auto operator=(ImageRecord&& other) noexcept -> ImageRecord& = default;
 
+  inline auto get_allocator() const noexcept -> allocator_type {
+    return title_.get_allocator();
+  }
+
  private:
   friend class ImageAlbum;
+  friend class ImageManager;
 
   friend auto operator<<(std::ostream& os,
                          const ImageRecord& image) -> std::ostream&;
 
-  std::string title_;
-  std::string description_;
-  std::filesystem::path thumbnail_path_;
+  std::pmr::string title_;
+  std::pmr::string description_;
+  paths::PathId thumbnail_path_;
   DateType date_taken_;
+  ImageInfo info_;
+  std::optional<std::uint64_t> perceptual_hash_;
+  std::optional<std::uint64_t> content_hash_;
+  std::optional<colour::Signature> colour_signature_;
   std::size_t id_ = next_id++;
   Genre genre_;
+  tags::TagSet tags_;
+  bool removed_{false};
 };
 
+static_assert(ImageRecord::Genre::Count == tags::BuiltinCount);
+
 }  // namespace csc
 
 #endif  // CSC_IMAGERECORD_HPP
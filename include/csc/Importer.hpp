@@ -0,0 +1,75 @@
+#ifndef CSC_IMPORTER_HPP
+#define CSC_IMPORTER_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csc/Exporter.hpp"
+#include "csc/ImageRecord.hpp"
+
+namespace csc {
+
+class ImageManager;
+
+namespace importer {
+
+/// \brief Imports read the same two formats the exporter writes.
+using Format = exporter::Format;
+
+struct ImportError {
+  /// 1-based line in the input the bad row starts on.
+  std::size_t line;
+  std::string message;
+};
+
+struct ParseResult {
+  /// The same type as `ImageAlbum::ImageCollection`, to hand over whole.
+  std::pmr::vector<ImageRecord> records;
+  /// Sorted by line.
+  std::vector<ImportError> errors;
+};
+
+struct ImportReport {
+  std::size_t imported{0};
+  /// Sorted by line.
+  std::vector<ImportError> errors;
+};
+
+/// \brief Parses a whole CSV or JSON Lines document on up to `threads` threads
+/// (0 picks one per core). Malformed rows are reported and skipped.
+///
+/// CSV needs a header row naming the `title`, `description`, `genre`,
+/// `date_taken` and `thumbnail_path` columns, in any order; other columns such
+/// as `id` are ignored. JSON Lines objects need the same keys.
+auto parse(std::string_view text, Format format,
+           std::size_t threads = 0) -> ParseResult;
+
+/// \brief Guesses the format from the extension: `.csv`, or `.jsonl` /
+/// `.ndjson`.
+auto format_for(const std::filesystem::path& path) -> std::optional<Format>;
+
+/// \brief Reads and parses `path` and inspects each record's thumbnail,
+/// leaving the records to the caller.
+/// \throws std::runtime_error if the file cannot be read or its format is
+/// unknown.
+auto read_file(const std::filesystem::path& path,
+               std::optional<Format> format = std::nullopt,
+               std::size_t threads = 0) -> ParseResult;
+
+/// \brief Reads and parses `path`, then adds every good record to `manager`
+/// in one step.
+/// \throws std::runtime_error if the file cannot be read or its format is
+/// unknown.
+auto import_file(ImageManager& manager, const std::filesystem::path& path,
+                 std::optional<Format> format = std::nullopt,
+                 std::size_t threads = 0) -> ImportReport;
+
+}  // namespace importer
+}  // namespace csc
+
+#endif  // CSC_IMPORTER_HPP
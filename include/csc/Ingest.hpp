@@ -0,0 +1,24 @@
+#ifndef CSC_INGEST_HPP
+#define CSC_INGEST_HPP
+
+#include <cstddef>
+#include <span>
+
+#include "csc/ImageRecord.hpp"
+
+namespace csc::ingest {
+
+/// \brief Fills in everything learned from a record's thumbnail: the header
+/// `ImageInfo`, the content hash of its bytes, then, from a single decode, the
+/// perceptual hash and colour signature. Whatever cannot be read is reset, so
+/// a changed path never keeps the old file's values.
+auto inspect(ImageRecord& image) noexcept -> void;
+
+/// \brief `inspect` for each record, on up to `threads` threads (0 picks one
+/// per core). Records whose paths resolve to the same file share one read.
+auto inspect_all(std::span<ImageRecord> images,
+                 std::size_t threads = 0) -> void;
+
+}  // namespace csc::ingest
+
+#endif  // CSC_INGEST_HPP
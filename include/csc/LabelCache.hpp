@@ -0,0 +1,40 @@
+#ifndef CSC_LABELCACHE_HPP
+#define CSC_LABELCACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "csc/ImageRecord.hpp"
+
+namespace csc::frame {
+
+/// \brief Text shown for each record, formatted once rather than every
+/// frame. Dropped whenever the catalog changes, and wholesale once it holds
+/// `Capacity` records, so paging through a large album cannot grow it without
+/// bound.
+class LabelCache {
+ public:
+  static constexpr std::size_t Capacity{1024};
+
+  struct Labels {
+    /// The single view's line under the image.
+    std::string details;
+    /// The grid's hover text.
+    std::string tooltip;
+  };
+
+  /// \brief `version` is the catalog's `ImageManager::version()`.
+  auto get(const ImageRecord& image, std::uint64_t version) -> const Labels&;
+
+ private:
+  static auto format(const ImageRecord& image) -> Labels;
+
+  std::unordered_map<std::size_t, Labels> labels_;
+  std::uint64_t version_{0};
+};
+
+}  // namespace csc::frame
+
+#endif  // CSC_LABELCACHE_HPP
@@ -0,0 +1,129 @@
+#ifndef CSC_LIVESEARCH_HPP
+#define CSC_LIVESEARCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csc {
+
+class ImageManager;
+class ImageRecord;
+
+namespace live {
+
+/// \brief Which text of each record is searched.
+enum class Field : std::uint8_t { Title, Description };
+
+/// \brief Substring filtering that keeps up with typing. Each query is
+/// scanned on a background thread, publishing matches as it goes so the first
+/// ones show while the rest of the catalog is still being read. A query
+/// containing the last completed one only rescans that one's matches. A new
+/// query cancels the one in flight.
+///
+/// The catalog is searched through a copy of the field, so the manager may be
+/// edited while a scan runs. The copy is retaken whenever
+/// `ImageManager::version()` changes, `Chunk` records per `update`, so no
+/// frame pays for the whole catalog; there are no matches until it is done.
+class LiveSearch {
+ public:
+  /// Least time between starting two queries. A key typed after a pause is
+  /// searched at once; a burst of faster keys starts a scan for its first
+  /// key and one when it stops, rather than one per key.
+  static constexpr std::chrono::milliseconds Debounce{8};
+  /// Records scanned between checks for cancellation and publishing, and
+  /// copied into the corpus per `update`.
+  static constexpr std::size_t Chunk{1UZ << 15UZ};
+
+  explicit LiveSearch(Field field) noexcept : field_{field} {}
+  LiveSearch(const LiveSearch&) = delete;
+  auto operator=(const LiveSearch&) -> LiveSearch& = delete;
+  ~LiveSearch();
+
+  /// \brief Call every frame with the text as typed. Starts, restarts or
+  /// cancels the background scan as needed; never waits for it.
+  auto update(const ImageManager& manager, std::string_view text) -> void;
+
+  /// \brief Matches of the newest query found so far, as positions in the
+  /// catalog's date order. Valid until the next `update`.
+  [[nodiscard]] auto matches() const noexcept
+      -> std::span<const std::uint32_t>;
+  /// \brief Whether `matches()` is final for the text last passed to
+  /// `update`. Until then they may be those of an earlier query.
+  [[nodiscard]] auto complete() const noexcept -> bool;
+  /// \brief The record at position `match`, which must come from
+  /// `matches()` since `manager` was last passed to `update`.
+  [[nodiscard]] auto record(const ImageManager& manager,
+                            std::uint32_t match) const noexcept
+      -> const ImageRecord&;
+
+ private:
+  /// \brief The field of every live record, NUL separated in one block so
+  /// whole chunks can be searched at once.
+  struct Corpus {
+    std::string text;
+    /// Where each record's text starts, plus one past the end.
+    std::vector<std::size_t> starts;
+    /// Where each record sits in the album's storage.
+    std::vector<std::size_t> slots;
+    std::uint64_t version{0};
+    /// Slots of the album copied so far.
+    std::size_t copied{0};
+
+    [[nodiscard]] inline auto size() const noexcept -> std::size_t {
+      return slots.size();
+    }
+    [[nodiscard]] inline auto at(std::size_t i) const noexcept
+        -> std::string_view {
+      return std::string_view{text}.substr(starts[i],
+                                           starts[i + 1] - starts[i] - 1);
+    }
+  };
+
+  struct Job {
+    std::string text;
+    std::shared_ptr<const Corpus> corpus;
+    /// The completed job whose matches are refined, or none to scan all.
+    std::shared_ptr<const Job> base;
+    /// Reserved for every candidate up front, so it never reallocates while
+    /// the UI reads the published prefix.
+    std::vector<std::uint32_t> matches;
+    std::atomic<std::size_t> published{0};
+    std::atomic<bool> done{false};
+    std::atomic<bool> cancelled{false};
+  };
+
+  /// \brief Copies the next `Chunk` slots of `manager` into `corpus`.
+  /// \return Whether the corpus is now complete.
+  static auto extend(Corpus& corpus, const ImageManager& manager,
+                     Field field) -> bool;
+  static auto scan(Job& job) -> void;
+
+  auto start(std::string text) -> void;
+  auto cancel() -> void;
+
+  Field field_;
+  std::shared_ptr<const Corpus> corpus_;
+  /// The copy being taken for the current version, until it is complete.
+  std::shared_ptr<Corpus> pending_;
+  /// The newest query, running or finished.
+  std::shared_ptr<Job> job_;
+  std::future<void> running_;
+  /// The newest finished query, the base for refining.
+  std::shared_ptr<const Job> finished_;
+  std::string typed_;
+  std::chrono::steady_clock::time_point typed_at_;
+  std::chrono::steady_clock::time_point started_at_;
+};
+
+}  // namespace live
+}  // namespace csc
+
+#endif  // CSC_LIVESEARCH_HPP
@@ -0,0 +1,227 @@
+#ifndef CSC_METRICS_HPP
+#define CSC_METRICS_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace csc::metrics {
+
+/// Bytes between counters bumped by different threads, so they do not share
+/// a cache line.
+constexpr std::size_t CacheLine{64};
+
+namespace detail {
+/// \brief A small per-thread number, handed out round robin.
+auto next_shard() noexcept -> std::size_t;
+}  // namespace detail
+
+/// \brief A monotonic count split over `Shards` cache lines. Each thread adds
+/// to its own shard, so hot counters do not bounce between cores; reads sum
+/// the shards.
+class Counter {
+ public:
+  static constexpr std::size_t Shards{16};
+
+  inline auto add(std::uint64_t amount = 1) noexcept -> void {
+    thread_local const std::size_t shard{detail::next_shard() % Shards};
+    shards_[shard].value.fetch_add(amount, std::memory_order_relaxed);
+  }
+  [[nodiscard]] auto value() const noexcept -> std::uint64_t;
+
+ private:
+  struct alignas(CacheLine) Shard {
+    std::atomic<std::uint64_t> value{0};
+  };
+  std::array<Shard, Shards> shards_{};
+};
+
+/// \brief A value that can go down as well as up, such as a size.
+class Gauge {
+ public:
+  inline auto set(std::int64_t value) noexcept -> void {
+    value_.store(value, std::memory_order_relaxed);
+  }
+  inline auto add(std::int64_t delta) noexcept -> void {
+    value_.fetch_add(delta, std::memory_order_relaxed);
+  }
+  [[nodiscard]] inline auto value() const noexcept -> std::int64_t {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::int64_t> value_{0};
+};
+
+/// \brief Log-linear latency histogram in the style of HdrHistogram: each
+/// power of two of nanoseconds is split into `SubBuckets` equal buckets, so
+/// any recorded value is known to within 1/16 (6.25%) from 1 ns to 18
+/// minutes, in a fixed array. Recording is a few relaxed atomic adds.
+class Histogram {
+ public:
+  static constexpr unsigned Precision{4};
+  static constexpr std::uint64_t SubBuckets{1U << Precision};
+  /// Values from `2^MaxBits` ns up land in the last bucket.
+  static constexpr unsigned MaxBits{40};
+  static constexpr std::size_t Buckets{(MaxBits - Precision + 1) *
+                                       SubBuckets};
+
+  constexpr static inline auto bucket_of(std::uint64_t nanos) noexcept
+      -> std::size_t {
+    nanos = std::min(nanos, (std::uint64_t{1} << MaxBits) - 1);
+    const auto top{static_cast<unsigned>(std::bit_width(nanos))};
+    if (top <= Precision) {
+      return static_cast<std::size_t>(nanos);
+    }
+    const auto shift{top - 1 - Precision};
+    return ((shift + 1) * SubBuckets) + (nanos >> shift) - SubBuckets;
+  }
+  /// \brief The smallest value that lands in `bucket`.
+  constexpr static inline auto lower_bound(std::size_t bucket) noexcept
+      -> std::uint64_t {
+    if (bucket < 2 * SubBuckets) {
+      return bucket;
+    }
+    const auto shift{(bucket / SubBuckets) - 1};
+    return (SubBuckets + (bucket % SubBuckets)) << shift;
+  }
+
+  inline auto record(std::chrono::nanoseconds elapsed) noexcept -> void {
+    const auto nanos{static_cast<std::uint64_t>(
+        std::max<std::chrono::nanoseconds::rep>(elapsed.count(), 0))};
+    buckets_[bucket_of(nanos)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(nanos, std::memory_order_relaxed);
+  }
+
+  /// \brief A copy of the counts, consistent enough for reporting.
+  struct Snapshot {
+    std::array<std::uint64_t, Buckets> buckets{};
+    std::uint64_t count{0};
+    std::uint64_t sum{0};
+
+    /// \brief Upper bound of the bucket holding the `quantile` sample, in
+    /// nanoseconds; 0 if nothing was recorded.
+    [[nodiscard]] auto quantile(double quantile) const noexcept
+        -> std::uint64_t;
+    /// \brief Samples below `nanos`, exact when it is a power of two.
+    [[nodiscard]] auto count_below(std::uint64_t nanos) const noexcept
+        -> std::uint64_t;
+  };
+  [[nodiscard]] auto snapshot() const noexcept -> Snapshot;
+
+ private:
+  std::array<std::atomic<std::uint64_t>, Buckets> buckets_{};
+  std::atomic<std::uint64_t> sum_{0};
+};
+
+/// \brief Records the time from construction to destruction in a histogram.
+class ScopedLatency {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit inline ScopedLatency(Histogram& histogram) noexcept
+      : histogram_{histogram}, start_{Clock::now()} {}
+  ScopedLatency(const ScopedLatency&) = delete;
+  auto operator=(const ScopedLatency&) -> ScopedLatency& = delete;
+  inline ~ScopedLatency() { histogram_.record(Clock::now() - start_); }
+
+ private:
+  Histogram& histogram_;
+  Clock::time_point start_;
+};
+
+/// \brief Named metrics. Registering allocates and takes a lock, so it is
+/// done once up front; the returned references stay valid for the life of
+/// the registry and recording through them never allocates.
+class Registry {
+ public:
+  /// \brief `labels` is the Prometheus label set without braces, such as
+  /// `kind="title"`; metrics sharing a name differ by it.
+  auto counter(std::string name, std::string help, std::string labels = {})
+      -> Counter&;
+  auto gauge(std::string name, std::string help, std::string labels = {})
+      -> Gauge&;
+  auto histogram(std::string name, std::string help, std::string labels = {})
+      -> Histogram&;
+
+  /// \brief One line per metric; latencies as count, and mean, p50, p90 and
+  /// p99 in microseconds.
+  auto write_text(std::ostream& out) const -> void;
+  /// \brief Prometheus text exposition format, version 0.0.4. Histograms
+  /// are in seconds with power-of-two bucket bounds.
+  auto write_prometheus(std::ostream& out) const -> void;
+  /// \brief Prometheus format if `path` ends in `.prom`, text otherwise.
+  /// \throws std::runtime_error if `path` cannot be written.
+  auto write_file(const std::filesystem::path& path) const -> void;
+
+ private:
+  template <typename Metric>
+  struct Named {
+    std::string name;
+    std::string help;
+    std::string labels;
+    Metric metric;
+  };
+
+  mutable std::mutex mutex_;
+  std::deque<Named<Counter>> counters_;
+  std::deque<Named<Gauge>> gauges_;
+  std::deque<Named<Histogram>> histograms_;
+};
+
+/// \brief The process-wide registry.
+auto global() -> Registry&;
+
+/// \brief The `ImageManager` searches timed separately.
+enum class Search : std::uint8_t {
+  Id,
+  Title,
+  Description,
+  Genre,
+  Date,
+  Size,
+  Orientation,
+  Similar,
+  Colour,
+  Tags,
+};
+
+constexpr std::size_t SearchCount{10};
+
+constexpr inline auto search_name(Search search) noexcept -> std::string_view {
+  constexpr std::array<std::string_view, SearchCount> Names{
+      "id",   "title",       "description", "genre",  "date",
+      "size", "orientation", "similar",     "colour", "tags"};
+  return Names[static_cast<std::size_t>(search)];
+}
+
+/// \brief The library's own metrics, registered in `global()` on first use.
+struct Library {
+  std::array<Histogram*, SearchCount> searches;
+  Counter& inserted;
+  Counter& removed;
+  Counter& updated;
+  Gauge& catalog_size;
+  Gauge& title_index_bytes;
+  Gauge& title_index_bytes_per_title;
+
+  inline auto search(Search search) const noexcept -> Histogram& {
+    return *searches[static_cast<std::size_t>(search)];
+  }
+};
+
+auto library() -> const Library&;
+
+}  // namespace csc::metrics
+
+#endif  // CSC_METRICS_HPP
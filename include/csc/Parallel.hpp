@@ -0,0 +1,123 @@
+#ifndef CSC_PARALLEL_HPP
+#define CSC_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace csc::parallel {
+
+/// \brief `requested`, or one thread per core if it is 0.
+inline auto thread_count(std::size_t requested) noexcept -> std::size_t {
+  if (requested != 0) {
+    return requested;
+  }
+  return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+/// \brief Calls `work(begin, end)` over `[0, count)` in batches of `batch`
+/// items. Up to `threads` workers (0 picks one per core), including the
+/// calling thread, claim the next batch as they finish, so uneven batches
+/// even out.
+template <typename Work>
+  requires(std::invocable<Work&, std::size_t, std::size_t>)
+inline auto for_each_batch(std::size_t count, std::size_t batch,
+                           std::size_t threads, Work&& work) -> void {
+  batch = std::max<std::size_t>(batch, 1);
+  std::atomic<std::size_t> next{0};
+  const auto run = [&] {
+    for (auto begin{next.fetch_add(batch)}; begin < count;
+         begin = next.fetch_add(batch)) {
+      work(begin, std::min(begin + batch, count));
+    }
+  };
+
+  const auto batches{(count + batch - 1) / batch};
+  std::vector<std::future<void>> workers;
+  for (std::size_t i{1}; i < std::min(thread_count(threads), batches); ++i) {
+    workers.push_back(std::async(std::launch::async, run));
+  }
+  run();
+  for (auto& worker : workers) {
+    worker.get();
+  }
+}
+
+/// \brief A fixed set of workers taking tasks from one queue, for work too
+/// frequent to start threads for each time. Tasks already queued still run
+/// when the pool is destroyed.
+class Pool {
+ public:
+  explicit inline Pool(std::size_t workers) {
+    workers_.reserve(workers);
+    for (std::size_t i{0}; i < workers; ++i) {
+      workers_.emplace_back([this](std::stop_token stop) { work(stop); });
+    }
+  }
+
+  Pool(const Pool& other) = delete;
+  Pool(Pool&& other) noexcept = delete;
+  auto operator=(const Pool& other) -> Pool& = delete;
+  auto operator=(Pool&& other) noexcept -> Pool& = delete;
+  ~Pool() = default;
+
+  /// \brief Queues `task` for the next free worker. The pool must have at
+  /// least one.
+  /// \return The task's result, or what it threw.
+  template <typename Task>
+    requires(std::invocable<Task&>)
+  inline auto submit(Task&& task)
+      -> std::future<std::invoke_result_t<Task&>> {
+    std::packaged_task<std::invoke_result_t<Task&>()> packaged{
+        std::forward<Task>(task)};
+    auto result{packaged.get_future()};
+    {
+      const std::lock_guard lock{mutex_};
+      tasks_.emplace(std::move(packaged));
+    }
+    ready_.notify_one();
+    return result;
+  }
+
+  [[nodiscard]] inline auto size() const noexcept -> std::size_t {
+    return workers_.size();
+  }
+
+ private:
+  inline auto work(const std::stop_token& stop) -> void {
+    while (true) {
+      std::move_only_function<void()> task;
+      {
+        std::unique_lock lock{mutex_};
+        ready_.wait(lock, stop, [this] { return not tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;  // Stopping, with nothing left to run.
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable_any ready_;
+  std::queue<std::move_only_function<void()>> tasks_;
+  /// Last, so the workers are stopped and joined before the queue goes.
+  std::vector<std::jthread> workers_;
+};
+
+}  // namespace csc::parallel
+
+#endif  // CSC_PARALLEL_HPP
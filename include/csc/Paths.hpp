@@ -0,0 +1,108 @@
+#ifndef CSC_PATHS_HPP
+#define CSC_PATHS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace csc::paths {
+
+/// \brief Dense path number, handed out in order of first use. Two records
+/// share one exactly when their paths are spelled the same.
+using PathId = std::uint32_t;
+
+/// \brief Paths stored once each, much smaller than a `std::filesystem::path`
+/// per record. Directories are interned a component at a time, so a prefix
+/// such as `Images/` is kept once however many files sit under it, and file
+/// names are front coded in blocks: each keeps only what differs from the
+/// name interned just before it. Paths are matched byte for byte as spelled.
+/// Safe to share between threads.
+class Dictionary {
+ public:
+  /// \return The id of `path`, registering it if it is new.
+  auto intern(const std::filesystem::path& path) -> PathId;
+  [[nodiscard]] auto find(const std::filesystem::path& path) const
+      -> std::optional<PathId>;
+  /// \brief `id` must have come from this dictionary.
+  [[nodiscard]] auto path(PathId id) const -> std::filesystem::path;
+  /// \brief The path as `std::filesystem::path::string` would spell it.
+  [[nodiscard]] auto text(PathId id) const -> std::string;
+  [[nodiscard]] auto size() const -> std::size_t;
+  /// \brief Heap memory held, roughly.
+  [[nodiscard]] auto bytes() const -> std::size_t;
+
+ private:
+  using DirectoryId = std::uint32_t;
+
+  /// \brief A directory is its parent plus one component, separator and all,
+  /// so concatenating the chain gives back the spelling exactly.
+  struct Directory {
+    DirectoryId parent;
+    std::uint32_t component;
+  };
+  struct Slot {
+    PathId id;
+    std::uint32_t hash;
+  };
+  /// \brief Lets `component_ids_` be searched with a `std::string_view`.
+  struct ComponentHash {
+    using is_transparent = void;
+    inline auto operator()(std::string_view text) const noexcept
+        -> std::size_t {
+      return std::hash<std::string_view>{}(text);
+    }
+  };
+
+  /// Names per front-coding block; decoding one reads at most this many.
+  static constexpr std::size_t BlockSize{16};
+  /// The directory of paths with none; it has no component.
+  static constexpr DirectoryId NoDirectory{0};
+  static constexpr PathId Empty{UINT32_MAX};
+  static constexpr std::size_t MinSlots{64};
+
+  [[nodiscard]] auto find_directory(std::string_view text) const
+      -> std::optional<DirectoryId>;
+  auto intern_directory(std::string_view text) -> DirectoryId;
+  [[nodiscard]] auto find(DirectoryId directory, std::string_view name,
+                          std::uint32_t hash) const -> std::optional<PathId>;
+  /// \brief Appends the file name of `id` to `out`.
+  auto append_name(PathId id, std::string& out) const -> void;
+  auto append(DirectoryId directory, std::string_view name,
+              std::uint32_t hash) -> PathId;
+  auto grow() -> void;
+
+  mutable std::shared_mutex mutex_;
+  /// Indexed by component id.
+  std::vector<std::string> components_;
+  std::unordered_map<std::string, std::uint32_t, ComponentHash,
+                     std::equal_to<>>
+      component_ids_;
+  /// Indexed by `DirectoryId`; the first is `NoDirectory`.
+  std::vector<Directory> directories_{Directory{}};
+  /// `(parent << 32) | component` to the directory.
+  std::unordered_map<std::uint64_t, DirectoryId> directory_ids_;
+  /// Indexed by `PathId`.
+  std::vector<DirectoryId> directory_of_;
+  /// Per name: shared prefix length and suffix length as varints, then the
+  /// suffix. The first name of each block shares nothing.
+  std::string names_;
+  /// Where each block starts in `names_`.
+  std::vector<std::size_t> blocks_;
+  std::string last_name_;
+  /// Open addressed by a hash of directory and name, at most half full.
+  std::vector<Slot> slots_;
+};
+
+/// \brief The process-wide dictionary every record's thumbnail path is in.
+auto dictionary() -> Dictionary&;
+
+}  // namespace csc::paths
+
+#endif  // CSC_PATHS_HPP
@@ -0,0 +1,114 @@
+#ifndef CSC_PERCEPTUALHASH_HPP
+#define CSC_PERCEPTUALHASH_HPP
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "csc/Snapshot.hpp"
+
+namespace csc::phash {
+
+/// \brief 64-bit difference hash (dHash): one bit per horizontally adjacent
+/// pair of cells in a 9x8 grayscale thumbnail. Re-encodes, resizes and small
+/// edits of a picture land within a few bits of each other.
+using Hash = std::uint64_t;
+
+/// Distance at or below which two hashes are treated as the same picture.
+constexpr unsigned DefaultMaxDistance{6};
+
+constexpr inline auto distance(Hash a, Hash b) noexcept -> unsigned {
+  return static_cast<unsigned>(std::popcount(a ^ b));
+}
+
+/// \brief Hashes an 8-bit grayscale image of `width` by `height` pixels,
+/// stored row by row.
+auto hash_pixels(std::span<const unsigned char> gray, std::size_t width,
+                 std::size_t height) noexcept -> Hash;
+
+/// \brief Decodes `path` to grayscale and hashes it.
+/// \return Nothing if the file cannot be decoded.
+auto hash_file(const std::filesystem::path& path) noexcept
+    -> std::optional<Hash>;
+
+/// \brief Burkhard-Keller tree over Hamming distance. Range queries visit only
+/// the subtrees the triangle inequality cannot rule out.
+class BkTree {
+ public:
+  using Id = std::size_t;
+
+  auto insert(Hash hash, Id id) -> void;
+
+  /// \brief Calls `visit(id, distance)` for every entry within
+  /// `max_distance` of `hash`.
+  template <typename Visit>
+    requires(std::invocable<Visit, Id, unsigned>)
+  inline auto for_each_within(Hash hash, unsigned max_distance,
+                              Visit&& visit) const -> void {
+    if (nodes_.empty()) {
+      return;
+    }
+    std::vector<std::uint32_t> pending{0};
+    while (not pending.empty()) {
+      const auto& node{nodes_[pending.back()]};
+      pending.pop_back();
+
+      const auto d{distance(hash, node.hash)};
+      if (d <= max_distance) {
+        visit(node.id, d);
+      }
+      for (auto child{node.first_child}; child != None;
+           child = nodes_[child].next_sibling) {
+        const unsigned edge{nodes_[child].edge};
+        if (edge + max_distance >= d and edge <= d + max_distance) {
+          pending.push_back(child);
+        }
+      }
+    }
+  }
+
+  inline auto reserve(std::size_t count) -> void {
+    nodes_.owned().reserve(count);
+  }
+  inline auto clear() noexcept -> void { nodes_.clear(); }
+  inline auto size() const noexcept -> std::size_t { return nodes_.size(); }
+
+  auto save(snapshot::Writer& writer) const -> void;
+  /// \brief Reads the nodes in place from `snapshot` until the next insert.
+  auto load(const snapshot::Snapshot& snapshot) -> void;
+
+ private:
+  static constexpr std::uint32_t None{UINT32_MAX};
+
+  /// Children hang off a sibling list rather than a 65-slot table, which
+  /// keeps a node at 32 bytes for catalogs of millions of hashes.
+  struct Node {
+    Hash hash;
+    Id id;
+    std::uint32_t first_child{None};
+    std::uint32_t next_sibling{None};
+    /// Distance to the parent.
+    std::uint8_t edge{0};
+  };
+
+  snapshot::Mappable<Node> nodes_;
+};
+
+/// \brief Groups `images` (id and hash pairs) into clusters whose members are
+/// linked by chains of hashes at most `max_distance` apart. Queries run on up
+/// to `threads` threads (0 picks one per core).
+/// \return Clusters of two or more ids, each sorted, ordered by first id.
+auto find_clusters(std::span<const std::pair<std::size_t, Hash>> images,
+                   unsigned max_distance = DefaultMaxDistance,
+                   std::size_t threads = 0)
+    -> std::vector<std::vector<std::size_t>>;
+
+}  // namespace csc::phash
+
+#endif  // CSC_PERCEPTUALHASH_HPP
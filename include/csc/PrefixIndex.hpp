@@ -0,0 +1,129 @@
+#ifndef CSC_PREFIXINDEX_HPP
+#define CSC_PREFIXINDEX_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "csc/Snapshot.hpp"
+
+namespace csc::suggest {
+
+/// Completions kept at every trie node, and so the most one lookup returns.
+constexpr std::size_t MaxSuggestions{8};
+
+struct Suggestion {
+  /// As first spelled; valid until the index next changes.
+  std::string_view text;
+  /// Records with this title or word.
+  std::uint32_t count;
+};
+
+/// \brief Path-compressed trie over titles and the words in them, matched
+/// without regard to ASCII case. Every node keeps the most used keys below it,
+/// so completing a prefix walks the prefix and reads one list: O(prefix + n),
+/// however many titles share it. Adding or removing a title refreshes only the
+/// lists on the paths of its keys.
+class PrefixIndex {
+ public:
+  /// \brief Counts `title` and each distinct word of two or more characters
+  /// in it once.
+  auto insert(std::string_view title) -> void;
+  /// \brief Uncounts a title previously inserted.
+  auto erase(std::string_view title) -> void;
+  auto clear() noexcept -> void;
+
+  /// \return Up to `n` (at most `MaxSuggestions`) titles and words starting
+  /// with `prefix`, most used first.
+  [[nodiscard]] auto complete(std::string_view prefix,
+                              std::size_t n = MaxSuggestions) const
+      -> std::vector<Suggestion>;
+
+  /// \brief Distinct titles with at least one record.
+  [[nodiscard]] inline auto titles() const noexcept -> std::size_t {
+    return titles_;
+  }
+  /// \brief Heap and inline memory held by the index.
+  [[nodiscard]] auto bytes() const noexcept -> std::size_t;
+
+  auto save(snapshot::Writer& writer) const -> void;
+  /// \brief Reads the trie in place from `snapshot` until the next change.
+  auto load(const snapshot::Snapshot& snapshot) -> void;
+
+ private:
+  static constexpr std::uint32_t None{UINT32_MAX};
+
+  /// Flat, like `Node`, so a snapshot maps both back in place.
+  struct Key {
+    /// As first spelled: a range of `spelled_`.
+    std::uint32_t text{0};
+    std::uint32_t length{0};
+    /// Records using the key as their title or one of its words.
+    std::uint32_t count{0};
+    /// Records using it as their whole title.
+    std::uint32_t titles{0};
+  };
+
+  /// Children hang off a sibling list, as in `phash::BkTree`. Edge labels are
+  /// ranges of `folded_`, which a split divides without copying.
+  struct Node {
+    std::uint32_t label{0};
+    std::uint32_t length{0};
+    std::uint32_t first_child{None};
+    std::uint32_t next_sibling{None};
+    std::uint32_t key{None};
+    /// The label's first byte, so scanning siblings stays within `nodes_`.
+    char first{'\0'};
+    /// Keys of the subtree with the highest counts, best first.
+    std::array<std::uint32_t, MaxSuggestions> best{filled()};
+  };
+
+  static constexpr auto filled() noexcept
+      -> std::array<std::uint32_t, MaxSuggestions> {
+    std::array<std::uint32_t, MaxSuggestions> best{};
+    best.fill(None);
+    return best;
+  }
+
+  /// \brief Adds `delta` to the counts of `key`, creating its path if need
+  /// be, and refreshes the lists along it. Uncounting a key that has no
+  /// records does nothing.
+  auto count(std::string_view key, bool title, int delta) -> void;
+  /// \brief The nodes from the root to where `folded` ends, made on demand.
+  auto path_to(std::string_view folded) -> std::vector<std::uint32_t>;
+  /// \brief The nodes from the root to the one where `folded` ends, or none
+  /// if no node ends there. Creates nothing, so erasing cannot grow the trie.
+  [[nodiscard]] auto find_path(std::string_view folded) const
+      -> std::vector<std::uint32_t>;
+  /// \brief Moves `key`, whose count has grown, up the list of `node`.
+  auto promote(std::uint32_t node, std::uint32_t key) -> void;
+  /// \brief Rebuilds the list of `node` from its own key and its children's.
+  auto refresh(std::uint32_t node) -> void;
+  [[nodiscard]] auto ranks_before(std::uint32_t a,
+                                  std::uint32_t b) const noexcept -> bool;
+  [[nodiscard]] inline auto label(const Node& node) const noexcept
+      -> std::string_view {
+    return {folded_.data() + node.label, node.length};
+  }
+  [[nodiscard]] inline auto text(const Key& key) const noexcept
+      -> std::string_view {
+    return {spelled_.data() + key.text, key.length};
+  }
+
+  snapshot::Mappable<Node> nodes_{Node{}};
+  snapshot::Mappable<Key> keys_;
+  /// Every key ever added, folded to lower case, back to back.
+  snapshot::Mappable<char> folded_;
+  /// Each key's spelling, appended again if it is re-spelled after its count
+  /// fell to zero.
+  snapshot::Mappable<char> spelled_;
+  std::size_t titles_{0};
+  /// Candidates while refreshing a node, kept to save an allocation each.
+  std::vector<std::uint32_t> scratch_;
+};
+
+}  // namespace csc::suggest
+
+#endif  // CSC_PREFIXINDEX_HPP
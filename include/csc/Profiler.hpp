@@ -0,0 +1,137 @@
+#ifndef CSC_PROFILER_HPP
+#define CSC_PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace csc::profile {
+
+/// \brief The parts of a frame timed separately.
+enum class Stage : std::uint8_t {
+  /// Decoding image files, usually on background threads.
+  Decode,
+  /// Copying pixels to GL textures.
+  Upload,
+  /// `ImageManager` queries.
+  Search,
+  /// Building the ImGui frame.
+  Layout,
+  /// Turning it into GL draw calls.
+  Render,
+};
+
+constexpr std::size_t StageCount{5};
+
+constexpr inline auto stage_name(Stage stage) noexcept -> std::string_view {
+  constexpr std::array<std::string_view, StageCount> Names{
+      "Decode", "Upload", "Search", "Layout", "Render"};
+  return Names[static_cast<std::size_t>(stage)];
+}
+
+/// \brief Milliseconds at the 50th and 99th percentiles and on average.
+struct Percentiles {
+  double p50{0};
+  double p99{0};
+  double mean{0};
+};
+
+/// \brief Per-frame stage times over the last `Frames` frames, in a ring.
+/// Timers on any thread add to the current frame with a relaxed atomic add,
+/// and the frame owner closes each frame with `end_frame`; neither ever
+/// locks. While disabled, timers read a single flag and skip the clock.
+class Profiler {
+ public:
+  static constexpr std::size_t Frames{240};
+
+  /// \brief Switching on starts from an empty ring, so frames from before
+  /// the profiler was last switched off are not counted. Only the thread
+  /// that runs frames calls this.
+  inline auto enable(bool on) noexcept -> void {
+    if (on and not enabled()) {
+      reset();
+    }
+    enabled_.store(on, std::memory_order_relaxed);
+  }
+  [[nodiscard]] inline auto enabled() const noexcept -> bool {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /// \brief Adds `elapsed` to `stage` of the current frame. Any thread.
+  inline auto add(Stage stage, std::chrono::nanoseconds elapsed) noexcept
+      -> void {
+    const auto slot{current_.load(std::memory_order_acquire)};
+    ring_[slot].stages[static_cast<std::size_t>(stage)].fetch_add(
+        static_cast<std::uint64_t>(elapsed.count()),
+        std::memory_order_relaxed);
+  }
+
+  /// \brief Records the whole frame's time and starts the next. Only the
+  /// thread that runs frames calls this. Work still running on other threads
+  /// may land in either frame.
+  auto end_frame(std::chrono::nanoseconds frame) noexcept -> void;
+
+  /// \brief Frame times in milliseconds, oldest first, into the front of
+  /// `out`. \return How many were written.
+  auto frame_times(std::span<float> out) const noexcept -> std::size_t;
+  [[nodiscard]] auto frame_percentiles() const -> Percentiles;
+  [[nodiscard]] auto stage_percentiles(Stage stage) const -> Percentiles;
+
+ private:
+  struct Frame {
+    std::atomic<std::uint64_t> total{0};
+    std::array<std::atomic<std::uint64_t>, StageCount> stages{};
+  };
+
+  /// \brief Forgets every frame and empties the current one.
+  auto reset() noexcept -> void;
+
+  /// \brief Nanoseconds of `field` for each completed frame, oldest first.
+  template <typename Field>
+  auto completed(Field&& field) const -> std::array<std::uint64_t, Frames>;
+
+  std::array<Frame, Frames> ring_{};
+  std::atomic<std::size_t> current_{0};
+  /// Frames closed so far, capped at `Frames - 1` (the current slot is
+  /// always open).
+  std::size_t completed_{0};
+  std::atomic<bool> enabled_{false};
+};
+
+/// \brief The process-wide profiler the GUI reports into.
+auto global() noexcept -> Profiler&;
+
+/// \brief Adds the time from construction to destruction to `stage`, if the
+/// profiler was enabled at construction.
+class ScopedTimer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit inline ScopedTimer(Stage stage,
+                              Profiler& profiler = global()) noexcept
+      : profiler_{profiler.enabled() ? &profiler : nullptr}, stage_{stage} {
+    if (profiler_ != nullptr) {
+      start_ = Clock::now();
+    }
+  }
+  ScopedTimer(const ScopedTimer&) = delete;
+  auto operator=(const ScopedTimer&) -> ScopedTimer& = delete;
+  inline ~ScopedTimer() {
+    if (profiler_ != nullptr) {
+      profiler_->add(stage_, Clock::now() - start_);
+    }
+  }
+
+ private:
+  Profiler* profiler_;
+  Stage stage_;
+  Clock::time_point start_;
+};
+
+}  // namespace csc::profile
+
+#endif  // CSC_PROFILER_HPP
@@ -0,0 +1,130 @@
+#ifndef CSC_QUERYCACHE_HPP
+#define CSC_QUERYCACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+
+#include "csc/ColourSignature.hpp"
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageInfo.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/PerceptualHash.hpp"
+#include "csc/Tags.hpp"
+#include "csc/date.hpp"
+
+namespace csc {
+
+class ImageManager;
+
+namespace query {
+
+/// \brief The `ImageManager` searches that return albums, with their
+/// arguments.
+struct Title {
+  std::string text;
+};
+struct Description {
+  std::string text;
+};
+struct Genre {
+  ImageRecord::Genre genre;
+};
+struct Dates {
+  date::DateTime from;
+  date::DateTime to;
+};
+struct MinSize {
+  std::uint32_t width;
+  std::uint32_t height;
+};
+struct Orientation {
+  ImageInfo::Orientation orientation;
+};
+struct Similar {
+  phash::Hash hash;
+  unsigned max_distance{phash::DefaultMaxDistance};
+};
+struct Colour {
+  colour::Signature signature;
+  std::size_t k;
+};
+struct Tags {
+  tags::Query query;
+};
+
+using Query = std::variant<Title, Description, Genre, Dates, MinSize,
+                           Orientation, Similar, Colour, Tags>;
+
+/// \brief Results are shared, never copied, between everyone asking the
+/// same question of the same catalog version.
+using Result = std::shared_ptr<const ImageAlbum>;
+
+/// \brief A byte string equal for queries that must give the same results,
+/// such as date ranges that are both empty.
+auto key(const Query& query) -> std::string;
+
+/// \brief Runs `query` on `manager`, uncached, with the results and any
+/// scratch space allocated from `resource`.
+auto run(const ImageManager& manager, const Query& query,
+         std::pmr::memory_resource* resource =
+             std::pmr::get_default_resource()) -> ImageAlbum;
+
+/// \brief Rough heap footprint of `album`, for cache budgets.
+auto approximate_bytes(const ImageAlbum& album) noexcept -> std::size_t;
+
+/// \brief Search results by query key, least recently used evicted past a
+/// byte budget. Each entry remembers the `ImageManager::version()` it was
+/// computed at and is recomputed once the catalog has moved on. Thread safe;
+/// searches run outside the lock.
+class ResultCache {
+ public:
+  static constexpr std::size_t DefaultBudget{64UZ * 1024UZ * 1024UZ};
+
+  explicit ResultCache(std::size_t budget = DefaultBudget) noexcept
+      : budget_{budget} {}
+  ResultCache(const ResultCache&) = delete;
+  auto operator=(const ResultCache&) -> ResultCache& = delete;
+  ~ResultCache();
+
+  auto search(const ImageManager& manager, const Query& query) -> Result;
+  auto clear() -> void;
+
+  [[nodiscard]] auto hits() const -> std::uint64_t;
+  [[nodiscard]] auto misses() const -> std::uint64_t;
+  [[nodiscard]] auto bytes() const -> std::size_t;
+  [[nodiscard]] auto size() const -> std::size_t;
+
+ private:
+  struct Entry {
+    std::string key;
+    Result result;
+    std::uint64_t version;
+    std::size_t bytes;
+  };
+  using Entries = std::list<Entry>;
+
+  /// \brief Drops `entry`. The lock must be held.
+  auto erase(Entries::iterator entry) -> void;
+
+  mutable std::mutex mutex_;
+  /// Most recently used first.
+  Entries entries_;
+  std::unordered_map<std::string_view, Entries::iterator> index_;
+  std::size_t budget_;
+  std::size_t bytes_{0};
+  std::uint64_t hits_{0};
+  std::uint64_t misses_{0};
+};
+
+}  // namespace query
+}  // namespace csc
+
+#endif  // CSC_QUERYCACHE_HPP
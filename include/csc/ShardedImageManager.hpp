@@ -0,0 +1,401 @@
+#ifndef CSC_SHARDEDIMAGEMANAGER_HPP
+#define CSC_SHARDEDIMAGEMANAGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <shared_mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "csc/ColourSignature.hpp"
+#include "csc/Facets.hpp"
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageInfo.hpp"
+#include "csc/ImageManager.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/Parallel.hpp"
+#include "csc/PerceptualHash.hpp"
+#include "csc/date.hpp"
+
+namespace csc {
+
+#define NO_DISCARD [[nodiscard]]
+/// \brief Partitions records across independent `ImageManager` shards by id.
+///
+/// Writes lock only the shard that owns the record, and every search runs on
+/// all shards in parallel, on the calling thread and a pool of one worker per
+/// other shard, before the date ordered partial results are merged.
+class ShardedImageManager {
+ public:
+  /// Below this many records a fan-out costs more than it saves.
+  static constexpr std::size_t ParallelThreshold{4096};
+
+  explicit inline ShardedImageManager(
+      std::size_t shard_count = default_shard_count())
+      : shard_count_{std::max<std::size_t>(shard_count, 1)},
+        shards_{std::make_unique<Shard[]>(shard_count_)},
+        pool_{shard_count_ - 1} {}
+
+  // Not movable either: a moved-from manager would have no shards to route
+  // ids to.
+  ShardedImageManager(const ShardedImageManager& other) = delete;
+  ShardedImageManager(ShardedImageManager&& other) noexcept = delete;
+  auto operator=(const ShardedImageManager& other)
+      -> ShardedImageManager& = delete;
+  auto operator=(ShardedImageManager&& other) noexcept
+      -> ShardedImageManager& = delete;
+
+  static inline auto default_shard_count() noexcept -> std::size_t {
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  inline auto add_image(ImageRecord&& image) -> void {
+    auto& shard{shard_for(image.get_id())};
+    const std::unique_lock lock{shard.mutex_};
+    shard.manager_.add_image(std::move(image));
+    shard.recount();
+  }
+  template <typename... Args>
+  inline auto add_image(Args&&... args) -> void {
+    add_image(ImageRecord{std::forward<Args>(args)...});
+  }
+
+  inline auto remove_image(const std::size_t id) -> bool {
+    auto& shard{shard_for(id)};
+    const std::unique_lock lock{shard.mutex_};
+    const auto removed{shard.manager_.remove_image(id)};
+    shard.recount();
+    return removed;
+  }
+
+  template <typename Edit>
+    requires(std::invocable<Edit, ImageRecord&>)
+  inline auto update_image(const std::size_t id, Edit&& edit) -> bool {
+    auto& shard{shard_for(id)};
+    const std::unique_lock lock{shard.mutex_};
+    return shard.manager_.update_image(id, std::forward<Edit>(edit));
+  }
+
+  /// \brief Compacts one shard at a time, so searches only ever wait on the
+  /// shard being compacted.
+  inline auto compact() -> void {
+    for (std::size_t i{0}; i < shard_count_; ++i) {
+      const std::unique_lock lock{shards_[i].mutex_};
+      shards_[i].manager_.compact();
+    }
+  }
+
+  NO_DISCARD inline auto search_id(const std::size_t id) const
+      -> std::optional<ImageRecord> {
+    const auto& shard{shard_for(id)};
+    const std::shared_lock lock{shard.mutex_};
+    if (auto image = shard.manager_.search_id(id)) {
+      return **image;
+    }
+    return std::nullopt;
+  }
+
+  NO_DISCARD inline auto search_title(const std::string_view title) const
+      -> ImageAlbum {
+    return fan_out([title](const ImageManager& manager) {
+      return manager.search_title(title);
+    });
+  }
+  NO_DISCARD inline auto search_description(
+      const std::string_view description) const -> ImageAlbum {
+    return fan_out([description](const ImageManager& manager) {
+      return manager.search_description(description);
+    });
+  }
+
+  NO_DISCARD inline auto search_genre(const ImageRecord::Genre& genre) const
+      -> ImageAlbum {
+    return fan_out([genre](const ImageManager& manager) {
+      return manager.search_genre(genre);
+    });
+  }
+
+  NO_DISCARD inline auto search_tags(const tags::Query& query) const
+      -> ImageAlbum {
+    return fan_out([&query](const ImageManager& manager) {
+      return manager.search_tags(query);
+    });
+  }
+  NO_DISCARD inline auto search_tags(const std::string_view query) const
+      -> ImageAlbum {
+    return search_tags(tags::parse_query(query));
+  }
+
+  NO_DISCARD inline auto search_between_dates(
+      const date::DateTime& start, const date::DateTime& end) const
+      -> ImageAlbum {
+    return fan_out([&start, &end](const ImageManager& manager) {
+      return manager.search_between_dates(start, end);
+    });
+  }
+
+  NO_DISCARD inline auto search_min_size(const std::uint32_t width,
+                                         const std::uint32_t height) const
+      -> ImageAlbum {
+    return fan_out([width, height](const ImageManager& manager) {
+      return manager.search_min_size(width, height);
+    });
+  }
+
+  NO_DISCARD inline auto search_orientation(
+      const ImageInfo::Orientation orientation) const -> ImageAlbum {
+    return fan_out([orientation](const ImageManager& manager) {
+      return manager.search_orientation(orientation);
+    });
+  }
+
+  NO_DISCARD inline auto search_similar(
+      const phash::Hash hash,
+      const unsigned max_distance = phash::DefaultMaxDistance) const
+      -> ImageAlbum {
+    return fan_out([hash, max_distance](const ImageManager& manager) {
+      return manager.search_similar(hash, max_distance);
+    });
+  }
+
+  /// \brief The `k` nearest colours over every shard, in date order. Each
+  /// shard offers its own `k` best; the global best are among them.
+  NO_DISCARD inline auto search_colour(const colour::Signature& signature,
+                                       const std::size_t k) const
+      -> ImageAlbum {
+    std::vector<std::pair<unsigned, ImageRecord>> candidates;
+    for (const auto& shard : shards()) {
+      const std::shared_lock lock{shard.mutex_};
+      for (const auto& match :
+           shard.manager_.nearest_colours(signature, k)) {
+        candidates.emplace_back(match.distance,
+                                **shard.manager_.search_id(match.id));
+      }
+    }
+    if (candidates.size() > k) {
+      const auto cut{candidates.begin() + static_cast<std::ptrdiff_t>(k)};
+      std::ranges::nth_element(candidates, cut, {},
+                               [](const auto& c) { return c.first; });
+      candidates.erase(cut, candidates.end());
+    }
+
+    ImageAlbum::ImageCollection images;
+    images.reserve(candidates.size());
+    for (auto& [distance, image] : candidates) {
+      images.push_back(std::move(image));
+    }
+    std::ranges::stable_sort(images, std::less{});
+    return ImageAlbum{std::move(images)};
+  }
+
+  /// \brief Clusters across every shard, since duplicates rarely share one.
+  NO_DISCARD inline auto duplicate_clusters(
+      const unsigned max_distance = phash::DefaultMaxDistance,
+      const std::size_t threads = 0) const
+      -> std::vector<std::vector<std::size_t>> {
+    std::vector<std::pair<std::size_t, phash::Hash>> hashes;
+    for (const auto& shard : shards()) {
+      const std::shared_lock lock{shard.mutex_};
+      std::ranges::move(shard.manager_.perceptual_hashes(),
+                        std::back_inserter(hashes));
+    }
+    return phash::find_clusters(hashes, max_distance, threads);
+  }
+
+  template <typename Predicate>
+    requires(std::predicate<Predicate, const ImageRecord&>)
+  NO_DISCARD inline auto search_if(Predicate&& predicate) const
+      -> ImageAlbum {
+    return fan_out([&predicate](const ImageManager& manager) {
+      return manager.search_if(predicate);
+    });
+  }
+
+  /// \brief Each shard's rollups, summed: O(shards x buckets).
+  NO_DISCARD inline auto facets(const facet::Period period) const
+      -> facet::Facets {
+    facet::Facets total{.period = period};
+    for (const auto& shard : shards()) {
+      const std::shared_lock lock{shard.mutex_};
+      facet::merge(total, shard.manager_.facets(period));
+    }
+    return total;
+  }
+
+  /// \brief A date ordered snapshot of every shard's live records.
+  NO_DISCARD inline auto get_all_images() const -> ImageAlbum {
+    return fan_out([](const ImageManager& manager) {
+      const auto& album{manager.get_all_images()};
+      return ImageAlbum{
+          ImageAlbum::ImageCollection(album.begin(), album.end())};
+    });
+  }
+
+  NO_DISCARD inline auto size() const -> std::size_t {
+    std::size_t total{0};
+    for (const auto& shard : shards()) {
+      const std::shared_lock lock{shard.mutex_};
+      total += shard.manager_.size();
+    }
+    return total;
+  }
+  NO_DISCARD inline auto is_empty() const -> bool { return size() == 0; }
+
+  NO_DISCARD constexpr inline auto shard_count() const noexcept
+      -> std::size_t {
+    return shard_count_;
+  }
+
+ private:
+  struct Shard {
+    /// \brief Call after each write, under the lock.
+    inline auto recount() noexcept -> void {
+      size_.store(manager_.size(), std::memory_order_relaxed);
+    }
+
+    mutable std::shared_mutex mutex_;
+    ImageManager manager_;
+    /// `manager_.size()`, readable without the lock.
+    std::atomic<std::size_t> size_{0};
+  };
+
+  /// splitmix64 finaliser, so sequential ids spread evenly over the shards.
+  static constexpr inline auto mix(std::uint64_t x) noexcept -> std::uint64_t {
+    x ^= x >> 30U;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27U;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31U;
+    return x;
+  }
+
+  inline auto shard_for(const std::size_t id) noexcept -> Shard& {
+    return shards_[mix(id) % shard_count_];
+  }
+  inline auto shard_for(const std::size_t id) const noexcept -> const Shard& {
+    return shards_[mix(id) % shard_count_];
+  }
+
+  inline auto shards() const noexcept -> std::span<const Shard> {
+    return {shards_.get(), shard_count_};
+  }
+
+  /// \brief `size()` without taking any lock, possibly missing writes in
+  /// flight; enough to choose between a serial and a parallel search.
+  inline auto approximate_size() const noexcept -> std::size_t {
+    std::size_t total{0};
+    for (const auto& shard : shards()) {
+      total += shard.size_.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  template <typename Search>
+  inline auto fan_out(Search&& search) const -> ImageAlbum {
+    const auto run = [&search](const Shard& shard) {
+      const std::shared_lock lock{shard.mutex_};
+      return std::invoke(search, shard.manager_);
+    };
+
+    std::vector<ImageAlbum> partials;
+    partials.reserve(shard_count_);
+
+    if (shard_count_ == 1 or approximate_size() < ParallelThreshold) {
+      for (const auto& shard : shards()) {
+        partials.push_back(run(shard));
+      }
+    } else {
+      std::vector<std::future<ImageAlbum>> pending;
+      pending.reserve(shard_count_ - 1);
+      for (const auto& shard : shards().subspan(1)) {
+        pending.push_back(pool_.submit([&run, &shard] { return run(shard); }));
+      }
+      // The tasks borrow `run`, so all of them finish before this returns,
+      // even if the calling thread's shard throws.
+      std::exception_ptr failed;
+      try {
+        partials.push_back(run(shards().front()));
+      } catch (...) {
+        failed = std::current_exception();
+      }
+      for (auto& future : pending) {
+        future.wait();
+      }
+      if (failed) {
+        std::rethrow_exception(failed);
+      }
+      for (auto& future : pending) {
+        partials.push_back(future.get());
+      }
+    }
+
+    return merge(partials);
+  }
+
+  /// \brief k-way merge of date ordered albums into one date ordered album.
+  static inline auto merge(std::vector<ImageAlbum>& partials) -> ImageAlbum {
+    using Iterator = ImageAlbum::ImageCollection::iterator;
+    using Cursor = std::pair<Iterator, Iterator>;
+
+    std::size_t total{0};
+    std::vector<Cursor> heap;
+    heap.reserve(partials.size());
+    for (auto& partial : partials) {
+      auto& images{partial.get_images()};
+      total += images.size();
+      if (not images.empty()) {
+        heap.emplace_back(images.begin(), images.end());
+      }
+    }
+
+    // std::*_heap keep the greatest element at the front, so invert.
+    const auto later = [](const Cursor& a, const Cursor& b) {
+      return *b.first < *a.first;
+    };
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    ImageAlbum::ImageCollection merged;
+    merged.reserve(total);
+    while (not heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), later);
+      auto& [it, end] = heap.back();
+      merged.push_back(std::move(*it));
+      if (++it == end) {
+        heap.pop_back();
+      } else {
+        std::push_heap(heap.begin(), heap.end(), later);
+      }
+    }
+    return ImageAlbum{std::move(merged)};
+  }
+
+  friend inline auto operator<<(std::ostream& os,
+                                const ShardedImageManager& manager)
+      -> std::ostream& {
+    return os << manager.get_all_images();
+  }
+
+  std::size_t shard_count_;
+  std::unique_ptr<Shard[]> shards_;
+  /// Runs every shard but the first during a parallel search.
+  mutable parallel::Pool pool_;
+};
+#undef NO_DISCARD
+
+}  // namespace csc
+
+#endif  // CSC_SHARDEDIMAGEMANAGER_HPP
@@ -0,0 +1,109 @@
+#ifndef CSC_SHELFPACKER_HPP
+#define CSC_SHELFPACKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace csc::atlas {
+
+/// \brief Where an entry sits: a rectangle on one of the square pages.
+struct Rect {
+  std::uint32_t page;
+  std::uint32_t x;
+  std::uint32_t y;
+  std::uint32_t width;
+  std::uint32_t height;
+
+  constexpr auto operator==(const Rect& other) const -> bool = default;
+};
+
+/// \brief Shelf allocator for packing many small images into a few large
+/// square pages. Each page is cut into horizontal shelves; an entry goes on
+/// the lowest shelf that is tall enough without wasting more than a quarter
+/// of it, or opens a new one. Knows nothing about pixels, so the caller moves
+/// them when `compact` reports new places.
+class ShelfPacker {
+ public:
+  using Handle = std::uint32_t;
+
+  /// \brief An entry's place before and after `compact`.
+  struct Move {
+    Handle handle;
+    Rect from;
+    Rect to;
+  };
+
+  ShelfPacker(std::uint32_t page_size, std::uint32_t max_pages) noexcept
+      : page_size_{page_size}, max_pages_{max_pages} {}
+
+  /// \return Nothing if no page has room, even after opening new pages up to
+  /// the limit.
+  auto allocate(std::uint32_t width,
+                std::uint32_t height) -> std::optional<Handle>;
+  /// \brief Frees `handle`. The space is reclaimed at once if it ends its
+  /// shelf or empties its page, and otherwise by `compact`.
+  auto release(Handle handle) noexcept -> void;
+
+  /// \brief Repacks the live entries of `page`, tallest first.
+  /// \return Every live entry on the page with its old and new place, or
+  /// nothing (leaving the page as it was) if they would not all fit.
+  auto compact(std::uint32_t page) -> std::vector<Move>;
+
+  /// \brief The page with the most freed but unreclaimed area, if any.
+  [[nodiscard]] auto most_fragmented_page() const noexcept
+      -> std::optional<std::uint32_t>;
+
+  [[nodiscard]] inline auto rect(Handle handle) const noexcept
+      -> const Rect& {
+    return entries_[handle].rect;
+  }
+  [[nodiscard]] inline auto page_size() const noexcept -> std::uint32_t {
+    return page_size_;
+  }
+  [[nodiscard]] inline auto page_count() const noexcept -> std::size_t {
+    return pages_.size();
+  }
+  [[nodiscard]] inline auto live_count() const noexcept -> std::size_t {
+    return entries_.size() - free_handles_.size();
+  }
+
+ private:
+  struct Shelf {
+    std::uint32_t y;
+    std::uint32_t height;
+    /// Width taken from the left edge.
+    std::uint32_t used;
+  };
+
+  struct Page {
+    std::vector<Shelf> shelves;
+    /// Height taken by shelves from the top edge.
+    std::uint32_t bottom{0};
+    /// Area of the rectangles handed out and not yet reclaimed.
+    std::uint64_t reserved_area{0};
+    std::uint64_t live_area{0};
+    std::uint32_t live_count{0};
+  };
+
+  struct Entry {
+    Rect rect{};
+    std::uint32_t shelf{0};
+    bool live{false};
+  };
+
+  auto place(std::uint32_t page, std::uint32_t width,
+             std::uint32_t height) -> std::optional<Entry>;
+  auto store(const Entry& entry) -> Handle;
+
+  std::uint32_t page_size_;
+  std::uint32_t max_pages_;
+  std::vector<Page> pages_;
+  std::vector<Entry> entries_;
+  std::vector<Handle> free_handles_;
+};
+
+}  // namespace csc::atlas
+
+#endif  // CSC_SHELFPACKER_HPP
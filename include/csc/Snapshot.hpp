@@ -0,0 +1,245 @@
+#ifndef CSC_SNAPSHOT_HPP
+#define CSC_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace csc {
+
+class ImageAlbum;
+
+namespace snapshot {
+
+/// \brief Bumped whenever any section's layout changes, so files written by
+/// an older build are rebuilt rather than misread.
+constexpr std::uint32_t FormatVersion{1};
+
+/// \brief What each section of a snapshot holds. Scalars are sections of one
+/// element.
+enum class Section : std::uint32_t {
+  /// Record ids in slot order.
+  Records,
+  /// The next id `ImageRecord` would have handed out.
+  NextId,
+  IdTable,
+  IdCount,
+  Similar,
+  ColourTree,
+  ColourPending,
+  ColourStale,
+  TitleNodes,
+  TitleKeys,
+  TitleFolded,
+  TitleSpelled,
+  TitleCount,
+  TagNames,
+  /// End of each tag's name in `TagNames`.
+  TagNameEnds,
+  /// End of each tag's groups in `TagGroups`; the last bitmap is the records.
+  TagBitmapEnds,
+  TagGroups,
+  TagValues,
+  TagWords,
+  FacetDays,
+  FacetMonths,
+  FacetYears,
+};
+
+/// \brief Where a section lies in the file, and the size of its elements so
+/// a reader built with a different layout notices.
+struct Entry {
+  Section section;
+  std::uint32_t element_size;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+/// \brief Gathers flat sections in memory and writes them as one file.
+class Writer {
+ public:
+  template <typename T>
+    requires(std::is_trivially_copyable_v<T>)
+  inline auto add(Section section, std::span<const T> items) -> void {
+    add_bytes(section, sizeof(T), alignof(T), std::as_bytes(items));
+  }
+  template <typename T>
+    requires(std::is_trivially_copyable_v<T>)
+  inline auto add_value(Section section, const T& value) -> void {
+    add(section, std::span<const T>{&value, 1});
+  }
+
+  /// \brief Writes the sections behind a checksummed header, through a
+  /// temporary file renamed into place, so readers never see half a file.
+  /// \throws std::runtime_error if the file cannot be written.
+  auto write(const std::filesystem::path& path,
+             std::uint64_t fingerprint) const -> void;
+
+ private:
+  auto add_bytes(Section section, std::size_t element_size,
+                 std::size_t alignment, std::span<const std::byte> bytes)
+      -> void;
+
+  std::vector<Entry> entries_;
+  std::string data_;
+};
+
+/// \brief A snapshot file mapped read-only into memory. Sections are read in
+/// place, so opening one costs a checksum pass over its pages rather than
+/// any parsing or allocation per entry.
+class Snapshot {
+ public:
+  /// \brief Maps the file at `path` and checks its header and checksum.
+  /// \return Nothing if it is missing, truncated, damaged or written in
+  /// another format version.
+  static auto open(const std::filesystem::path& path)
+      -> std::optional<Snapshot>;
+
+  Snapshot(const Snapshot&) = delete;
+  inline Snapshot(Snapshot&& other) noexcept
+      : data_{std::exchange(other.data_, nullptr)},
+        size_{std::exchange(other.size_, 0)} {}
+  auto operator=(const Snapshot&) -> Snapshot& = delete;
+  inline auto operator=(Snapshot&& other) noexcept -> Snapshot& {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+  ~Snapshot();
+
+  /// \brief The `fingerprint` of the album the snapshot was written from.
+  [[nodiscard]] auto fingerprint() const noexcept -> std::uint64_t;
+  [[nodiscard]] inline auto bytes() const noexcept -> std::size_t {
+    return size_;
+  }
+
+  /// \throws std::runtime_error if the section is missing or its elements
+  /// are not `T`.
+  template <typename T>
+    requires(std::is_trivially_copyable_v<T>)
+  [[nodiscard]] inline auto section(Section section) const
+      -> std::span<const T> {
+    const auto bytes{find(section, sizeof(T), alignof(T))};
+    return {reinterpret_cast<const T*>(bytes.data()),  // NOLINT
+            bytes.size() / sizeof(T)};
+  }
+  /// \throws std::runtime_error if the section does not hold exactly one
+  /// `T`.
+  template <typename T>
+    requires(std::is_trivially_copyable_v<T>)
+  [[nodiscard]] inline auto value(Section section) const -> T {
+    const auto items{this->section<T>(section)};
+    if (items.size() != 1) {
+      throw std::runtime_error{"Snapshot section " +
+                               std::to_string(static_cast<std::uint32_t>(
+                                   section)) +
+                               " does not hold one value"};
+    }
+    return items.front();
+  }
+
+ private:
+  inline Snapshot(const std::byte* data, std::size_t size) noexcept
+      : data_{data}, size_{size} {}
+
+  [[nodiscard]] auto find(Section section, std::size_t element_size,
+                          std::size_t alignment) const
+      -> std::span<const std::byte>;
+
+  const std::byte* data_;
+  std::size_t size_;
+};
+
+/// \brief Hashes what every index is built from: the title, genre, date and
+/// time, tags, perceptual hash and colour signature of each live record, in
+/// slot order. Ids are left out, as a parallel import numbers records in no
+/// fixed order; `ImageManager::load` restores the snapshot's own.
+auto fingerprint(const ImageAlbum& album) -> std::uint64_t;
+
+/// \brief A `std::vector` that can instead borrow a read-only array from a
+/// mapped snapshot, copying it out on the first change.
+template <typename T>
+  requires(std::is_trivially_copyable_v<T>)
+class Mappable {
+ public:
+  Mappable() noexcept = default;
+  inline Mappable(std::initializer_list<T> items) : owned_{items} {}
+
+  /// \brief Reads `items` in place until the next change. They must outlive
+  /// every read.
+  inline auto borrow(std::span<const T> items) noexcept -> void {
+    owned_ = {};
+    borrowed_ = items;
+  }
+  /// \brief Takes `items` as the elements, dropping any borrowed ones.
+  inline auto assign(std::vector<T>&& items) noexcept -> void {
+    owned_ = std::move(items);
+    borrowed_ = {};
+  }
+
+  /// \brief The elements, to change.
+  inline auto owned() -> std::vector<T>& {
+    if (is_borrowed()) {
+      owned_.assign(borrowed_.begin(), borrowed_.end());
+      borrowed_ = {};
+    }
+    return owned_;
+  }
+
+  [[nodiscard]] inline auto view() const noexcept -> std::span<const T> {
+    return is_borrowed() ? borrowed_ : std::span<const T>{owned_};
+  }
+  [[nodiscard]] inline auto operator[](std::size_t i) const noexcept
+      -> const T& {
+    return is_borrowed() ? borrowed_[i] : owned_[i];
+  }
+  [[nodiscard]] inline auto data() const noexcept -> const T* {
+    return view().data();
+  }
+  [[nodiscard]] inline auto size() const noexcept -> std::size_t {
+    return is_borrowed() ? borrowed_.size() : owned_.size();
+  }
+  [[nodiscard]] inline auto empty() const noexcept -> bool {
+    return size() == 0;
+  }
+  [[nodiscard]] inline auto begin() const noexcept {
+    return view().begin();
+  }
+  [[nodiscard]] inline auto end() const noexcept { return view().end(); }
+
+  /// \brief Heap memory held; nothing while borrowing.
+  [[nodiscard]] inline auto capacity() const noexcept -> std::size_t {
+    return owned_.capacity();
+  }
+  [[nodiscard]] inline auto is_borrowed() const noexcept -> bool {
+    return borrowed_.data() != nullptr;
+  }
+
+  inline auto clear() noexcept -> void {
+    owned_.clear();
+    borrowed_ = {};
+  }
+
+  friend inline auto operator==(const Mappable& a, const Mappable& b) noexcept
+      -> bool {
+    return std::ranges::equal(a.view(), b.view());
+  }
+
+ private:
+  std::vector<T> owned_;
+  std::span<const T> borrowed_;
+};
+
+}  // namespace snapshot
+}  // namespace csc
+
+#endif  // CSC_SNAPSHOT_HPP
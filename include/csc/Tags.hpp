@@ -0,0 +1,257 @@
+#ifndef CSC_TAGS_HPP
+#define CSC_TAGS_HPP
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "csc/Snapshot.hpp"
+
+namespace csc::tags {
+
+/// \brief Dense tag number, handed out in order of first use.
+using TagId = std::uint32_t;
+
+/// Ids below this are the genres, in `ImageRecord::Genre::index()` order.
+constexpr TagId BuiltinCount{9};
+
+/// \brief Whether `name` can be a tag: not empty, no whitespace or control
+/// characters, none of `"\,;|`, and not starting with `-`, so lists, queries,
+/// CSV and JSON need no quoting or escaping.
+auto valid_name(std::string_view name) noexcept -> bool;
+
+/// \brief Tag names to dense ids, matched without regard to ASCII case. Names
+/// keep the spelling they were first interned with. Safe to share between
+/// threads.
+class Dictionary {
+ public:
+  /// \brief Starts with the genres registered as the built-in tags.
+  Dictionary();
+
+  /// \return The id of `name`, registering it if it is new.
+  /// \throws std::invalid_argument if `name` is not `valid_name`.
+  auto intern(std::string_view name) -> TagId;
+  [[nodiscard]] auto find(std::string_view name) const
+      -> std::optional<TagId>;
+  /// \brief `id` must have come from this dictionary.
+  [[nodiscard]] auto name(TagId id) const -> std::string_view;
+  [[nodiscard]] auto size() const -> std::size_t;
+
+ private:
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, TagId> ids_;
+  /// A deque, so views handed out by `name` survive later interning.
+  std::deque<std::string> names_;
+};
+
+/// \brief The process-wide dictionary every record's tags refer to.
+auto dictionary() -> Dictionary&;
+
+/// \brief A record's own tags: a sorted vector, as records carry a handful.
+class TagSet {
+ public:
+  using const_iterator = std::vector<TagId>::const_iterator;
+
+  TagSet() noexcept = default;
+  TagSet(std::initializer_list<TagId> ids);
+
+  /// \return false if `id` was already there.
+  auto insert(TagId id) -> bool;
+  /// \return false if `id` was not there.
+  auto erase(TagId id) noexcept -> bool;
+  [[nodiscard]] auto contains(TagId id) const noexcept -> bool;
+
+  [[nodiscard]] inline auto size() const noexcept -> std::size_t {
+    return ids_.size();
+  }
+  [[nodiscard]] inline auto empty() const noexcept -> bool {
+    return ids_.empty();
+  }
+  [[nodiscard]] inline auto begin() const noexcept -> const_iterator {
+    return ids_.begin();
+  }
+  [[nodiscard]] inline auto end() const noexcept -> const_iterator {
+    return ids_.end();
+  }
+
+  friend inline auto operator==(const TagSet&, const TagSet&) noexcept
+      -> bool = default;
+
+ private:
+  std::vector<TagId> ids_;
+};
+
+/// \brief Interns each name in `text`, separated by `;` or whitespace.
+/// \throws std::invalid_argument naming the first name that is not
+/// `valid_name`.
+auto parse_list(std::string_view text, Dictionary& names = dictionary())
+    -> TagSet;
+/// \brief The names of `tags` joined with `;`, as `parse_list` reads them.
+auto format_list(const TagSet& tags, const Dictionary& names = dictionary())
+    -> std::string;
+auto append_list(std::string& out, const TagSet& tags,
+                 const Dictionary& names = dictionary()) -> void;
+
+/// \brief Compressed bitmap of 32-bit values in the Roaring layout: values
+/// are grouped by their top 16 bits, and each group is stored as a sorted
+/// array of the low halves while it holds at most `ArrayLimit`, or as a fixed
+/// 8 KiB bitset once it would be larger. Sparse and dense tags both stay
+/// compact, and set operations run group against group, word at a time where
+/// both sides are dense.
+class Bitmap {
+ public:
+  /// Past this a group is smaller as a bitset.
+  static constexpr std::size_t ArrayLimit{4096};
+
+  /// \return false if `value` was already there.
+  auto add(std::uint32_t value) -> bool;
+  /// \return false if `value` was not there.
+  auto remove(std::uint32_t value) -> bool;
+  [[nodiscard]] auto contains(std::uint32_t value) const noexcept -> bool;
+
+  [[nodiscard]] auto cardinality() const noexcept -> std::size_t;
+  [[nodiscard]] inline auto empty() const noexcept -> bool {
+    return groups_.empty();
+  }
+  inline auto clear() noexcept -> void { groups_.clear(); }
+  /// \brief Heap and inline memory held by the bitmap.
+  [[nodiscard]] auto bytes() const noexcept -> std::size_t;
+
+  auto operator&=(const Bitmap& other) -> Bitmap&;
+  auto operator|=(const Bitmap& other) -> Bitmap&;
+  /// \brief Removes every value in `other`.
+  auto operator-=(const Bitmap& other) -> Bitmap&;
+
+  friend inline auto operator&(Bitmap a, const Bitmap& b) -> Bitmap {
+    return a &= b;
+  }
+  friend inline auto operator|(Bitmap a, const Bitmap& b) -> Bitmap {
+    return a |= b;
+  }
+  friend inline auto operator-(Bitmap a, const Bitmap& b) -> Bitmap {
+    return a -= b;
+  }
+  friend auto operator==(const Bitmap&, const Bitmap&) noexcept
+      -> bool = default;
+
+  /// \brief Calls `visit(value)` for every value, in ascending order.
+  template <typename Visit>
+    requires(std::invocable<Visit&, std::uint32_t>)
+  inline auto for_each(Visit&& visit) const -> void {
+    for (const auto& group : groups_) {
+      const auto high{std::uint32_t{group.key} << 16U};
+      if (group.words.empty()) {
+        for (const auto low : group.values) {
+          visit(high | low);
+        }
+        continue;
+      }
+      for (std::uint32_t word{0}; word < Words; ++word) {
+        for (auto bits{group.words[word]}; bits != 0; bits &= bits - 1) {
+          visit(high | (word << 6U) |
+                static_cast<std::uint32_t>(std::countr_zero(bits)));
+        }
+      }
+    }
+  }
+
+ private:
+  friend class TagIndex;
+
+  static constexpr std::uint32_t Words{65536 / 64};
+
+  /// \brief Exactly one of `values` and `words` is in use: `words` holds
+  /// `Words` entries once `count` is above `ArrayLimit` and is empty
+  /// otherwise. Either may be read in place from a snapshot.
+  struct Group {
+    std::uint16_t key{0};
+    std::uint32_t count{0};
+    snapshot::Mappable<std::uint16_t> values{};
+    snapshot::Mappable<std::uint64_t> words{};
+
+    friend auto operator==(const Group&, const Group&) noexcept
+        -> bool = default;
+  };
+
+  auto find(std::uint16_t key) noexcept -> std::vector<Group>::iterator;
+  [[nodiscard]] auto find(std::uint16_t key) const noexcept
+      -> std::vector<Group>::const_iterator;
+
+  static auto to_words(Group& group) -> void;
+  static auto to_values(Group& group) -> void;
+  /// \brief Switches to the representation that suits `count`.
+  static auto settle(Group& group) -> void;
+  static auto intersect(Group& group, const Group& other) -> void;
+  static auto unite(Group& group, const Group& other) -> void;
+  static auto subtract(Group& group, const Group& other) -> void;
+
+  /// Sorted by key; empty groups are dropped.
+  std::vector<Group> groups_;
+};
+
+/// \brief A tag query in conjunctive form: a record matches when it carries at
+/// least one tag of every group and none of the excluded tags. No groups
+/// matches every record; a group with no tags matches none.
+struct Query {
+  std::vector<std::vector<TagId>> groups;
+  std::vector<TagId> excluded;
+};
+
+/// \brief Reads a query such as `beach|coast sunset -night`: terms are split
+/// by whitespace, `|` joins the names in a term into one group, and a term
+/// starting with `-` excludes each of its names. Names the dictionary has
+/// never seen match nothing.
+auto parse_query(std::string_view text,
+                 const Dictionary& names = dictionary()) -> Query;
+
+/// \brief One bitmap of record ids per tag, plus one of every indexed record
+/// for queries that only exclude. Record ids must fit in 32 bits.
+class TagIndex {
+ public:
+  using Id = std::uint32_t;
+
+  /// \brief Adds `record` to the set `Query` exclusions start from.
+  auto insert(Id record) -> void;
+  /// \brief Removes `record` from that set; its tags are untagged separately.
+  auto erase(Id record) -> void;
+  auto tag(Id record, TagId tag) -> void;
+  auto untag(Id record, TagId tag) -> void;
+  auto clear() noexcept -> void;
+
+  /// \brief The records carrying `tag`.
+  [[nodiscard]] auto tagged(TagId tag) const noexcept -> const Bitmap&;
+  [[nodiscard]] inline auto records() const noexcept -> const Bitmap& {
+    return records_;
+  }
+  /// \brief The records matching `query`. Groups are intersected smallest
+  /// first, so one rare tag keeps every later step small.
+  [[nodiscard]] auto evaluate(const Query& query) const -> Bitmap;
+  [[nodiscard]] auto bytes() const noexcept -> std::size_t;
+
+  /// \brief Writes each tag's name and bitmap, so a reader whose dictionary
+  /// numbers tags differently still finds them.
+  auto save(snapshot::Writer& writer) const -> void;
+  /// \brief Reads the bitmaps in place from `snapshot`, interning their
+  /// names. Only the group headers are copied; a group's values or words are
+  /// copied out when it first changes.
+  auto load(const snapshot::Snapshot& snapshot) -> void;
+
+ private:
+  [[nodiscard]] auto any_of(const std::vector<TagId>& tags) const -> Bitmap;
+
+  std::vector<Bitmap> tagged_;
+  Bitmap records_;
+};
+
+}  // namespace csc::tags
+
+#endif  // CSC_TAGS_HPP
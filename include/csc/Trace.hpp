@@ -0,0 +1,105 @@
+#ifndef CSC_TRACE_HPP
+#define CSC_TRACE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+
+namespace csc::trace {
+
+/// \brief Whether `CSC_TRACE_SCOPE` records anything in this build. Configure
+/// with `-DCSC_TRACING=ON` to turn it on; otherwise the scopes compile to
+/// nothing.
+#ifdef CSC_TRACING
+constexpr bool Compiled{true};
+#else
+constexpr bool Compiled{false};
+#endif
+
+/// Events kept per thread; later ones are dropped rather than growing
+/// without bound over a long session.
+constexpr std::size_t MaxEventsPerThread{1UZ << 20UZ};
+
+namespace detail {
+inline std::atomic<bool> recording{false};
+
+/// \brief Nanoseconds since the process started.
+auto now() noexcept -> std::uint64_t;
+/// \brief Appends a complete event to the calling thread's buffer.
+auto record(const char* name, std::uint64_t start,
+            std::uint64_t end) noexcept -> void;
+}  // namespace detail
+
+inline auto recording() noexcept -> bool {
+  return detail::recording.load(std::memory_order_relaxed);
+}
+
+/// \brief Discards earlier events and starts recording.
+auto start() -> void;
+auto stop() noexcept -> void;
+
+/// \brief Events recorded since `start`, on every thread.
+auto event_count() -> std::size_t;
+
+/// \brief Writes the events as Chrome Trace Event JSON, which Perfetto and
+/// chrome://tracing open directly.
+auto write_json(std::ostream& out) -> void;
+/// \throws std::runtime_error if `path` cannot be written.
+auto write_file(const std::filesystem::path& path) -> void;
+
+/// \brief Records how long the enclosing scope takes. `name` must outlive
+/// the session, so pass a string literal. While not recording the only cost
+/// is the branch on `recording()`.
+class Scope {
+ public:
+  explicit inline Scope(const char* name) noexcept {
+    if (recording()) {
+      name_ = name;
+      start_ = detail::now();
+    }
+  }
+  Scope(const Scope&) = delete;
+  auto operator=(const Scope&) -> Scope& = delete;
+  inline ~Scope() {
+    if (name_ != nullptr) {
+      detail::record(name_, start_, detail::now());
+    }
+  }
+
+ private:
+  const char* name_{nullptr};
+  std::uint64_t start_{0};
+};
+
+/// \brief Records for as long as it lives if the `CSC_TRACE` environment
+/// variable names a file, and writes the trace there when destroyed. Meant
+/// to be the first thing in `main`.
+class Session {
+ public:
+  Session();
+  Session(const Session&) = delete;
+  auto operator=(const Session&) -> Session& = delete;
+  ~Session() noexcept;
+
+ private:
+  std::optional<std::filesystem::path> path_;
+};
+
+}  // namespace csc::trace
+
+#ifdef CSC_TRACING
+#define CSC_TRACE_CONCAT_INNER(a, b) a##b
+#define CSC_TRACE_CONCAT(a, b) CSC_TRACE_CONCAT_INNER(a, b)
+/// \brief Traces the rest of the enclosing scope as `name`.
+#define CSC_TRACE_SCOPE(name) \
+  const ::csc::trace::Scope CSC_TRACE_CONCAT(csc_trace_scope_, __LINE__) { \
+    name                                                                   \
+  }
+#else
+#define CSC_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif  // CSC_TRACE_HPP
@@ -1,6 +1,7 @@
 #ifndef CSC_USERINTERFACE_HPP
 #define CSC_USERINTERFACE_HPP
 
+#include <array>
 #include <format>
 #include <ranges>
 #include <span>
@@ -13,6 +14,8 @@
 #include "csc/ImageManager.hpp"
 #include "csc/ImageRecord.hpp"
 #include "csc/OptionPack.hpp"
+#include "csc/QueryCache.hpp"
+#include "csc/Tags.hpp"
 #include "csc/date.hpp"
 
 namespace csc {
@@ -30,7 +33,13 @@ class UserInterface {
 
   virtual void wait_for_enter() const noexcept = 0;
 
-  auto show_images(ImageAlbum& images) const noexcept -> void;
+  /// \brief Formatted output. The default formats into a temporary string and
+  /// hands it to `put`/`putln`; interfaces with their own buffer can format
+  /// straight into it.
+  virtual void vput(std::string_view fmt, std::format_args args) const;
+  virtual void vputln(std::string_view fmt, std::format_args args) const;
+
+  auto show_images(const ImageAlbum& images) const noexcept -> void;
 
   auto run() -> void;
 
@@ -39,20 +48,22 @@ class UserInterface {
   auto display_images_with_title(std::string_view title) const noexcept -> void;
 
   auto add_image() -> void;
+  auto update_image() -> void;
+  auto remove_image() -> void;
+  auto import_images() -> void;
   auto search_image() -> void;
   auto display_all_images() -> void;
+  auto show_stats() -> void;
 
   template <typename... Args>
   inline auto print(const std::format_string<Args...> fmt,
                     Args&&... args) const noexcept -> void {
-    auto str = std::format(fmt, std::forward<Args>(args)...);
-    put(str);
+    vput(fmt.get(), std::make_format_args(args...));
   }
   template <typename... Args>
   inline auto println(const std::format_string<Args...> fmt,
                       Args&&... args) const noexcept -> void {
-    auto str = std::format(fmt, std::forward<Args>(args)...);
-    putln(str);
+    vputln(fmt.get(), std::make_format_args(args...));
   }
 
  protected:
@@ -75,9 +86,19 @@ class UserInterface {
     return manager_.add_image(std::forward<Args>(args)...);
   }
 
+  /// \brief Results of `query`, shared with earlier identical queries while
+  /// the catalog is unchanged.
+  inline auto cached_search(const query::Query& query) -> query::Result {
+    return cache_.search(manager_, query);
+  }
+
  private:
   auto get_non_empty_string() const noexcept -> std::string;
+  /// \brief A title, offering completions of any input ending in `?`.
+  auto get_title() const noexcept -> std::string;
   auto get_genre() const noexcept -> ImageRecord::Genre;
+  /// \brief Tag names separated by spaces or `;`; blank for none.
+  auto get_tags() const -> tags::TagSet;
 
   auto get_year_month_day() const noexcept -> date::Date;
   auto get_time() const noexcept -> date::Time;
@@ -87,6 +108,7 @@ class UserInterface {
   auto get_file_path() const noexcept -> std::filesystem::path;
 
   ImageManager manager_;
+  query::ResultCache cache_;
 };
 
 template <typename>
@@ -104,8 +126,16 @@ struct Extractor<OptionPack<Options...>> {
   }
 
   static inline auto display_options(const UserInterface& ui) noexcept -> void {
-    for (auto i : std::ranges::iota_view{0ULL, MyOptions::Size}) {
-      ui.println("{}. {}", i + 1, MyOptions::Options[i]);
+    // Formatted once; the GUI redraws its menus every frame.
+    static const auto lines{[] {
+      std::array<std::string, MyOptions::Size> lines;
+      for (auto i : std::ranges::iota_view{0ULL, MyOptions::Size}) {
+        lines[i] = std::format("{}. {}", i + 1, MyOptions::Options[i]);
+      }
+      return lines;
+    }()};
+    for (const auto& line : lines) {
+      ui.putln(line);
     }
   }
 
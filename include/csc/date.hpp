@@ -4,8 +4,11 @@
 #include <chrono>
 #include <cstdint>
 #include <format>
+#include <iterator>
+#include <optional>
 #include <ostream>
 #include <ratio>
+#include <string_view>
 
 #include "csc/core.h"
 
@@ -62,6 +65,28 @@ class Time {
   inline auto to_string() const noexcept -> std::string {
     return TimeSplit{ms_}.to_string();
   }
+  /// \brief Same text as `to_string`, written to `out` without a temporary.
+  template <std::output_iterator<char> Out>
+  inline auto format_to(Out out) const -> Out {
+    return TimeSplit{ms_}.format_to(out);
+  }
+
+  /// \brief Milliseconds since midnight.
+  MAYBE_CONSTEXPR inline auto count() const noexcept -> std::uint32_t {
+    return ms_;
+  }
+
+  /// \brief `HH:MM:SS.mmm`
+  template <std::output_iterator<char> Out>
+  inline auto format_iso8601_to(Out out) const -> Out {
+    return std::format_to(out, "{:02}:{:02}:{:02}.{:03}",
+                          ms_ / milliseconds_per_hour::num,
+                          ms_ % milliseconds_per_hour::num /
+                              milliseconds_per_minute::num,
+                          ms_ % milliseconds_per_minute::num /
+                              milliseconds_per_second::num,
+                          ms_ % milliseconds_per_second::num);
+  }
 
  private:
   using u8 = std::uint8_t;  // NOLINT
@@ -119,6 +144,11 @@ class Time {
       return std::format("{}h {}min {}s {}ms", hours_, minutes_, seconds_,
                          milliseconds_);
     }
+    template <std::output_iterator<char> Out>
+    inline auto format_to(Out out) const -> Out {
+      return std::format_to(out, "{}h {}min {}s {}ms", hours_, minutes_,
+                            seconds_, milliseconds_);
+    }
 
    private:
     u8 hours_;
@@ -173,19 +203,22 @@ class DateTime {
 
   friend auto operator<(const DateTime& self,
                         const DateTime& other) noexcept -> bool {
-    return (self.date_ < other.date_) and (self.time_ < other.time_);
+    if (self.date_ != other.date_) {
+      return self.date_ < other.date_;
+    }
+    return self.time_ < other.time_;
   }
   friend auto operator<=(const DateTime& self,
                          const DateTime& other) noexcept -> bool {
-    return (self.date_ <= other.date_) and (self.time_ <= other.time_);
+    return not(other < self);
   }
   friend auto operator>(const DateTime& self,
                         const DateTime& other) noexcept -> bool {
-    return (self.date_ > other.date_) and (self.time_ > other.time_);
+    return other < self;
   }
   friend auto operator>=(const DateTime& self,
                          const DateTime& other) noexcept -> bool {
-    return (self.date_ >= other.date_) and (self.time_ >= other.time_);
+    return not(self < other);
   }
   friend auto operator==(const DateTime& self,
                          const DateTime& other) noexcept -> bool {
@@ -195,12 +228,128 @@ class DateTime {
   inline auto to_string() const noexcept -> std::string {
     return std::format("{:%F} {}", date_, time_.to_string());
   }
+  /// \brief Same text as `to_string`, written to `out` without a temporary.
+  template <std::output_iterator<char> Out>
+  inline auto format_to(Out out) const -> Out {
+    out = std::format_to(out, "{:%F} ", date_);
+    return time_.format_to(out);
+  }
+
+  /// \brief `YYYY-MM-DDTHH:MM:SS.mmm`, which `parse_iso8601` reads back.
+  template <std::output_iterator<char> Out>
+  inline auto format_iso8601_to(Out out) const -> Out {
+    out = std::format_to(out, "{:%F}T", date_);
+    return time_.format_iso8601_to(out);
+  }
+
+  MAYBE_CONSTEXPR inline auto get_date() const noexcept
+      -> std::chrono::year_month_day {
+    return date_;
+  }
+  MAYBE_CONSTEXPR inline auto get_time() const noexcept -> Time {
+    return time_;
+  }
 
  private:
   std::chrono::year_month_day date_;
   Time time_;
 };
 
+/// \brief Reads `YYYY-MM-DD` optionally followed by `T` (or a space) and
+/// `HH:MM`, `HH:MM:SS` or `HH:MM:SS.fff`, and an optional trailing `Z`.
+/// `/` is accepted in place of `-` in the date.
+inline auto parse_iso8601(std::string_view text) noexcept
+    -> std::optional<DateTime> {
+  std::size_t at{0};
+  const auto digits = [&text, &at](std::size_t count) -> std::optional<int> {
+    if (text.size() - at < count) {
+      return std::nullopt;
+    }
+    int value{0};
+    for (const auto end{at + count}; at < end; ++at) {
+      const auto c{text[at]};
+      if (c < '0' or c > '9') {
+        return std::nullopt;
+      }
+      value = (value * 10) + (c - '0');
+    }
+    return value;
+  };
+  const auto skip = [&text, &at](char c) {
+    if (at < text.size() and text[at] == c) {
+      ++at;
+      return true;
+    }
+    return false;
+  };
+
+  const auto year{digits(4)};
+  const auto separator{at < text.size() ? text[at] : '\0'};
+  if (not year or (separator != '-' and separator != '/') or
+      not skip(separator)) {
+    return std::nullopt;
+  }
+  const auto month{digits(2)};
+  if (not month or not skip(separator)) {
+    return std::nullopt;
+  }
+  const auto day{digits(2)};
+  if (not day) {
+    return std::nullopt;
+  }
+  const std::chrono::year_month_day date{
+      std::chrono::year{*year},
+      std::chrono::month{static_cast<unsigned>(*month)},
+      std::chrono::day{static_cast<unsigned>(*day)}};
+  if (not date.ok()) {
+    return std::nullopt;
+  }
+
+  int hour{0};
+  int minute{0};
+  int second{0};
+  int milli{0};
+  if (skip('T') or skip(' ')) {
+    const auto h{digits(2)};
+    if (not h or not skip(':')) {
+      return std::nullopt;
+    }
+    const auto m{digits(2)};
+    if (not m) {
+      return std::nullopt;
+    }
+    hour = *h;
+    minute = *m;
+    if (skip(':')) {
+      const auto sec{digits(2)};
+      if (not sec) {
+        return std::nullopt;
+      }
+      second = *sec;
+      if (skip('.')) {
+        // Keep millisecond precision and ignore any finer digits.
+        int scale{100};
+        const auto first{at};
+        for (; at < text.size() and text[at] >= '0' and text[at] <= '9';
+             ++at, scale /= 10) {
+          milli += (text[at] - '0') * scale;
+        }
+        if (at == first) {
+          return std::nullopt;
+        }
+      }
+    }
+  }
+  skip('Z');
+  if (at != text.size() or hour > 23 or minute > 59 or second > 59) {
+    return std::nullopt;
+  }
+  return DateTime{date, Time{static_cast<std::size_t>(hour),
+                             static_cast<std::size_t>(minute),
+                             static_cast<std::size_t>(second),
+                             static_cast<std::size_t>(milli)}};
+}
+
 // NOLINTBEGIN
 struct Milli {
   std::uint32_t value_;
@@ -0,0 +1,36 @@
+#include "csc/Allocations.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local std::uint64_t allocation_count{0};
+
+}  // namespace
+
+auto csc::allocations::count() noexcept -> std::uint64_t {
+  return allocation_count;
+}
+
+// Replaces the global operator new; the array and nothrow forms call this
+// one. Like the default, it retries through the new handler before throwing.
+auto operator new(std::size_t size) -> void* {
+  ++allocation_count;
+  while (true) {
+    if (void* memory = std::malloc(std::max<std::size_t>(size, 1))) {
+      return memory;
+    }
+    const auto handler{std::get_new_handler()};
+    if (handler == nullptr) {
+      throw std::bad_alloc{};
+    }
+    handler();
+  }
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t /*size*/) noexcept {
+  std::free(memory);
+}
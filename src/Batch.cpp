@@ -0,0 +1,797 @@
+#include "csc/Batch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "csc/Allocations.hpp"
+#include "csc/Exporter.hpp"
+#include "csc/Facets.hpp"
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageInfo.hpp"
+#include "csc/ImageManager.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/Importer.hpp"
+#include "csc/Ingest.hpp"
+#include "csc/PerceptualHash.hpp"
+#include "csc/QueryCache.hpp"
+#include "csc/Tags.hpp"
+#include "csc/date.hpp"
+
+using namespace csc;  // NOLINT
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t FlushThreshold{64UZ * 1024UZ};
+constexpr std::string_view Whitespace{" \t\r"};
+/// Images `colour` lists when no count is given.
+constexpr std::size_t DefaultNearest{10};
+/// Enough for the result album of most searches; more comes from the heap.
+constexpr std::size_t ArenaBytes{1024UZ * 1024UZ};
+
+auto trim(std::string_view text) noexcept -> std::string_view {
+  const auto first{text.find_first_not_of(Whitespace)};
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last{text.find_last_not_of(Whitespace)};
+  return text.substr(first, last - first + 1);
+}
+
+/// \brief Splits off the first whitespace separated word.
+auto split_word(std::string_view text) noexcept
+    -> std::pair<std::string_view, std::string_view> {
+  const auto end{text.find_first_of(Whitespace)};
+  if (end == std::string_view::npos) {
+    return {text, {}};
+  }
+  return {text.substr(0, end), trim(text.substr(end))};
+}
+
+auto parse_number(std::string_view text) noexcept
+    -> std::optional<std::size_t> {
+  std::size_t id{0};
+  const auto* const end{text.data() + text.size()};
+  const auto [ptr, error] = std::from_chars(text.data(), end, id);
+  if (error != std::errc{} or ptr != end) {
+    return std::nullopt;
+  }
+  return id;
+}
+
+/// \brief Applies the comparison operator `op` (`<`, `<=`, `=`, `>=` or `>`).
+/// \return Nothing if `op` is not one of those.
+auto compare(std::string_view op, std::size_t lhs,
+             std::size_t rhs) noexcept -> std::optional<bool> {
+  if (op == "<") {
+    return lhs < rhs;
+  }
+  if (op == "<=") {
+    return lhs <= rhs;
+  }
+  if (op == "=" or op == "==") {
+    return lhs == rhs;
+  }
+  if (op == ">=") {
+    return lhs >= rhs;
+  }
+  if (op == ">") {
+    return lhs > rhs;
+  }
+  return std::nullopt;
+}
+
+/// \brief Counts what is asked of `upstream`, which does the work.
+class CountingResource final : public std::pmr::memory_resource {
+ public:
+  explicit CountingResource(std::pmr::memory_resource* upstream) noexcept
+      : upstream_{upstream} {}
+
+  [[nodiscard]] auto allocations() const noexcept -> std::size_t {
+    return allocations_;
+  }
+  [[nodiscard]] auto bytes() const noexcept -> std::size_t { return bytes_; }
+
+ private:
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override {
+    ++allocations_;
+    bytes_ += bytes;
+    return upstream_->allocate(bytes, alignment);
+  }
+  auto do_deallocate(void* pointer, std::size_t bytes,
+                     std::size_t alignment) -> void override {
+    upstream_->deallocate(pointer, bytes, alignment);
+  }
+  [[nodiscard]] auto do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept -> bool override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* upstream_;
+  std::size_t allocations_{0};
+  std::size_t bytes_{0};
+};
+
+class Runner {
+ public:
+  Runner(ImageManager& manager, std::ostream& out)
+      : manager_{manager}, out_{out} {
+    buffer_.reserve(FlushThreshold * 2);
+    arena_.resize(ArenaBytes);
+  }
+  Runner(const Runner&) = delete;
+  Runner(Runner&&) = delete;
+  auto operator=(const Runner&) -> Runner& = delete;
+  auto operator=(Runner&&) -> Runner& = delete;
+  ~Runner() { flush(); }
+
+  /// \return Whether the query succeeded.
+  auto execute(std::size_t line, std::string_view query) -> bool {
+    line_ = line;
+    query_ = query;
+    return dispatch(query);
+  }
+
+  auto flush() -> void {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_.flush();
+    buffer_.clear();
+  }
+
+ private:
+  auto dispatch(std::string_view query) -> bool {
+    const auto [verb, args] = split_word(query);
+    if (verb == "id") {
+      return search_id(args);
+    }
+    if (verb == "title") {
+      return cached(query::Title{std::string{args}});
+    }
+    if (verb == "description") {
+      return cached(query::Description{std::string{args}});
+    }
+    if (verb == "genre") {
+      const auto genre{ImageRecord::Genre::from_name(args)};
+      if (not genre) {
+        return fail("unknown genre");
+      }
+      return cached(query::Genre{*genre});
+    }
+    if (verb == "tags") {
+      return cached(query::Tags{tags::parse_query(args)});
+    }
+    if (verb == "dates") {
+      const auto [from_text, to_text] = split_word(args);
+      const auto from{date::parse_iso8601(from_text)};
+      const auto to{date::parse_iso8601(to_text)};
+      if (not from or not to) {
+        return fail("expected two ISO-8601 dates");
+      }
+      return cached(query::Dates{*from, *to});
+    }
+    if (verb == "width") {
+      return dimension(&ImageInfo::width, args);
+    }
+    if (verb == "height") {
+      return dimension(&ImageInfo::height, args);
+    }
+    if (verb == "orientation") {
+      const auto orientation{ImageInfo::orientation_from_name(args)};
+      if (not orientation) {
+        return fail("expected landscape, portrait or square");
+      }
+      return cached(query::Orientation{*orientation});
+    }
+    if (verb == "similar") {
+      return similar(args);
+    }
+    if (verb == "colour") {
+      return colour(args);
+    }
+    if (verb == "duplicates") {
+      return duplicates(args);
+    }
+    if (verb == "facets") {
+      return facets(args);
+    }
+    if (verb == "add") {
+      return add(args);
+    }
+    if (verb == "remove") {
+      return remove(args);
+    }
+    if (verb == "tag" or verb == "untag") {
+      return retag(args, verb == "tag");
+    }
+    if (verb == "export") {
+      return export_to(args);
+    }
+    if (verb == "import") {
+      return import_from(args);
+    }
+    if (verb == "snapshot") {
+      return save_snapshot(args);
+    }
+    if (verb == "load") {
+      return load(args);
+    }
+    if (verb == "allocations") {
+      return allocations(args);
+    }
+    return fail("unknown query");
+  }
+
+  /// \brief Answers `query` from the result cache while the catalog is
+  /// unchanged since it was last asked.
+  auto cached(const query::Query& query) -> bool {
+    if (measuring_) {
+      return measure(query);
+    }
+    const auto start{Clock::now()};
+    const auto album{cache_.search(manager_, query)};
+    return succeed(Clock::now() - start, *album);
+  }
+
+  template <typename Search>
+  auto timed(Search&& search) -> bool {
+    const auto start{Clock::now()};
+    const auto album{search()};
+    return succeed(Clock::now() - start, album);
+  }
+
+  auto search_id(std::string_view args) -> bool {
+    const auto id{parse_number(args)};
+    if (not id) {
+      return fail("expected a numeric id");
+    }
+    const auto start{Clock::now()};
+    const auto image{manager_.search_id(*id)};
+    const auto elapsed{Clock::now() - start};
+    if (image) {
+      return succeed(elapsed, std::span<const ImageRecord>{*image, 1});
+    }
+    return succeed(elapsed, std::span<const ImageRecord>{});
+  }
+
+  /// \brief `width >= 4000` and the like, over probed records only.
+  auto dimension(std::uint32_t ImageInfo::*member,
+                 std::string_view args) -> bool {
+    const auto [op, value_text] = split_word(args);
+    const auto value{parse_number(value_text)};
+    if (not value or not compare(op, 0, 0)) {
+      return fail("expected <, <=, =, >= or > and a number of pixels");
+    }
+    return timed([this, member, op, &value] {
+      return manager_.search_if([member, op, &value](const ImageRecord& image) {
+        const auto& info{image.get_info()};
+        return info.is_known() and *compare(op, info.*member, *value);
+      });
+    });
+  }
+
+  /// \brief An optional Hamming distance, defaulting to
+  /// `phash::DefaultMaxDistance`.
+  static auto parse_distance(std::string_view text) noexcept
+      -> std::optional<unsigned> {
+    if (text.empty()) {
+      return phash::DefaultMaxDistance;
+    }
+    const auto distance{parse_number(text)};
+    if (not distance or *distance > 64) {
+      return std::nullopt;
+    }
+    return static_cast<unsigned>(*distance);
+  }
+
+  auto similar(std::string_view args) -> bool {
+    const auto [id_text, distance_text] = split_word(args);
+    const auto id{parse_number(id_text)};
+    const auto distance{parse_distance(distance_text)};
+    if (not id or not distance) {
+      return fail("expected an id and an optional distance up to 64");
+    }
+    const auto image{manager_.search_id(*id)};
+    if (not image) {
+      return fail("no image with that id");
+    }
+    const auto hash{(*image)->get_perceptual_hash()};
+    if (not hash) {
+      return fail("that image has not been decoded");
+    }
+    return cached(query::Similar{*hash, *distance});
+  }
+
+  /// \brief The `k` (10 by default) nearest colour signatures to an image's.
+  auto colour(std::string_view args) -> bool {
+    const auto [id_text, k_text] = split_word(args);
+    const auto id{parse_number(id_text)};
+    const auto k{k_text.empty() ? std::optional{DefaultNearest}
+                                : parse_number(k_text)};
+    if (not id or not k) {
+      return fail("expected an id and an optional number of images");
+    }
+    const auto image{manager_.search_id(*id)};
+    if (not image) {
+      return fail("no image with that id");
+    }
+    const auto& signature{(*image)->get_colour_signature()};
+    if (not signature) {
+      return fail("that image has not been decoded");
+    }
+    return cached(query::Colour{*signature, *k});
+  }
+
+  /// \brief Reports clusters of ids rather than records, as
+  /// `"clusters":[[1,7],[3,4,9]]`.
+  auto duplicates(std::string_view args) -> bool {
+    const auto distance{parse_distance(args)};
+    if (not distance) {
+      return fail("expected an optional distance up to 64");
+    }
+    const auto start{Clock::now()};
+    const auto clusters{manager_.duplicate_clusters(*distance)};
+    const std::chrono::duration<double, std::micro> micros{Clock::now() -
+                                                            start};
+
+    begin_object();
+    std::format_to(std::back_inserter(buffer_),
+                   R"(,"ok":true,"elapsed_us":{:.3f},"count":{},"clusters":[)",
+                   micros.count(), clusters.size());
+    for (std::size_t i{0}; i < clusters.size(); ++i) {
+      buffer_ += i == 0 ? "[" : ",[";
+      for (std::size_t j{0}; j < clusters[i].size(); ++j) {
+        std::format_to(std::back_inserter(buffer_), "{}{}", j == 0 ? "" : ",",
+                       clusters[i][j]);
+      }
+      buffer_ += ']';
+      flush_if_full();
+    }
+    buffer_ += "]}\n";
+    flush_if_full();
+    return true;
+  }
+
+  /// \brief `facets <period>` reads the catalog's rollups; adding
+  /// `tags <query>` or `dates <from> <to>` counts just the matching records,
+  /// without copying them.
+  auto facets(std::string_view args) -> bool {
+    const auto [period_name, rest] = split_word(args);
+    const auto period{facet::period_from_name(period_name)};
+    if (not period) {
+      return fail("expected day, month or year");
+    }
+
+    const auto [filter, filter_args] = split_word(rest);
+    const auto start{Clock::now()};
+    facet::Facets counts;
+    if (filter.empty()) {
+      counts = manager_.facets(*period);
+    } else if (filter == "tags") {
+      counts = manager_.facets(tags::parse_query(filter_args), *period);
+    } else if (filter == "dates") {
+      const auto [from_text, to_text] = split_word(filter_args);
+      const auto from{date::parse_iso8601(from_text)};
+      const auto to{date::parse_iso8601(to_text)};
+      if (not from or not to) {
+        return fail("expected two ISO-8601 dates");
+      }
+      counts = manager_.facets_if(
+          [&](const ImageRecord& image) {
+            const auto taken{image.get_date_taken()};
+            return taken >= *from and taken <= *to;
+          },
+          *period);
+    } else {
+      return fail("expected tags or dates after the period");
+    }
+    const std::chrono::duration<double, std::micro> micros{Clock::now() -
+                                                            start};
+
+    begin_object();
+    std::format_to(std::back_inserter(buffer_),
+                   R"(,"ok":true,"elapsed_us":{:.3f},"count":{},"period":"{}")",
+                   micros.count(), counts.total,
+                   facet::period_name(*period));
+    buffer_ += R"(,"genres":)";
+    append_genres(counts.genres);
+    buffer_ += R"(,"buckets":[)";
+    for (std::size_t i{0}; i < counts.rows.size(); ++i) {
+      const auto& row{counts.rows[i]};
+      std::format_to(std::back_inserter(buffer_),
+                     R"({}{{"bucket":"{}","count":{},"genres":)",
+                     i == 0 ? "" : ",",
+                     facet::format_bucket(row.bucket, *period), row.total());
+      append_genres(row.genres);
+      buffer_ += '}';
+      flush_if_full();
+    }
+    buffer_ += "]}\n";
+    flush_if_full();
+    return true;
+  }
+
+  /// \brief The non-zero counts as an object keyed by genre name.
+  auto append_genres(const facet::GenreCounts& genres) -> void {
+    buffer_ += '{';
+    bool first{true};
+    for (std::size_t genre{0}; genre < genres.size(); ++genre) {
+      if (genres[genre] == 0) {
+        continue;
+      }
+      std::format_to(std::back_inserter(buffer_), R"({}"{}":{})",
+                     std::exchange(first, false) ? "" : ",",
+                     ImageRecord::Genre::from_index(genre).name(),
+                     genres[genre]);
+    }
+    buffer_ += '}';
+  }
+
+  auto add(std::string_view args) -> bool {
+    std::array<std::string_view, 6> fields;
+    for (auto& field : fields) {
+      const auto tab{args.find('\t')};
+      field = trim(args.substr(0, tab));
+      args = tab == std::string_view::npos ? std::string_view{}
+                                           : args.substr(tab + 1);
+    }
+    const auto& [title, description, genre_name, date_text, path, tag_list] =
+        fields;
+    const auto genre{ImageRecord::Genre::from_name(genre_name)};
+    const auto date{date::parse_iso8601(date_text)};
+    if (title.empty() or not genre or not date or path.empty()) {
+      return fail(
+          "expected <title>\\t<description>\\t<genre>\\t<date>\\t<path>");
+    }
+
+    ImageRecord image{std::string{title}, std::string{description}, *genre,
+                      *date, std::filesystem::path{path}};
+    try {
+      image.set_tags(tags::parse_list(tag_list));
+    } catch (const std::invalid_argument& error) {
+      return fail(error.what());
+    }
+    ingest::inspect(image);
+    const auto id{image.get_id()};
+    const auto start{Clock::now()};
+    manager_.add_image(std::move(image));
+    const auto elapsed{Clock::now() - start};
+    return succeed(elapsed,
+                   std::span<const ImageRecord>{*manager_.search_id(id), 1});
+  }
+
+  auto remove(std::string_view args) -> bool {
+    const auto id{parse_number(args)};
+    if (not id) {
+      return fail("expected a numeric id");
+    }
+    const auto start{Clock::now()};
+    const auto removed{manager_.remove_image(*id)};
+    const auto elapsed{Clock::now() - start};
+    if (not removed) {
+      return fail("no image with that id");
+    }
+    return succeed(elapsed, std::span<const ImageRecord>{});
+  }
+
+  /// \brief `tag <id> <names>` adds the tags and `untag` removes them.
+  auto retag(std::string_view args, bool add) -> bool {
+    const auto [id_text, names] = split_word(args);
+    const auto id{parse_number(id_text)};
+    if (not id or names.empty()) {
+      return fail("expected a numeric id and tag names");
+    }
+    tags::TagSet changed;
+    try {
+      changed = tags::parse_list(names);
+    } catch (const std::invalid_argument& error) {
+      return fail(error.what());
+    }
+
+    const auto start{Clock::now()};
+    const auto updated{manager_.update_image(*id, [&](ImageRecord& image) {
+      for (const auto tag : changed) {
+        if (add) {
+          image.add_tag(tag);
+        } else {
+          image.remove_tag(tag);
+        }
+      }
+    })};
+    const auto elapsed{Clock::now() - start};
+    if (not updated) {
+      return fail("no image with that id");
+    }
+    return succeed(elapsed,
+                   std::span<const ImageRecord>{*manager_.search_id(*id), 1});
+  }
+
+  auto export_to(std::string_view args) -> bool {
+    const auto [format_name, path] = split_word(args);
+    exporter::Format format{};
+    if (format_name == "csv") {
+      format = exporter::Format::Csv;
+    } else if (format_name == "jsonl") {
+      format = exporter::Format::JsonLines;
+    } else {
+      return fail("expected csv or jsonl");
+    }
+    std::ofstream file{std::filesystem::path{path}, std::ios::binary};
+    if (path.empty() or not file) {
+      return fail("could not open the export file");
+    }
+
+    const auto start{Clock::now()};
+    std::size_t count{0};
+    {
+      exporter::Exporter out{file, format};
+      out.write_all(manager_.get_all_images());
+      count = out.records_written();
+    }
+    const auto elapsed{Clock::now() - start};
+    if (not file) {
+      return fail("failed writing the export file");
+    }
+    return succeed(elapsed, std::span<const ImageRecord>{}, count);
+  }
+
+  /// \brief Reports the imported count, plus an `errors` array of the rows
+  /// that were skipped.
+  auto import_from(std::string_view args) -> bool {
+    const std::filesystem::path path{args};
+    const auto format{importer::format_for(path)};
+    if (not format) {
+      return fail("expected a .csv or .jsonl file");
+    }
+
+    const auto start{Clock::now()};
+    importer::ImportReport report;
+    try {
+      report = importer::import_file(manager_, path, format);
+    } catch (const std::exception& e) {
+      return fail(e.what());
+    }
+    const std::chrono::duration<double, std::micro> micros{Clock::now() -
+                                                            start};
+
+    begin_object();
+    std::format_to(std::back_inserter(buffer_),
+                   R"(,"ok":true,"elapsed_us":{:.3f},"count":{},"errors":)",
+                   micros.count(), report.imported);
+    append_errors(report.errors);
+    buffer_ += "}\n";
+    flush_if_full();
+    return true;
+  }
+
+  /// \brief `snapshot <path>` writes every index to `path` for `load`.
+  auto save_snapshot(std::string_view args) -> bool {
+    if (args.empty()) {
+      return fail("expected a snapshot path");
+    }
+    const auto start{Clock::now()};
+    try {
+      manager_.save_snapshot(std::filesystem::path{args});
+    } catch (const std::exception& e) {
+      return fail(e.what());
+    }
+    const auto elapsed{Clock::now() - start};
+    return succeed(elapsed, std::span<const ImageRecord>{}, manager_.size());
+  }
+
+  /// \brief `load <catalog> <snapshot>` replaces the catalog with the file's
+  /// records. `"snapshot"` is `"mapped"` when the indexes were read from the
+  /// snapshot, or `"rebuilt"` when it was missing or stale, in which case it
+  /// is rewritten for next time.
+  auto load(std::string_view args) -> bool {
+    const auto [catalog, snapshot] = split_word(args);
+    const std::filesystem::path path{catalog};
+    if (snapshot.empty() or not importer::format_for(path)) {
+      return fail("expected a .csv or .jsonl file and a snapshot path");
+    }
+
+    const auto start{Clock::now()};
+    importer::ParseResult parsed;
+    bool mapped{false};
+    try {
+      parsed = importer::read_file(path);
+      mapped = manager_.load(std::move(parsed.records),
+                             std::filesystem::path{snapshot});
+      if (not mapped) {
+        manager_.save_snapshot(std::filesystem::path{snapshot});
+      }
+    } catch (const std::exception& e) {
+      return fail(e.what());
+    }
+    const std::chrono::duration<double, std::micro> micros{Clock::now() -
+                                                            start};
+
+    begin_object();
+    std::format_to(std::back_inserter(buffer_),
+                   R"(,"ok":true,"elapsed_us":{:.3f},"count":{},"snapshot":)",
+                   micros.count(), manager_.size());
+    buffer_ += mapped ? R"("mapped")" : R"("rebuilt")";
+    buffer_ += R"(,"errors":)";
+    append_errors(parsed.errors);
+    buffer_ += "}\n";
+    flush_if_full();
+    return true;
+  }
+
+  /// \brief `allocations <search>` runs a title, description, genre, tags,
+  /// dates, orientation, similar or colour search twice past the cache: once
+  /// allocating from the heap and once from a monotonic arena. Each run
+  /// reports what was asked of the memory resource it was given, and every
+  /// call to global `operator new` it made, which also catches tag sets and
+  /// bitmaps that do not take a resource.
+  auto allocations(std::string_view args) -> bool {
+    static constexpr std::array<std::string_view, 8> Searches{
+        "title", "description", "genre",   "tags",
+        "dates", "orientation", "similar", "colour"};
+    if (std::ranges::find(Searches, split_word(args).first) ==
+        Searches.end()) {
+      return fail("expected a search to measure");
+    }
+    measuring_ = true;
+    const auto succeeded{dispatch(args)};
+    measuring_ = false;
+    return succeeded;
+  }
+
+  auto measure(const query::Query& query) -> bool {
+    // Every heap allocation of a run, including those the resource passed
+    // on, goes through operator new on this thread.
+    CountingResource heap{std::pmr::new_delete_resource()};
+    auto new_calls{csc::allocations::count()};
+    auto start{Clock::now()};
+    const auto count{query::run(manager_, query, &heap).size()};
+    const auto heap_elapsed{Clock::now() - start};
+    const auto heap_new_calls{csc::allocations::count() - new_calls};
+
+    CountingResource upstream{std::pmr::new_delete_resource()};
+    new_calls = csc::allocations::count();
+    start = Clock::now();
+    {
+      // Released in one go here, after the album in it has gone.
+      std::pmr::monotonic_buffer_resource arena{arena_.data(), arena_.size(),
+                                                &upstream};
+      const auto album{query::run(manager_, query, &arena)};
+    }
+    const auto arena_elapsed{Clock::now() - start};
+    const auto arena_new_calls{csc::allocations::count() - new_calls};
+
+    begin_object();
+    std::format_to(std::back_inserter(buffer_), R"(,"ok":true,"count":{})",
+                   count);
+    append_allocations("heap", heap, heap_new_calls, heap_elapsed);
+    append_allocations("arena", upstream, arena_new_calls, arena_elapsed);
+    buffer_ += "}\n";
+    flush_if_full();
+    return true;
+  }
+
+  auto append_allocations(std::string_view name,
+                          const CountingResource& counted,
+                          std::uint64_t new_calls,
+                          Clock::duration elapsed) -> void {
+    const std::chrono::duration<double, std::micro> micros{elapsed};
+    std::format_to(
+        std::back_inserter(buffer_),
+        R"(,"{}":{{"allocations":{},"bytes":{},"operator_new":{},)"
+        R"("elapsed_us":{:.3f}}})",
+        name, counted.allocations(), counted.bytes(), new_calls,
+        micros.count());
+  }
+
+  auto append_errors(std::span<const importer::ImportError> errors) -> void {
+    buffer_ += '[';
+    bool first{true};
+    for (const auto& error : errors) {
+      if (not std::exchange(first, false)) {
+        buffer_ += ',';
+      }
+      std::format_to(std::back_inserter(buffer_), R"({{"line":{},"error":)",
+                     error.line);
+      exporter::append_json_string(buffer_, error.message);
+      buffer_ += '}';
+    }
+    buffer_ += ']';
+  }
+
+  auto begin_object() -> void {
+    std::format_to(std::back_inserter(buffer_), R"({{"line":{},"query":)",
+                   line_);
+    exporter::append_json_string(buffer_, query_);
+  }
+
+  template <typename Records>
+  auto succeed(Clock::duration elapsed, const Records& records) -> bool {
+    return succeed(elapsed, records, records.size());
+  }
+  template <typename Records>
+  auto succeed(Clock::duration elapsed, const Records& records,
+               std::size_t count) -> bool {
+    begin_object();
+    const std::chrono::duration<double, std::micro> micros{elapsed};
+    std::format_to(std::back_inserter(buffer_),
+                   R"(,"ok":true,"elapsed_us":{:.3f},"count":{},"results":[)",
+                   micros.count(), count);
+    bool first{true};
+    for (const auto& image : records) {
+      if (not std::exchange(first, false)) {
+        buffer_ += ',';
+      }
+      exporter::append_json_record(buffer_, image);
+    }
+    buffer_ += "]}\n";
+    flush_if_full();
+    return true;
+  }
+
+  auto fail(std::string_view error) -> bool {
+    begin_object();
+    buffer_ += R"(,"ok":false,"error":)";
+    exporter::append_json_string(buffer_, error);
+    buffer_ += "}\n";
+    flush_if_full();
+    return false;
+  }
+
+  auto flush_if_full() -> void {
+    if (buffer_.size() >= FlushThreshold) {
+      flush();
+    }
+  }
+
+  ImageManager& manager_;
+  query::ResultCache cache_;
+  std::ostream& out_;
+  std::string buffer_;
+
+  std::size_t line_{0};
+  std::string_view query_;
+  /// Set while `allocations` runs a search, so `cached` measures it instead.
+  bool measuring_{false};
+  /// The arena's first block, kept between queries.
+  std::vector<std::byte> arena_;
+};
+
+}  // namespace
+
+auto batch::run(ImageManager& manager, std::istream& queries,
+                std::ostream& out) -> std::size_t {
+  Runner runner{manager, out};
+
+  std::string line;
+  std::size_t line_number{0};
+  std::size_t failures{0};
+  while (std::getline(queries, line)) {
+    ++line_number;
+    const auto query{trim(line)};
+    if (query.empty() or query.front() == '#') {
+      continue;
+    }
+    if (not runner.execute(line_number, query)) {
+      ++failures;
+    }
+  }
+  return failures;
+}
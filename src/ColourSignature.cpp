@@ -0,0 +1,153 @@
+#include "csc/ColourSignature.hpp"
+
+#include <numeric>
+#include <random>
+
+using namespace csc;          // NOLINT
+using namespace csc::colour;  // NOLINT
+
+namespace {
+
+/// Bin for pixels too transparent to count.
+constexpr std::size_t Transparent{Bins};
+
+/// \brief Which of the four levels a channel value falls in.
+constexpr auto level(unsigned char value) noexcept -> std::size_t {
+  return static_cast<std::size_t>(value >> 6U);
+}
+
+/// \brief Recursively splits `order[begin, end)` around a random vantage
+/// point, appending nodes in pre-order.
+class Builder {
+ public:
+  using Item = VpTree::Item;
+
+  explicit Builder(const std::vector<Item>& items)
+      : items_{items}, order_(items.size()), distances_(items.size()) {
+    std::iota(order_.begin(), order_.end(), std::uint32_t{0});
+  }
+
+  template <typename Emit>
+  auto build(std::size_t begin, std::size_t end, Emit& emit) -> std::uint32_t {
+    if (begin == end) {
+      return UINT32_MAX;
+    }
+    std::uniform_int_distribution<std::size_t> pick{begin, end - 1};
+    std::swap(order_[begin], order_[pick(random_)]);
+    const auto& vantage{items_[order_[begin]].signature};
+
+    for (auto i{begin + 1}; i < end; ++i) {
+      distances_[order_[i]] = distance(vantage, items_[order_[i]].signature);
+    }
+    const auto middle{begin + 1 + ((end - begin - 1) / 2)};
+    const auto by_distance = [this](std::uint32_t a, std::uint32_t b) {
+      return distances_[a] < distances_[b];
+    };
+    std::nth_element(order_.begin() + static_cast<std::ptrdiff_t>(begin + 1),
+                     order_.begin() + static_cast<std::ptrdiff_t>(middle),
+                     order_.begin() + static_cast<std::ptrdiff_t>(end),
+                     by_distance);
+    const auto threshold{middle < end ? distances_[order_[middle]] : 0U};
+
+    const auto node{emit(items_[order_[begin]], threshold)};
+    const auto inside{build(begin + 1, middle, emit)};
+    const auto outside{build(middle, end, emit)};
+    emit.link(node, inside, outside);
+    return node;
+  }
+
+ private:
+  const std::vector<Item>& items_;
+  std::vector<std::uint32_t> order_;
+  std::vector<unsigned> distances_;
+  std::mt19937 random_{0x5EED};
+};
+
+}  // namespace
+
+auto colour::signature_rgba(std::span<const unsigned char> rgba,
+                            std::size_t pixel_count) noexcept -> Signature {
+  pixel_count = std::min(pixel_count, rgba.size() / 4);
+
+  // Four interleaved histograms, so consecutive pixels landing in the same
+  // bin do not serialise on one counter. The bin index itself is branch free.
+  std::array<std::array<std::uint32_t, Bins + 1>, 4> counts{};
+  const auto* pixel{rgba.data()};
+  for (std::size_t i{0}; i < pixel_count; ++i, pixel += 4) {
+    const auto bin{(level(pixel[0]) << 4U) | (level(pixel[1]) << 2U) |
+                   level(pixel[2])};
+    ++counts[i & 3U][pixel[3] < 128 ? Transparent : bin];
+  }
+
+  std::array<std::uint64_t, Bins> totals{};
+  std::uint64_t opaque{0};
+  for (std::size_t bin{0}; bin < Bins; ++bin) {
+    totals[bin] = std::uint64_t{counts[0][bin]} + counts[1][bin] +
+                  counts[2][bin] + counts[3][bin];
+    opaque += totals[bin];
+  }
+
+  Signature signature{};
+  if (opaque == 0) {
+    return signature;
+  }
+  for (std::size_t bin{0}; bin < Bins; ++bin) {
+    const auto share{((totals[bin] * 255) + (opaque / 2)) / opaque};
+    signature[bin] = static_cast<std::uint8_t>(share);
+  }
+  return signature;
+}
+
+colour::VpTree::VpTree(std::vector<Item> items) {
+  auto& nodes{nodes_.owned()};
+  nodes.reserve(items.size());
+
+  struct Emit {
+    std::vector<Node>& nodes;
+
+    auto operator()(const Item& item, unsigned threshold) -> std::uint32_t {
+      nodes.push_back(Node{.item = item, .threshold = threshold});
+      return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+    auto link(std::uint32_t node, std::uint32_t inside,
+              std::uint32_t outside) -> void {
+      nodes[node].inside = inside;
+      nodes[node].outside = outside;
+    }
+  } emit{nodes};
+
+  Builder{items}.build(0, items.size(), emit);
+}
+
+auto colour::SignatureIndex::rebuild(std::vector<Item> live) -> void {
+  tree_ = VpTree{std::move(live)};
+  pending_.clear();
+  stale_ = 0;
+}
+
+auto colour::SignatureIndex::clear() noexcept -> void {
+  tree_ = VpTree{};
+  pending_.clear();
+  stale_ = 0;
+}
+
+auto colour::VpTree::save(snapshot::Writer& writer) const -> void {
+  writer.add(snapshot::Section::ColourTree, nodes_.view());
+}
+
+auto colour::VpTree::load(const snapshot::Snapshot& snapshot) -> void {
+  nodes_.borrow(snapshot.section<Node>(snapshot::Section::ColourTree));
+}
+
+auto colour::SignatureIndex::save(snapshot::Writer& writer) const -> void {
+  tree_.save(writer);
+  writer.add(snapshot::Section::ColourPending, pending_.view());
+  writer.add_value(snapshot::Section::ColourStale, std::uint64_t{stale_});
+}
+
+auto colour::SignatureIndex::load(const snapshot::Snapshot& snapshot)
+    -> void {
+  tree_.load(snapshot);
+  pending_.borrow(snapshot.section<Item>(snapshot::Section::ColourPending));
+  stale_ = snapshot.value<std::uint64_t>(snapshot::Section::ColourStale);
+}
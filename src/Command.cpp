@@ -8,9 +8,14 @@ using namespace csc::command;  // NOLINT
 using Tag = Command::Tag;
 using CommandOptions = Extractor<OptionPack<
     {"Add a new image record to the image manager instance.", Tag::AddImage},
+    {"Update the details of an existing image record.", Tag::UpdateImage},
+    {"Remove an image record from the image manager instance.",
+     Tag::RemoveImage},
+    {"Import image records from a CSV or JSON Lines file.", Tag::ImportImages},
     {"Search for an image by id, title, description, type or a date range.",
      Tag::SearchImage},
     {"Display details for all images in the system.", Tag::DisplayAllImages},
+    {"Show usage counts and search latencies.", Tag::ShowStats},
     {"Exit the system.", Tag::Exit}>>;
 
 auto Command::get(const UserInterface& ui) -> Command {
@@ -23,6 +28,18 @@ auto Command::execute(UserInterface& ui) -> void {
       ui.add_image();
       break;
     }
+    case Tag::UpdateImage: {
+      ui.update_image();
+      break;
+    }
+    case Tag::RemoveImage: {
+      ui.remove_image();
+      break;
+    }
+    case Tag::ImportImages: {
+      ui.import_images();
+      break;
+    }
     case Tag::SearchImage: {
       ui.search_image();
       break;
@@ -31,6 +48,10 @@ auto Command::execute(UserInterface& ui) -> void {
       ui.display_all_images();
       break;
     }
+    case Tag::ShowStats: {
+      ui.show_stats();
+      break;
+    }
     case Tag::Exit: {
       break;
     }
@@ -1,26 +1,75 @@
 #include "csc/Console.hpp"
 
 #include <iostream>
+#include <iterator>
 #include <string>
 
 using namespace csc::console;  // NOLINT
 
-void Console::put(std::string_view message) const { std::cout << message; }
+Console::Console() {
+  // Everything goes through buffer_, so the stdio sync only costs us.
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+  buffer_.reserve(FlushThreshold * 2);
+}
+Console::~Console() { flush(); }
+
+void Console::put(std::string_view message) const {
+  buffer_ += message;
+  flush_if_full();
+}
 void Console::putln(std::string_view message) const {
-  std::cout << message << '\n';
+  buffer_ += message;
+  buffer_ += '\n';
+  flush_if_full();
+}
+
+void Console::vput(std::string_view fmt, std::format_args args) const {
+  std::vformat_to(std::back_inserter(buffer_), fmt, args);
+  flush_if_full();
+}
+void Console::vputln(std::string_view fmt, std::format_args args) const {
+  std::vformat_to(std::back_inserter(buffer_), fmt, args);
+  buffer_ += '\n';
+  flush_if_full();
 }
 
 void Console::show_image(const ImageRecord& image) const {
-  std::cout << image << '\n';
+  auto out{std::format_to(
+      std::back_inserter(buffer_),
+      "Title: {}\nDescription: {}\nGenre: {}\nDate taken: ", image.get_title(),
+      image.get_description(), image.get_genre().to_string())};
+  image.get_date_taken().format_to(out);
+  buffer_ += '\n';
+  flush_if_full();
 }
-void Console::clear_screen() const { std::cout << "\033[2J\033[1;1H"; }
+void Console::clear_screen() const { put("\033[2J\033[1;1H"); }
 void Console::wait_for_enter() const noexcept {
+  flush();
   char c;
   while (std::cin.get(c), c != '\n') {
   }
 }
 
 auto Console::read_input(std::string& buf) const -> std::string& {
+  flush();
   std::getline(std::cin, buf);
   return buf;
 }
+
+void Console::flush() const {
+  write_buffer();
+  std::cout.flush();
+}
+
+void Console::flush_if_full() const {
+  if (buffer_.size() >= FlushThreshold) {
+    write_buffer();
+  }
+}
+
+void Console::write_buffer() const {
+  std::cout.write(buffer_.data(),
+                  static_cast<std::streamsize>(buffer_.size()));
+  buffer_.clear();
+}
@@ -0,0 +1,150 @@
+#include "csc/ContentHash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace csc;  // NOLINT
+
+namespace {
+
+constexpr std::uint64_t Prime1{0x9E3779B185EBCA87ULL};
+constexpr std::uint64_t Prime2{0xC2B2AE3D27D4EB4FULL};
+constexpr std::uint64_t Prime3{0x165667B19E3779F9ULL};
+constexpr std::uint64_t Prime4{0x85EBCA77C2B2AE63ULL};
+constexpr std::uint64_t Prime5{0x27D4EB2F165667C5ULL};
+
+/// Bytes per stripe of the four-lane main loop.
+constexpr std::size_t Stripe{32};
+
+/// Files are hashed through a buffer of this many bytes.
+constexpr std::size_t ReadSize{256UZ * 1024UZ};
+
+template <typename Word>
+auto read_le(const unsigned char* bytes) noexcept -> Word {
+  Word word;
+  std::memcpy(&word, bytes, sizeof word);
+  if constexpr (std::endian::native == std::endian::big) {
+    word = std::byteswap(word);
+  }
+  return word;
+}
+
+constexpr auto round(std::uint64_t lane, std::uint64_t input) noexcept
+    -> std::uint64_t {
+  return std::rotl(lane + (input * Prime2), 31) * Prime1;
+}
+
+constexpr auto merge_round(std::uint64_t hash, std::uint64_t lane) noexcept
+    -> std::uint64_t {
+  return ((hash ^ round(0, lane)) * Prime1) + Prime4;
+}
+
+/// \brief XXH64 state, fed in pieces so a file never needs to be in memory
+/// whole.
+class Hasher {
+ public:
+  auto update(std::span<const unsigned char> bytes) noexcept -> void {
+    length_ += bytes.size();
+    if (buffered_ != 0) {
+      const auto take{std::min(Stripe - buffered_, bytes.size())};
+      std::memcpy(buffer_.data() + buffered_, bytes.data(), take);
+      buffered_ += take;
+      bytes = bytes.subspan(take);
+      if (buffered_ < Stripe) {
+        return;
+      }
+      consume(buffer_.data());
+      buffered_ = 0;
+    }
+    while (bytes.size() >= Stripe) {
+      consume(bytes.data());
+      bytes = bytes.subspan(Stripe);
+    }
+    std::memcpy(buffer_.data(), bytes.data(), bytes.size());
+    buffered_ = bytes.size();
+  }
+
+  auto digest() const noexcept -> content::Hash {
+    std::uint64_t hash{Prime5};
+    if (length_ >= Stripe) {
+      hash = std::rotl(lanes_[0], 1) + std::rotl(lanes_[1], 7) +
+             std::rotl(lanes_[2], 12) + std::rotl(lanes_[3], 18);
+      for (const auto lane : lanes_) {
+        hash = merge_round(hash, lane);
+      }
+    }
+    hash += length_;
+
+    const auto* tail{buffer_.data()};
+    const auto* const end{buffer_.data() + buffered_};
+    for (; tail + 8 <= end; tail += 8) {
+      hash ^= round(0, read_le<std::uint64_t>(tail));
+      hash = (std::rotl(hash, 27) * Prime1) + Prime4;
+    }
+    if (tail + 4 <= end) {
+      hash ^= std::uint64_t{read_le<std::uint32_t>(tail)} * Prime1;
+      hash = (std::rotl(hash, 23) * Prime2) + Prime3;
+      tail += 4;
+    }
+    for (; tail < end; ++tail) {
+      hash ^= *tail * Prime5;
+      hash = std::rotl(hash, 11) * Prime1;
+    }
+
+    hash ^= hash >> 33U;
+    hash *= Prime2;
+    hash ^= hash >> 29U;
+    hash *= Prime3;
+    hash ^= hash >> 32U;
+    return hash;
+  }
+
+ private:
+  auto consume(const unsigned char* stripe) noexcept -> void {
+    for (std::size_t lane{0}; lane < 4; ++lane) {
+      lanes_[lane] =
+          round(lanes_[lane], read_le<std::uint64_t>(stripe + (lane * 8)));
+    }
+  }
+
+  std::array<std::uint64_t, 4> lanes_{Prime1 + Prime2, Prime2, 0, 0 - Prime1};
+  std::array<unsigned char, Stripe> buffer_{};
+  std::size_t buffered_{0};
+  std::uint64_t length_{0};
+};
+
+}  // namespace
+
+auto content::hash_bytes(std::span<const unsigned char> bytes) noexcept
+    -> Hash {
+  Hasher hasher;
+  hasher.update(bytes);
+  return hasher.digest();
+}
+
+auto content::hash_file(const std::filesystem::path& path) noexcept
+    -> std::optional<Hash> {
+  try {
+    std::ifstream file{path, std::ios::binary};
+    if (not file) {
+      return std::nullopt;
+    }
+    Hasher hasher;
+    std::vector<char> buffer(ReadSize);
+    while (file.read(buffer.data(), static_cast<std::streamsize>(ReadSize)) or
+           file.gcount() > 0) {
+      hasher.update({reinterpret_cast<const unsigned char*>(buffer.data()),
+                     static_cast<std::size_t>(file.gcount())});
+    }
+    if (file.bad()) {
+      return std::nullopt;
+    }
+    return hasher.digest();
+  } catch (...) {
+    return std::nullopt;
+  }
+}
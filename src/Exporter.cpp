@@ -0,0 +1,191 @@
+#include "csc/Exporter.hpp"
+
+#include <cerrno>
+#include <format>
+#include <iterator>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace csc::exporter;  // NOLINT
+
+namespace {
+
+auto write_fd(int fd, const char* data, std::size_t size) -> void {
+  while (size != 0) {
+#if defined(_WIN32)
+    const auto written{_write(fd, data, static_cast<unsigned>(size))};
+#else
+    const auto written{::write(fd, data, size)};
+#endif
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error{errno, std::generic_category(),
+                              "Failed to write export"};
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+}
+
+}  // namespace
+
+Exporter::Exporter(std::ostream& out, Format format)
+    : sink_{&out}, format_{format} {
+  buffer_.reserve(FlushThreshold * 2);
+  if (format_ == Format::Csv) {
+    buffer_ += CsvHeader;
+    buffer_ += '\n';
+  }
+}
+Exporter::Exporter(int fd, Format format) : sink_{fd}, format_{format} {
+  buffer_.reserve(FlushThreshold * 2);
+  if (format_ == Format::Csv) {
+    buffer_ += CsvHeader;
+    buffer_ += '\n';
+  }
+}
+Exporter::~Exporter() noexcept {
+  try {
+    flush();
+  } catch (...) {
+    // Nothing sensible to do with a failed write while unwinding.
+  }
+}
+
+auto Exporter::write(const ImageRecord& image) -> void {
+  switch (format_) {
+    case Format::Csv: {
+      append_csv_record(buffer_, image);
+      break;
+    }
+    case Format::JsonLines: {
+      append_json_record(buffer_, image);
+      break;
+    }
+  }
+  buffer_ += '\n';
+  ++records_written_;
+
+  if (buffer_.size() >= FlushThreshold) {
+    write_out();
+  }
+}
+
+auto Exporter::flush() -> void {
+  write_out();
+  if (auto* const* out = std::get_if<std::ostream*>(&sink_)) {
+    (*out)->flush();
+  }
+}
+
+auto Exporter::write_out() -> void {
+  if (buffer_.empty()) {
+    return;
+  }
+  if (auto* const* out = std::get_if<std::ostream*>(&sink_)) {
+    (*out)->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  } else {
+    write_fd(std::get<int>(sink_), buffer_.data(), buffer_.size());
+  }
+  buffer_.clear();
+}
+
+auto csc::exporter::append_json_string(std::string& out,
+                                       std::string_view text) -> void {
+  out += '"';
+  for (const char c : text) {
+    switch (c) {
+      case '"': {
+        out += "\\\"";
+        break;
+      }
+      case '\\': {
+        out += "\\\\";
+        break;
+      }
+      case '\n': {
+        out += "\\n";
+        break;
+      }
+      case '\r': {
+        out += "\\r";
+        break;
+      }
+      case '\t': {
+        out += "\\t";
+        break;
+      }
+      default: {
+        if (static_cast<unsigned char>(c) < 0x20U) {
+          std::format_to(std::back_inserter(out), "\\u{:04x}",
+                         static_cast<unsigned>(c));
+        } else {
+          out += c;
+        }
+        break;
+      }
+    }
+  }
+  out += '"';
+}
+
+auto csc::exporter::append_json_record(std::string& out,
+                                       const ImageRecord& image) -> void {
+  std::format_to(std::back_inserter(out), R"({{"id":{},"title":)",
+                 image.get_id());
+  append_json_string(out, image.get_title());
+  out += R"(,"description":)";
+  append_json_string(out, image.get_description());
+  out += R"(,"genre":)";
+  append_json_string(out, image.get_genre().name());
+  out += R"(,"date_taken":")";
+  image.get_date_taken().format_iso8601_to(std::back_inserter(out));
+  out += R"(","thumbnail_path":)";
+  append_json_string(out,
+                     paths::dictionary().text(image.get_thumbnail_id()));
+  out += R"(,"tags":)";
+  out += '"';
+  tags::append_list(out, image.get_tags());
+  out += '"';
+  out += '}';
+}
+
+auto csc::exporter::append_csv_field(std::string& out,
+                                     std::string_view text) -> void {
+  if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+    out += text;
+    return;
+  }
+  out += '"';
+  for (const char c : text) {
+    if (c == '"') {
+      out += '"';
+    }
+    out += c;
+  }
+  out += '"';
+}
+
+auto csc::exporter::append_csv_record(std::string& out,
+                                      const ImageRecord& image) -> void {
+  std::format_to(std::back_inserter(out), "{},", image.get_id());
+  append_csv_field(out, image.get_title());
+  out += ',';
+  append_csv_field(out, image.get_description());
+  out += ',';
+  out += image.get_genre().name();
+  out += ',';
+  image.get_date_taken().format_iso8601_to(std::back_inserter(out));
+  out += ',';
+  append_csv_field(out,
+                   paths::dictionary().text(image.get_thumbnail_id()));
+  out += ',';
+  tags::append_list(out, image.get_tags());
+}
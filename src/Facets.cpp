@@ -0,0 +1,222 @@
+#include "csc/Facets.hpp"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+
+using namespace csc;         // NOLINT
+using namespace csc::facet;  // NOLINT
+
+namespace {
+
+auto find_row(std::vector<Row>& rows, Bucket bucket) noexcept
+    -> std::vector<Row>::iterator {
+  return std::ranges::lower_bound(rows, bucket, {}, &Row::bucket);
+}
+
+/// Each period's rows, in `Period` order.
+constexpr std::array<snapshot::Section, PeriodCount> Sections{
+    snapshot::Section::FacetDays, snapshot::Section::FacetMonths,
+    snapshot::Section::FacetYears};
+
+auto add_counts(GenreCounts& into, const GenreCounts& from) noexcept -> void {
+  for (std::size_t genre{0}; genre < into.size(); ++genre) {
+    into[genre] += from[genre];
+  }
+}
+
+}  // namespace
+
+auto facet::period_from_name(std::string_view name) noexcept
+    -> std::optional<Period> {
+  for (std::size_t i{0}; i < PeriodCount; ++i) {
+    const auto period{static_cast<Period>(i)};
+    if (period_name(period) == name) {
+      return period;
+    }
+  }
+  return std::nullopt;
+}
+
+auto facet::bucket_of(const std::chrono::year_month_day& date,
+                      Period period) noexcept -> Bucket {
+  switch (period) {
+    case Period::Day: {
+      return static_cast<Bucket>(
+          std::chrono::sys_days{date}.time_since_epoch().count());
+    }
+    case Period::Month: {
+      return (static_cast<int>(date.year()) * 12) +
+             static_cast<int>(static_cast<unsigned>(date.month())) - 1;
+    }
+    case Period::Year: {
+      return static_cast<int>(date.year());
+    }
+  }
+  return 0;
+}
+
+auto facet::format_bucket(Bucket bucket, Period period) -> std::string {
+  switch (period) {
+    case Period::Day: {
+      const std::chrono::sys_days day{std::chrono::days{bucket}};
+      return std::format("{:%F}", std::chrono::year_month_day{day});
+    }
+    case Period::Month: {
+      // Floor division, so months before year 0 still land in their year.
+      const auto year{bucket >= 0 ? bucket / 12 : ((bucket + 1) / 12) - 1};
+      return std::format("{:04}-{:02}", year, bucket - (year * 12) + 1);
+    }
+    case Period::Year: {
+      return std::format("{:04}", bucket);
+    }
+  }
+  return {};
+}
+
+auto facet::Row::total() const noexcept -> std::uint64_t {
+  std::uint64_t sum{0};
+  for (const auto count : genres) {
+    sum += count;
+  }
+  return sum;
+}
+
+auto facet::Counter::find_or_insert(Bucket bucket) -> Row& {
+  auto& rows{facets_.rows};
+  if (rows.empty() or rows.back().bucket < bucket) {
+    return rows.emplace_back(Row{.bucket = bucket});
+  }
+  const auto at{find_row(rows, bucket)};
+  if (at->bucket == bucket) {
+    return *at;
+  }
+  return *rows.insert(at, Row{.bucket = bucket});
+}
+
+auto facet::count(const ImageAlbum& images, Period period) -> Facets {
+  Counter counter{period};
+  for (const auto& image : images) {
+    counter.add(image);
+  }
+  return counter.take();
+}
+
+auto facet::merge(Facets& into, const Facets& from) -> void {
+  into.total += from.total;
+  add_counts(into.genres, from.genres);
+
+  std::vector<Row> rows;
+  rows.reserve(into.rows.size() + from.rows.size());
+  auto ours{into.rows.begin()};
+  auto theirs{from.rows.begin()};
+  while (ours != into.rows.end() or theirs != from.rows.end()) {
+    if (theirs == from.rows.end() or
+        (ours != into.rows.end() and ours->bucket < theirs->bucket)) {
+      rows.push_back(*ours++);
+    } else if (ours == into.rows.end() or theirs->bucket < ours->bucket) {
+      rows.push_back(*theirs++);
+    } else {
+      add_counts(ours->genres, theirs->genres);
+      rows.push_back(*ours++);
+      ++theirs;
+    }
+  }
+  into.rows = std::move(rows);
+}
+
+auto facet::write_text(std::ostream& out, const Facets& facets) -> void {
+  std::string text;
+  std::format_to(std::back_inserter(text), "{} images\n", facets.total);
+  for (std::size_t genre{0}; genre < facets.genres.size(); ++genre) {
+    std::format_to(std::back_inserter(text), "  {:<13}{}\n",
+                   ImageRecord::Genre::from_index(genre).name(),
+                   facets.genres[genre]);
+  }
+  for (const auto& row : facets.rows) {
+    std::format_to(std::back_inserter(text), "{} {}:",
+                   format_bucket(row.bucket, facets.period), row.total());
+    for (std::size_t genre{0}; genre < row.genres.size(); ++genre) {
+      if (row.genres[genre] != 0) {
+        std::format_to(std::back_inserter(text), " {} {}",
+                       ImageRecord::Genre::from_index(genre).name(),
+                       row.genres[genre]);
+      }
+    }
+    text += '\n';
+  }
+  out << text;
+}
+
+auto facet::Rollup::add(const ImageRecord& image) -> void {
+  const auto date{image.get_date_taken().get_date()};
+  const auto genre{image.get_genre().index()};
+  for (std::size_t i{0}; i < PeriodCount; ++i) {
+    auto& rows{rows_[i].owned()};
+    const auto bucket{bucket_of(date, static_cast<Period>(i))};
+    auto at{find_row(rows, bucket)};
+    if (at == rows.end() or at->bucket != bucket) {
+      at = rows.insert(at, Row{.bucket = bucket});
+    }
+    ++at->genres[genre];
+  }
+  ++genres_[genre];
+  ++total_;
+}
+
+auto facet::Rollup::remove(const ImageRecord& image) -> void {
+  const auto date{image.get_date_taken().get_date()};
+  const auto genre{image.get_genre().index()};
+  for (std::size_t i{0}; i < PeriodCount; ++i) {
+    auto& rows{rows_[i].owned()};
+    const auto bucket{bucket_of(date, static_cast<Period>(i))};
+    const auto at{find_row(rows, bucket)};
+    if (at == rows.end() or at->bucket != bucket or at->genres[genre] == 0) {
+      continue;
+    }
+    if (--at->genres[genre] == 0 and at->total() == 0) {
+      rows.erase(at);
+    }
+  }
+  if (genres_[genre] != 0) {
+    --genres_[genre];
+    --total_;
+  }
+}
+
+auto facet::Rollup::clear() noexcept -> void {
+  for (auto& rows : rows_) {
+    rows.clear();
+  }
+  genres_ = {};
+  total_ = 0;
+}
+
+auto facet::Rollup::facets(Period period) const -> Facets {
+  const auto& rows{rows_[static_cast<std::size_t>(period)]};
+  return Facets{.period = period,
+                .total = total_,
+                .genres = genres_,
+                .rows = {rows.begin(), rows.end()}};
+}
+
+auto facet::Rollup::save(snapshot::Writer& writer) const -> void {
+  for (std::size_t i{0}; i < PeriodCount; ++i) {
+    writer.add(Sections[i], rows_[i].view());
+  }
+}
+
+auto facet::Rollup::load(const snapshot::Snapshot& snapshot) -> void {
+  for (std::size_t i{0}; i < PeriodCount; ++i) {
+    rows_[i].borrow(snapshot.section<Row>(Sections[i]));
+  }
+  // Every record is in exactly one year, so the years sum to the totals.
+  genres_ = {};
+  for (const auto& row : rows_[static_cast<std::size_t>(Period::Year)]) {
+    add_counts(genres_, row.genres);
+  }
+  total_ = 0;
+  for (const auto count : genres_) {
+    total_ += count;
+  }
+}
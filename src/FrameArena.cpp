@@ -0,0 +1,50 @@
+#include "csc/FrameArena.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+using namespace csc;         // NOLINT
+using namespace csc::frame;  // NOLINT
+
+frame::Arena::Arena(std::size_t capacity)
+    : block_{std::make_unique_for_overwrite<std::byte[]>(capacity)},
+      capacity_{capacity} {}
+
+auto frame::Arena::allocate(std::size_t bytes, std::size_t alignment)
+    -> void* {
+  const auto start{(used_ + alignment - 1) & ~(alignment - 1)};
+  if (start + bytes <= capacity_) {
+    used_ = start + bytes;
+    return block_.get() + start;
+  }
+  // Extra blocks come from operator new[], aligned for any fundamental type.
+  // Count the padding this may need once it shares the next frame's block.
+  overflow_.push_back(std::make_unique_for_overwrite<std::byte[]>(bytes));
+  overflow_bytes_ += bytes + alignment;
+  return overflow_.back().get();
+}
+
+auto frame::Arena::copy(std::string_view text) -> std::string_view {
+  auto* const out{static_cast<char*>(allocate(text.size() + 1, 1))};
+  std::ranges::copy(text, out);
+  out[text.size()] = '\0';
+  return {out, text.size()};
+}
+
+auto frame::Arena::vformat(std::string_view fmt, std::format_args args)
+    -> std::string_view {
+  scratch_.clear();
+  std::vformat_to(std::back_inserter(scratch_), fmt, args);
+  return copy(scratch_);
+}
+
+auto frame::Arena::reset() -> void {
+  if (not overflow_.empty()) {
+    capacity_ = std::bit_ceil(used_ + overflow_bytes_);
+    overflow_.clear();
+    overflow_bytes_ = 0;
+    block_ = std::make_unique_for_overwrite<std::byte[]>(capacity_);
+  }
+  used_ = 0;
+}
@@ -0,0 +1,100 @@
+#include "csc/IdIndex.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace csc;  // NOLINT
+
+auto IdIndex::at(std::size_t id) const -> std::size_t {
+  if (const auto slot = find(id)) {
+    return *slot;
+  }
+  throw std::out_of_range{"No record with that id"};
+}
+
+auto IdIndex::assign(std::size_t id, std::size_t slot) -> void {
+  if ((size_ + 1) * 2 > entries_.size()) {
+    grow();
+  }
+  auto& entries{entries_.owned()};
+  const auto mask{entries.size() - 1};
+  for (auto at{home(id) & mask};; at = (at + 1) & mask) {
+    if (entries[at].id == id) {
+      entries[at].slot = slot;
+      return;
+    }
+    if (entries[at].id == Empty) {
+      entries[at] = {.id = id, .slot = slot};
+      ++size_;
+      return;
+    }
+  }
+}
+
+auto IdIndex::erase(std::size_t id) -> bool {
+  if (not find(id)) {
+    return false;
+  }
+  auto& entries{entries_.owned()};
+  const auto mask{entries.size() - 1};
+  auto hole{home(id) & mask};
+  while (entries[hole].id != id) {
+    hole = (hole + 1) & mask;
+  }
+  // Later entries of the run move back into the hole unless that would put
+  // them before their home, so no probe ever stops early at a gap.
+  for (auto next{(hole + 1) & mask}; entries[next].id != Empty;
+       next = (next + 1) & mask) {
+    const auto from_home{(next - home(entries[next].id)) & mask};
+    if (from_home >= ((next - hole) & mask)) {
+      entries[hole] = entries[next];
+      hole = next;
+    }
+  }
+  entries[hole].id = Empty;
+  --size_;
+  return true;
+}
+
+auto IdIndex::clear() noexcept -> void {
+  entries_.clear();
+  size_ = 0;
+}
+
+auto IdIndex::save(snapshot::Writer& writer) const -> void {
+  writer.add(snapshot::Section::IdTable, entries_.view());
+  writer.add_value(snapshot::Section::IdCount, std::uint64_t{size_});
+}
+
+auto IdIndex::load(const snapshot::Snapshot& snapshot) -> void {
+  const auto entries{snapshot.section<Entry>(snapshot::Section::IdTable)};
+  const auto count{
+      snapshot.value<std::uint64_t>(snapshot::Section::IdCount)};
+  if (not entries.empty() and
+      (not std::has_single_bit(entries.size()) or count * 2 > entries.size())) {
+    throw std::runtime_error{"Snapshot id table is malformed"};
+  }
+  entries_.borrow(entries);
+  size_ = count;
+}
+
+auto IdIndex::grow() -> void {
+  const auto capacity{std::max(MinCapacity, entries_.size() * 2)};
+  std::vector<Entry> grown(capacity, Entry{.id = Empty, .slot = 0});
+  const auto mask{capacity - 1};
+  for (const auto& entry : entries_) {
+    if (entry.id == Empty) {
+      continue;
+    }
+    auto at{home(entry.id) & mask};
+    while (grown[at].id != Empty) {
+      at = (at + 1) & mask;
+    }
+    grown[at] = entry;
+  }
+  entries_.clear();
+  entries_.owned() = std::move(grown);
+}
@@ -0,0 +1,202 @@
+#include "csc/ImageProbe.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <system_error>
+
+#include "csc/Parallel.hpp"
+
+using namespace csc;  // NOLINT
+
+namespace {
+
+/// Enough for a PNG header, and for most JPEGs up to their SOF segment.
+constexpr std::size_t BufferSize{4096};
+/// Records a worker claims at a time in `probe_all`.
+constexpr std::size_t ProbeBatch{64};
+
+constexpr std::array<unsigned char, 8> PngSignature{0x89, 'P',  'N',  'G',
+                                                    '\r', '\n', 0x1A, '\n'};
+
+/// \brief Windowed reads of a file header, refilling (and seeking) only when
+/// a request falls outside the bytes already read.
+class HeaderReader {
+ public:
+  explicit HeaderReader(std::ifstream& file) noexcept : file_{file} {}
+
+  /// \return `count` bytes starting at `offset`, or nullptr past the end of
+  /// the file.
+  auto at(std::uint64_t offset, std::size_t count) -> const unsigned char* {
+    if (offset < start_ or offset + count > start_ + size_) {
+      refill(offset);
+    }
+    if (offset + count > start_ + size_) {
+      return nullptr;
+    }
+    return buffer_.data() + (offset - start_);
+  }
+
+ private:
+  auto refill(std::uint64_t offset) -> void {
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(offset));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file_.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+    start_ = offset;
+    size_ = static_cast<std::size_t>(file_.gcount());
+  }
+
+  std::ifstream& file_;
+  std::array<unsigned char, BufferSize> buffer_{};
+  std::uint64_t start_{0};
+  std::size_t size_{0};
+};
+
+constexpr auto big_endian16(const unsigned char* bytes) noexcept
+    -> std::uint32_t {
+  return (std::uint32_t{bytes[0]} << 8U) | bytes[1];
+}
+constexpr auto big_endian32(const unsigned char* bytes) noexcept
+    -> std::uint32_t {
+  return (big_endian16(bytes) << 16U) | big_endian16(bytes + 2);
+}
+
+/// \brief The signature is followed by the IHDR chunk: length, type, width,
+/// height, bit depth and colour type.
+auto probe_png(HeaderReader& reader) -> std::optional<ImageInfo> {
+  const auto* const ihdr{reader.at(PngSignature.size(), 18)};
+  if (ihdr == nullptr or std::memcmp(ihdr + 4, "IHDR", 4) != 0) {
+    return std::nullopt;
+  }
+
+  std::uint8_t channels{0};
+  switch (ihdr[17]) {
+    case 0: {  // Greyscale
+      channels = 1;
+      break;
+    }
+    case 2:    // Truecolour
+    case 3: {  // Indexed, decoded to RGB
+      channels = 3;
+      break;
+    }
+    case 4: {  // Greyscale with alpha
+      channels = 2;
+      break;
+    }
+    case 6: {  // Truecolour with alpha
+      channels = 4;
+      break;
+    }
+    default: {
+      return std::nullopt;
+    }
+  }
+  return ImageInfo{.format = ImageInfo::Format::Png,
+                   .width = big_endian32(ihdr + 8),
+                   .height = big_endian32(ihdr + 12),
+                   .channels = channels};
+}
+
+/// \brief Walks the marker segments after SOI until the first start of frame,
+/// skipping (without reading) everything in between, such as EXIF blocks.
+auto probe_jpeg(HeaderReader& reader) -> std::optional<ImageInfo> {
+  std::uint64_t offset{2};
+  while (true) {
+    const auto* const segment{reader.at(offset, 2)};
+    if (segment == nullptr or segment[0] != 0xFF) {
+      return std::nullopt;
+    }
+    const auto marker{segment[1]};
+
+    if (marker == 0xFF) {  // Fill byte
+      ++offset;
+      continue;
+    }
+    // Standalone markers carry no length.
+    if (marker == 0x01 or marker == 0xD8 or
+        (marker >= 0xD0 and marker <= 0xD7)) {
+      offset += 2;
+      continue;
+    }
+    if (marker == 0xD9 or marker == 0xDA) {  // EOI or SOS before any frame
+      return std::nullopt;
+    }
+
+    const auto* const header{reader.at(offset, 10)};
+    if (header == nullptr) {
+      return std::nullopt;
+    }
+    const auto length{big_endian16(header + 2)};
+    if (length < 2) {
+      return std::nullopt;
+    }
+
+    // SOF0 to SOF15, except DHT (C4), JPG (C8) and DAC (CC).
+    const bool is_frame{marker >= 0xC0 and marker <= 0xCF and
+                        marker != 0xC4 and marker != 0xC8 and marker != 0xCC};
+    if (is_frame) {
+      return ImageInfo{.format = ImageInfo::Format::Jpeg,
+                       .width = big_endian16(header + 7),
+                       .height = big_endian16(header + 5),
+                       .channels = header[9]};
+    }
+    offset += 2 + length;
+  }
+}
+
+}  // namespace
+
+auto probe::probe_file(const std::filesystem::path& path) noexcept
+    -> std::optional<ImageInfo> {
+  try {
+    std::ifstream file{path, std::ios::binary};
+    if (not file) {
+      return std::nullopt;
+    }
+    HeaderReader reader{file};
+    const auto* const magic{reader.at(0, PngSignature.size())};
+    if (magic == nullptr) {
+      return std::nullopt;
+    }
+
+    std::optional<ImageInfo> info;
+    if (std::ranges::equal(std::span{magic, PngSignature.size()},
+                           PngSignature)) {
+      info = probe_png(reader);
+    } else if (magic[0] == 0xFF and magic[1] == 0xD8) {
+      info = probe_jpeg(reader);
+    }
+    if (not info or info->width == 0 or info->height == 0) {
+      return std::nullopt;
+    }
+
+    std::error_code error;
+    const auto size{std::filesystem::file_size(path, error)};
+    info->file_size = error ? 0 : size;
+    return info;
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+auto probe::probe_all(std::span<ImageRecord> images,
+                      std::size_t threads) -> std::size_t {
+  std::atomic<std::size_t> probed{0};
+  parallel::for_each_batch(
+      images.size(), ProbeBatch, threads,
+      [&images, &probed](std::size_t begin, std::size_t end) {
+        for (auto i{begin}; i < end; ++i) {
+          if (auto info = probe_file(images[i].get_thumbnail_path())) {
+            images[i].set_info(*info);
+            ++probed;
+          }
+        }
+      });
+  return probed;
+}
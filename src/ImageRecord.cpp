@@ -7,21 +7,61 @@ consteval auto operator""_UZ(unsigned long long n) noexcept -> size_t {
 }
 
 constexpr size_t BeginId{1_UZ};
-size_t ImageRecord::next_id{BeginId};
+std::atomic<std::size_t> ImageRecord::next_id{BeginId};
 
-ImageRecord::ImageRecord(std::string title, std::string description,
+ImageRecord::ImageRecord(std::string_view title, std::string_view description,
                          Genre genre, DateType time,
-                         std::filesystem::path thumbnail_path)
-    : title_(std::move(title)),
-      description_(std::move(description)),
+                         const std::filesystem::path& thumbnail_path,
+                         allocator_type allocator)
+    : title_(title, allocator),
+      description_(description, allocator),
       genre_(genre),
       date_taken_(time),
-      thumbnail_path_(std::move(thumbnail_path)) {}
+      thumbnail_path_(paths::dictionary().intern(thumbnail_path)) {}
+
+ImageRecord::ImageRecord(const ImageRecord& other, allocator_type allocator)
+    : title_(other.title_, allocator),
+      description_(other.description_, allocator),
+      thumbnail_path_(other.thumbnail_path_),
+      date_taken_(other.date_taken_),
+      info_(other.info_),
+      perceptual_hash_(other.perceptual_hash_),
+      content_hash_(other.content_hash_),
+      colour_signature_(other.colour_signature_),
+      id_(other.id_),
+      genre_(other.genre_),
+      tags_(other.tags_),
+      removed_(other.removed_) {}
+
+ImageRecord::ImageRecord(ImageRecord&& other, allocator_type allocator)
+    : title_(std::move(other.title_), allocator),
+      description_(std::move(other.description_), allocator),
+      thumbnail_path_(other.thumbnail_path_),
+      date_taken_(other.date_taken_),
+      info_(other.info_),
+      perceptual_hash_(other.perceptual_hash_),
+      content_hash_(other.content_hash_),
+      colour_signature_(other.colour_signature_),
+      id_(other.id_),
+      genre_(other.genre_),
+      tags_(std::move(other.tags_)),
+      removed_(other.removed_) {}
+
+auto ImageRecord::renumber(std::span<ImageRecord> images,
+                           std::size_t first) noexcept -> void {
+  // The ids from `first` up to `next_id` all belong to `images` then.
+  if (next_id.load() != first + images.size()) {
+    first = next_id.fetch_add(images.size());
+  }
+  for (auto& image : images) {
+    image.id_ = first++;
+  }
+}
 
 auto ImageRecord::to_string() const noexcept -> std::string {
-  return std::format(
-      "Id: {}, Title: {}, Description: {}, Genre: {}, Date taken: {}", id_,
-      title_, description_, genre_.to_string(), date_taken_.to_string());
+  std::string result;
+  format_to(std::back_inserter(result));
+  return result;
 }
 
 auto operator<<(std::ostream& os, const ImageRecord& image) -> std::ostream& {
@@ -0,0 +1,609 @@
+#include "csc/Importer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "csc/ImageManager.hpp"
+#include "csc/Ingest.hpp"
+#include "csc/Parallel.hpp"
+#include "csc/Tags.hpp"
+#include "csc/Trace.hpp"
+#include "csc/date.hpp"
+
+using namespace csc;            // NOLINT
+using namespace csc::importer;  // NOLINT
+
+namespace {
+
+/// Below this a chunk is not worth handing to another thread.
+constexpr std::size_t MinChunkSize{256UZ * 1024UZ};
+/// More chunks than threads, so one slow chunk does not hold up the rest.
+constexpr std::size_t ChunksPerThread{4};
+
+enum Field : std::size_t {
+  Title,
+  Description,
+  Genre,
+  DateTaken,
+  ThumbnailPath,
+  /// Optional; the fields before it are required.
+  Tags,
+  FieldCount,
+};
+constexpr std::size_t Ignored{FieldCount};
+
+using Fields = std::array<std::string, FieldCount>;
+
+auto field_for(std::string_view name) noexcept -> std::size_t {
+  static constexpr std::array<std::pair<std::string_view, Field>, 8> Names{{
+      {"title", Title},
+      {"description", Description},
+      {"genre", Genre},
+      {"date_taken", DateTaken},
+      {"date", DateTaken},
+      {"thumbnail_path", ThumbnailPath},
+      {"path", ThumbnailPath},
+      {"tags", Tags},
+  }};
+  for (const auto& [known, field] : Names) {
+    if (known == name) {
+      return field;
+    }
+  }
+  return Ignored;
+}
+
+struct ChunkResult {
+  std::vector<ImageRecord> records;
+  /// Lines are relative to the start of the chunk.
+  std::vector<ImportError> errors;
+  /// Number of line breaks consumed, to offset the following chunk.
+  std::size_t lines{0};
+};
+
+/// \return Why the row was rejected, or nothing if a record was added.
+auto make_record(Fields& fields, std::vector<ImageRecord>& out)
+    -> std::optional<std::string_view> {
+  if (fields[Title].empty()) {
+    return "missing title";
+  }
+  const auto genre{ImageRecord::Genre::from_name(fields[Genre])};
+  if (not genre) {
+    return "unknown genre";
+  }
+  const auto date{date::parse_iso8601(fields[DateTaken])};
+  if (not date) {
+    return "date_taken is not an ISO-8601 date";
+  }
+  if (fields[ThumbnailPath].empty()) {
+    return "missing thumbnail_path";
+  }
+  tags::TagSet tag_set;
+  try {
+    tag_set = tags::parse_list(fields[Tags]);
+  } catch (const std::invalid_argument&) {
+    return "invalid tag name";
+  }
+  out.emplace_back(std::move(fields[Title]), std::move(fields[Description]),
+                   *genre, *date,
+                   std::filesystem::path{std::move(fields[ThumbnailPath])});
+  out.back().set_tags(std::move(tag_set));
+  return std::nullopt;
+}
+
+auto clear(Fields& fields) noexcept -> void {
+  for (auto& field : fields) {
+    field.clear();
+  }
+}
+
+/// \brief Splits `text` into pieces of at least `target` bytes that each end
+/// on a row boundary. With `csv`, line breaks inside quotes are not
+/// boundaries.
+auto split(std::string_view text, std::size_t target,
+           bool csv) -> std::vector<std::string_view> {
+  std::vector<std::string_view> chunks;
+  std::size_t start{0};
+
+  if (csv) {
+    bool quoted{false};
+    for (std::size_t at{0}; at < text.size(); ++at) {
+      const auto c{text[at]};
+      if (c == '"') {
+        quoted = not quoted;
+      } else if (c == '\n' and not quoted and at + 1 - start >= target) {
+        chunks.push_back(text.substr(start, at + 1 - start));
+        start = at + 1;
+      }
+    }
+  } else {
+    while (text.size() - start > target) {
+      const auto newline{text.find('\n', start + target)};
+      if (newline == std::string_view::npos) {
+        break;
+      }
+      chunks.push_back(text.substr(start, newline + 1 - start));
+      start = newline + 1;
+    }
+  }
+
+  if (start < text.size()) {
+    chunks.push_back(text.substr(start));
+  }
+  return chunks;
+}
+
+/// \brief Consumes one line ending (`\n`, `\r\n` or `\r`) if there is one.
+auto skip_line_end(std::string_view text, std::size_t& at) noexcept -> bool {
+  if (at < text.size() and text[at] == '\r') {
+    ++at;
+    if (at < text.size() and text[at] == '\n') {
+      ++at;
+    }
+    return true;
+  }
+  if (at < text.size() and text[at] == '\n') {
+    ++at;
+    return true;
+  }
+  return false;
+}
+
+auto parse_csv_chunk(std::string_view text,
+                     std::span<const std::size_t> columns) -> ChunkResult {
+  std::size_t wanted{0};
+  for (std::size_t column{0}; column < columns.size(); ++column) {
+    if (columns[column] != Ignored) {
+      wanted = column + 1;
+    }
+  }
+
+  ChunkResult result;
+  Fields fields;
+  std::string ignored;
+  std::size_t at{0};
+  std::size_t line{1};
+
+  while (at < text.size()) {
+    const auto row_line{line};
+    if (skip_line_end(text, at)) {
+      ++line;
+      continue;
+    }
+
+    clear(fields);
+    std::size_t column{0};
+    bool malformed{false};
+    while (true) {
+      ignored.clear();
+      auto& field{column < columns.size() and columns[column] != Ignored
+                      ? fields[columns[column]]
+                      : ignored};
+
+      const bool quoted{at < text.size() and text[at] == '"'};
+      if (quoted) {
+        ++at;
+        while (true) {
+          const auto quote{text.find('"', at)};
+          const auto piece{text.substr(at, quote - at)};
+          line += static_cast<std::size_t>(std::ranges::count(piece, '\n'));
+          field += piece;
+          if (quote == std::string_view::npos) {
+            malformed = true;
+            at = text.size();
+            break;
+          }
+          at = quote + 1;
+          if (at < text.size() and text[at] == '"') {
+            field += '"';
+            ++at;
+            continue;
+          }
+          break;
+        }
+      }
+
+      // Anything between a closing quote and the delimiter is an error; an
+      // unquoted field is everything up to the delimiter.
+      const auto end{std::min(text.find_first_of(",\r\n", at), text.size())};
+      if (not quoted) {
+        field.append(text.substr(at, end - at));
+      } else if (at != end) {
+        malformed = true;
+      }
+      at = end;
+      ++column;
+
+      if (at < text.size() and text[at] == ',') {
+        ++at;
+        continue;
+      }
+      break;
+    }
+    skip_line_end(text, at);
+    ++line;
+
+    if (malformed) {
+      result.errors.push_back({row_line, "malformed quoted field"});
+    } else if (column < wanted) {
+      result.errors.push_back(
+          {row_line, std::format("expected at least {} columns, found {}",
+                                 wanted, column)});
+    } else if (auto error = make_record(fields, result.records)) {
+      result.errors.push_back({row_line, std::string{*error}});
+    }
+  }
+
+  result.lines = line - 1;
+  return result;
+}
+
+/// \brief Reads one flat JSON object. Only string values are kept; numbers,
+/// booleans and null are skipped and nested values are rejected.
+class JsonLine {
+ public:
+  explicit JsonLine(std::string_view text) noexcept : text_{text} {}
+
+  /// \return Why the line was rejected, or nothing on success.
+  auto parse(Fields& fields) -> std::optional<std::string_view> {
+    skip_space();
+    if (not consume('{')) {
+      return "expected a JSON object";
+    }
+    skip_space();
+    if (consume('}')) {
+      return finish();
+    }
+    while (true) {
+      skip_space();
+      key_.clear();
+      if (not string(key_)) {
+        return "expected a string key";
+      }
+      skip_space();
+      if (not consume(':')) {
+        return "expected ':'";
+      }
+      skip_space();
+
+      const auto field{field_for(key_)};
+      if (at_ < text_.size() and text_[at_] == '"') {
+        ignored_.clear();
+        if (not string(field == Ignored ? ignored_ : fields[field])) {
+          return "malformed string";
+        }
+      } else if (at_ < text_.size() and
+                 (text_[at_] == '{' or text_[at_] == '[')) {
+        return "nested values are not supported";
+      } else if (not scalar()) {
+        return "malformed value";
+      }
+
+      skip_space();
+      if (consume(',')) {
+        continue;
+      }
+      if (consume('}')) {
+        return finish();
+      }
+      return "expected ',' or '}'";
+    }
+  }
+
+ private:
+  auto finish() noexcept -> std::optional<std::string_view> {
+    skip_space();
+    if (at_ != text_.size()) {
+      return "trailing characters after the object";
+    }
+    return std::nullopt;
+  }
+
+  auto skip_space() noexcept -> void {
+    while (at_ < text_.size() and (text_[at_] == ' ' or text_[at_] == '\t' or
+                                   text_[at_] == '\r')) {
+      ++at_;
+    }
+  }
+
+  auto consume(char c) noexcept -> bool {
+    if (at_ < text_.size() and text_[at_] == c) {
+      ++at_;
+      return true;
+    }
+    return false;
+  }
+
+  /// \brief Numbers, true, false and null.
+  auto scalar() noexcept -> bool {
+    const auto start{at_};
+    while (at_ < text_.size() and
+           std::string_view{"+-.0123456789Eaeflnrstu"}.contains(text_[at_])) {
+      ++at_;
+    }
+    return at_ != start;
+  }
+
+  auto hex4() noexcept -> std::optional<std::uint32_t> {
+    if (text_.size() - at_ < 4) {
+      return std::nullopt;
+    }
+    std::uint32_t value{0};
+    for (const auto end{at_ + 4}; at_ < end; ++at_) {
+      const auto c{text_[at_]};
+      value <<= 4U;
+      if (c >= '0' and c <= '9') {
+        value |= static_cast<std::uint32_t>(c - '0');
+      } else if (c >= 'a' and c <= 'f') {
+        value |= static_cast<std::uint32_t>(c - 'a' + 10);
+      } else if (c >= 'A' and c <= 'F') {
+        value |= static_cast<std::uint32_t>(c - 'A' + 10);
+      } else {
+        return std::nullopt;
+      }
+    }
+    return value;
+  }
+
+  static auto append_utf8(std::string& out, std::uint32_t code) -> void {
+    if (code < 0x80U) {
+      out += static_cast<char>(code);
+    } else if (code < 0x800U) {
+      out += static_cast<char>(0xC0U | (code >> 6U));
+      out += static_cast<char>(0x80U | (code & 0x3FU));
+    } else if (code < 0x10000U) {
+      out += static_cast<char>(0xE0U | (code >> 12U));
+      out += static_cast<char>(0x80U | ((code >> 6U) & 0x3FU));
+      out += static_cast<char>(0x80U | (code & 0x3FU));
+    } else {
+      out += static_cast<char>(0xF0U | (code >> 18U));
+      out += static_cast<char>(0x80U | ((code >> 12U) & 0x3FU));
+      out += static_cast<char>(0x80U | ((code >> 6U) & 0x3FU));
+      out += static_cast<char>(0x80U | (code & 0x3FU));
+    }
+  }
+
+  auto string(std::string& out) -> bool {
+    if (not consume('"')) {
+      return false;
+    }
+    while (at_ < text_.size()) {
+      const auto special{text_.find_first_of("\"\\", at_)};
+      if (special == std::string_view::npos) {
+        return false;
+      }
+      out.append(text_.substr(at_, special - at_));
+      at_ = special + 1;
+      if (text_[special] == '"') {
+        return true;
+      }
+      if (at_ == text_.size()) {
+        return false;
+      }
+      switch (text_[at_++]) {
+        case '"': {
+          out += '"';
+          break;
+        }
+        case '\\': {
+          out += '\\';
+          break;
+        }
+        case '/': {
+          out += '/';
+          break;
+        }
+        case 'b': {
+          out += '\b';
+          break;
+        }
+        case 'f': {
+          out += '\f';
+          break;
+        }
+        case 'n': {
+          out += '\n';
+          break;
+        }
+        case 'r': {
+          out += '\r';
+          break;
+        }
+        case 't': {
+          out += '\t';
+          break;
+        }
+        case 'u': {
+          auto code{hex4()};
+          if (not code) {
+            return false;
+          }
+          if (*code >= 0xD800U and *code < 0xDC00U) {
+            if (not consume('\\') or not consume('u')) {
+              return false;
+            }
+            const auto low{hex4()};
+            if (not low or *low < 0xDC00U or *low >= 0xE000U) {
+              return false;
+            }
+            code = 0x10000U + ((*code - 0xD800U) << 10U) + (*low - 0xDC00U);
+          }
+          append_utf8(out, *code);
+          break;
+        }
+        default: {
+          return false;
+        }
+      }
+    }
+    return false;
+  }
+
+  std::string_view text_;
+  std::size_t at_{0};
+  std::string key_;
+  std::string ignored_;
+};
+
+auto parse_json_lines_chunk(std::string_view text) -> ChunkResult {
+  ChunkResult result;
+  Fields fields;
+  std::size_t line{0};
+
+  std::size_t at{0};
+  while (at < text.size()) {
+    const auto end{std::min(text.find('\n', at), text.size())};
+    const auto row{text.substr(at, end - at)};
+    at = end + 1;
+    ++line;
+
+    if (row.find_first_not_of(" \t\r") == std::string_view::npos) {
+      continue;
+    }
+    clear(fields);
+    if (auto error = JsonLine{row}.parse(fields)) {
+      result.errors.push_back({line, std::string{*error}});
+    } else if (auto error = make_record(fields, result.records)) {
+      result.errors.push_back({line, std::string{*error}});
+    }
+  }
+
+  result.lines = line;
+  return result;
+}
+
+/// \brief Maps each CSV column to the field it fills.
+auto read_csv_header(std::string_view header) -> std::vector<std::size_t> {
+  std::vector<std::size_t> columns;
+  while (true) {
+    const auto comma{header.find(',')};
+    auto name{header.substr(0, comma)};
+    const auto first{name.find_first_not_of(" \t\r\"")};
+    const auto last{name.find_last_not_of(" \t\r\"")};
+    name = first == std::string_view::npos
+               ? std::string_view{}
+               : name.substr(first, last - first + 1);
+    columns.push_back(field_for(name));
+    if (comma == std::string_view::npos) {
+      return columns;
+    }
+    header.remove_prefix(comma + 1);
+  }
+}
+
+}  // namespace
+
+auto importer::parse(std::string_view text, Format format,
+                     std::size_t threads) -> ParseResult {
+  CSC_TRACE_SCOPE("importer::parse");
+  threads = parallel::thread_count(threads);
+  if (text.starts_with("\xEF\xBB\xBF")) {
+    text.remove_prefix(3);
+  }
+
+  ParseResult result;
+  std::size_t line_offset{0};
+  std::vector<std::size_t> columns;
+
+  if (format == Format::Csv) {
+    const auto header_end{text.find('\n')};
+    columns = read_csv_header(text.substr(0, header_end));
+    for (std::size_t field{0}; field < Tags; ++field) {
+      if (std::ranges::find(columns, field) == columns.end()) {
+        result.errors.push_back(
+            {1,
+             "the CSV header needs title, description, genre, date_taken and "
+             "thumbnail_path columns"});
+        return result;
+      }
+    }
+    text = header_end == std::string_view::npos ? std::string_view{}
+                                                : text.substr(header_end + 1);
+    line_offset = 1;
+  }
+
+  const auto target{std::max(MinChunkSize,
+                             text.size() / (threads * ChunksPerThread) + 1)};
+  const auto chunks{split(text, target, format == Format::Csv)};
+  std::vector<ChunkResult> parsed(chunks.size());
+  const auto first_id{ImageRecord::last_id() + 1};
+
+  parallel::for_each_batch(
+      chunks.size(), 1, threads,
+      [&](std::size_t i, [[maybe_unused]] std::size_t end) {
+        parsed[i] = format == Format::Csv
+                        ? parse_csv_chunk(chunks[i], columns)
+                        : parse_json_lines_chunk(chunks[i]);
+      });
+
+  std::size_t total{0};
+  for (const auto& chunk : parsed) {
+    total += chunk.records.size();
+  }
+  result.records.reserve(total);
+  for (auto& chunk : parsed) {
+    std::ranges::move(chunk.records, std::back_inserter(result.records));
+    for (auto& error : chunk.errors) {
+      error.line += line_offset;
+      result.errors.push_back(std::move(error));
+    }
+    line_offset += chunk.lines;
+  }
+  // Chunks finish in any order; ids follow the file.
+  ImageRecord::renumber(result.records, first_id);
+  return result;
+}
+
+auto importer::format_for(const std::filesystem::path& path)
+    -> std::optional<Format> {
+  const auto extension{path.extension()};
+  if (extension == ".csv") {
+    return Format::Csv;
+  }
+  if (extension == ".jsonl" or extension == ".ndjson") {
+    return Format::JsonLines;
+  }
+  return std::nullopt;
+}
+
+auto importer::read_file(const std::filesystem::path& path,
+                         std::optional<Format> format, std::size_t threads)
+    -> ParseResult {
+  CSC_TRACE_SCOPE("importer::read_file");
+  if (not format) {
+    format = format_for(path);
+  }
+  if (not format) {
+    throw std::runtime_error{"Unknown import format, expected .csv or .jsonl"};
+  }
+
+  std::ifstream file{path, std::ios::binary};
+  if (not file) {
+    throw std::runtime_error{"Failed to open " + path.string()};
+  }
+  std::string text(std::filesystem::file_size(path), '\0');
+  file.read(text.data(), static_cast<std::streamsize>(text.size()));
+  text.resize(static_cast<std::size_t>(file.gcount()));
+
+  auto parsed{parse(text, *format, threads)};
+  ingest::inspect_all(parsed.records, threads);
+  return parsed;
+}
+
+auto importer::import_file(ImageManager& manager,
+                           const std::filesystem::path& path,
+                           std::optional<Format> format,
+                           std::size_t threads) -> ImportReport {
+  CSC_TRACE_SCOPE("importer::import_file");
+  auto parsed{read_file(path, format, threads)};
+  ImportReport report{parsed.records.size(), std::move(parsed.errors)};
+  manager.add_images(std::move(parsed.records));
+  return report;
+}
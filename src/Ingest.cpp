@@ -0,0 +1,172 @@
+#include "csc/Ingest.hpp"
+
+#include <climits>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "csc/ColourSignature.hpp"
+#include "csc/ContentHash.hpp"
+#include "csc/ImageProbe.hpp"
+#include "csc/Parallel.hpp"
+#include "csc/PerceptualHash.hpp"
+#include "csc/Trace.hpp"
+#include "stb_image.h"
+
+using namespace csc;  // NOLINT
+
+namespace {
+
+/// Decodes are slow and uneven, so workers claim a few files at a time.
+constexpr std::size_t InspectBatch{16};
+
+/// Path resolutions per claim; each is a handful of system calls.
+constexpr std::size_t ResolveBatch{256};
+
+auto read_file(const std::filesystem::path& path)
+    -> std::optional<std::vector<unsigned char>> {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (not file) {
+    return std::nullopt;
+  }
+  std::vector<unsigned char> bytes(static_cast<std::size_t>(file.tellg()));
+  file.seekg(0);
+  if (not file.read(reinterpret_cast<char*>(bytes.data()),
+                    static_cast<std::streamsize>(bytes.size()))) {
+    return std::nullopt;
+  }
+  return bytes;
+}
+
+/// \brief One spelling per file: symlinks, `.` and `..` resolved. Paths that
+/// cannot be resolved are only normalised lexically.
+auto canonical_key(const std::filesystem::path& path) -> std::string {
+  std::error_code error;
+  auto canonical{std::filesystem::weakly_canonical(path, error)};
+  return error ? path.lexically_normal().string() : canonical.string();
+}
+
+/// \brief Copies what `inspect` learned about `from`'s file onto `to`.
+auto adopt(const ImageRecord& from, ImageRecord& to) noexcept -> void {
+  to.set_info(from.get_info());
+  to.set_content_hash(from.get_content_hash());
+  to.set_perceptual_hash(from.get_perceptual_hash());
+  to.set_colour_signature(from.get_colour_signature());
+}
+
+}  // namespace
+
+auto ingest::inspect(ImageRecord& image) noexcept -> void {
+  CSC_TRACE_SCOPE("ingest::inspect");
+  image.set_info(probe::probe_file(image.get_thumbnail_path())
+                     .value_or(ImageInfo{}));
+  image.set_content_hash(std::nullopt);
+  image.set_perceptual_hash(std::nullopt);
+  image.set_colour_signature(std::nullopt);
+
+  try {
+    // The file is read once: hashed as bytes, then decoded from memory.
+    const auto bytes{read_file(image.get_thumbnail_path())};
+    if (not bytes) {
+      return;
+    }
+    image.set_content_hash(content::hash_bytes(*bytes));
+    if (bytes->size() > INT_MAX) {
+      return;
+    }
+
+    int width{0};
+    int height{0};
+    int channels{0};
+    std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> rgba{
+        nullptr, &stbi_image_free};
+    {
+      CSC_TRACE_SCOPE("decode");
+      rgba.reset(stbi_load_from_memory(bytes->data(),
+                                       static_cast<int>(bytes->size()), &width,
+                                       &height, &channels, 4));
+    }
+    if (rgba == nullptr or width <= 0 or height <= 0) {
+      return;
+    }
+    const auto pixel_count{static_cast<std::size_t>(width) *
+                           static_cast<std::size_t>(height)};
+    const std::span<const unsigned char> pixels{rgba.get(), pixel_count * 4};
+
+    // Integer Rec. 601 luma, as stbi_load would give for one channel.
+    std::vector<unsigned char> gray(pixel_count);
+    for (std::size_t i{0}; i < pixel_count; ++i) {
+      const auto* const pixel{pixels.data() + (i * 4)};
+      gray[i] = static_cast<unsigned char>(
+          ((pixel[0] * 77U) + (pixel[1] * 150U) + (pixel[2] * 29U)) >> 8U);
+    }
+
+    image.set_perceptual_hash(
+        phash::hash_pixels(gray, static_cast<std::size_t>(width),
+                           static_cast<std::size_t>(height)));
+    image.set_colour_signature(colour::signature_rgba(pixels, pixel_count));
+  } catch (...) {
+    // Out of memory for a huge image: leave it undecoded.
+  }
+}
+
+auto ingest::inspect_all(std::span<ImageRecord> images,
+                         std::size_t threads) -> void {
+  CSC_TRACE_SCOPE("ingest::inspect_all");
+  // Records spelling a path the same share its id, so each spelling is
+  // resolved once.
+  std::unordered_map<paths::PathId, std::size_t> spelling_of;
+  std::vector<std::size_t> spelling(images.size());
+  std::vector<std::size_t> spellings;
+  for (std::size_t i{0}; i < images.size(); ++i) {
+    const auto [at, added] = spelling_of.try_emplace(
+        images[i].get_thumbnail_id(), spellings.size());
+    spelling[i] = at->second;
+    if (added) {
+      spellings.push_back(i);
+    }
+  }
+
+  std::vector<std::string> keys(spellings.size());
+  parallel::for_each_batch(spellings.size(), ResolveBatch, threads,
+                           [&](std::size_t begin, std::size_t end) {
+                             for (auto i{begin}; i < end; ++i) {
+                               keys[i] = canonical_key(
+                                   images[spellings[i]].get_thumbnail_path());
+                             }
+                           });
+
+  // Catalogs often point many records at one thumbnail, spelled in several
+  // ways; each file is read and decoded for the first of them only.
+  std::unordered_map<std::string, std::size_t> first_by_path;
+  std::vector<std::size_t> first_of(spellings.size());
+  std::vector<std::size_t> firsts;
+  for (std::size_t i{0}; i < spellings.size(); ++i) {
+    const auto [first, added] =
+        first_by_path.try_emplace(std::move(keys[i]), spellings[i]);
+    first_of[i] = first->second;
+    if (added) {
+      firsts.push_back(spellings[i]);
+    }
+  }
+  std::vector<std::size_t> source(images.size());
+  for (std::size_t i{0}; i < images.size(); ++i) {
+    source[i] = first_of[spelling[i]];
+  }
+
+  parallel::for_each_batch(firsts.size(), InspectBatch, threads,
+                           [&](std::size_t begin, std::size_t end) {
+                             for (auto i{begin}; i < end; ++i) {
+                               inspect(images[firsts[i]]);
+                             }
+                           });
+  for (std::size_t i{0}; i < images.size(); ++i) {
+    if (source[i] != i) {
+      adopt(images[source[i]], images[i]);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#include "csc/LabelCache.hpp"
+
+#include <format>
+#include <iterator>
+
+#include "csc/Tags.hpp"
+
+using namespace csc;         // NOLINT
+using namespace csc::frame;  // NOLINT
+
+auto frame::LabelCache::get(const ImageRecord& image, std::uint64_t version)
+    -> const Labels& {
+  if (version != version_) {
+    labels_.clear();
+    version_ = version;
+  }
+  auto found{labels_.find(image.get_id())};
+  if (found == labels_.end()) {
+    if (labels_.size() == Capacity) {
+      labels_.clear();
+    }
+    found = labels_.emplace(image.get_id(), format(image)).first;
+  }
+  return found->second;
+}
+
+auto frame::LabelCache::format(const ImageRecord& image) -> Labels {
+  Labels labels;
+  auto details{std::format_to(
+      std::back_inserter(labels.details),
+      "Title: {}, Description: {}, Genre: {}, Date taken: ",
+      image.get_title(), image.get_description(),
+      image.get_genre().to_string())};
+  image.get_date_taken().format_to(details);
+  if (not image.get_tags().empty()) {
+    labels.details += ", Tags: ";
+    tags::append_list(labels.details, image.get_tags());
+  }
+  labels.tooltip = image.get_title();
+  labels.tooltip += '\n';
+  image.get_date_taken().format_to(std::back_inserter(labels.tooltip));
+  return labels;
+}
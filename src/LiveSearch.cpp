@@ -0,0 +1,185 @@
+#include "csc/LiveSearch.hpp"
+
+#include <algorithm>
+
+#include "csc/ImageManager.hpp"
+#include "csc/Trace.hpp"
+
+using namespace csc;        // NOLINT
+using namespace csc::live;  // NOLINT
+
+live::LiveSearch::~LiveSearch() { cancel(); }
+
+auto live::LiveSearch::update(const ImageManager& manager,
+                              std::string_view text) -> void {
+  const auto now{std::chrono::steady_clock::now()};
+  if (text != typed_) {
+    typed_ = text;
+    typed_at_ = now;
+  }
+  if (corpus_ != nullptr and corpus_->version != manager.version()) {
+    // Matches are slots of the old catalog, so they go at once.
+    cancel();
+    job_.reset();
+    finished_.reset();
+    corpus_.reset();
+  }
+  if (corpus_ == nullptr) {
+    if (pending_ == nullptr or pending_->version != manager.version()) {
+      pending_ = std::make_shared<Corpus>();
+      pending_->version = manager.version();
+    }
+    if (not extend(*pending_, manager, field_)) {
+      return;
+    }
+    corpus_ = std::move(pending_);
+  }
+
+  if (job_ != nullptr and job_->done.load(std::memory_order_acquire) and
+      job_ != finished_) {
+    finished_ = job_;
+  }
+  const auto started{job_ != nullptr and job_->text == typed_ and
+                     job_->corpus == corpus_};
+  if (not started and
+      (now - started_at_ >= Debounce or now - typed_at_ >= Debounce)) {
+    started_at_ = now;
+    start(typed_);
+  }
+}
+
+auto live::LiveSearch::matches() const noexcept
+    -> std::span<const std::uint32_t> {
+  if (job_ == nullptr) {
+    return {};
+  }
+  return {job_->matches.data(),
+          job_->published.load(std::memory_order_acquire)};
+}
+
+auto live::LiveSearch::complete() const noexcept -> bool {
+  return job_ != nullptr and job_->text == typed_ and
+         job_->done.load(std::memory_order_acquire);
+}
+
+auto live::LiveSearch::record(const ImageManager& manager,
+                              std::uint32_t match) const noexcept
+    -> const ImageRecord& {
+  return manager.get_all_images().get_images()[job_->corpus->slots[match]];
+}
+
+auto live::LiveSearch::extend(Corpus& corpus, const ImageManager& manager,
+                              Field field) -> bool {
+  CSC_TRACE_SCOPE("LiveSearch::extend");
+  const auto& images{manager.get_all_images().get_images()};
+  if (corpus.copied == 0) {
+    corpus.slots.reserve(manager.size());
+    corpus.starts.reserve(manager.size() + 1);
+  }
+  const auto end{std::min(corpus.copied + Chunk, images.size())};
+  for (auto slot{corpus.copied}; slot < end; ++slot) {
+    const auto& image{images[slot]};
+    if (image.is_removed()) {
+      continue;
+    }
+    corpus.starts.push_back(corpus.text.size());
+    corpus.slots.push_back(slot);
+    corpus.text += field == Field::Title ? image.get_title()
+                                         : image.get_description();
+    corpus.text += '\0';
+  }
+  if (corpus.copied == 0 and end < images.size()) {
+    // Sized from the first chunk, so the block is not copied as it grows.
+    const auto per_slot{static_cast<double>(corpus.text.size()) /
+                        static_cast<double>(end)};
+    corpus.text.reserve(static_cast<std::size_t>(
+        per_slot * static_cast<double>(images.size()) * 1.25));
+  }
+  corpus.copied = end;
+  if (end < images.size()) {
+    return false;
+  }
+  corpus.starts.push_back(corpus.text.size());
+  return true;
+}
+
+auto live::LiveSearch::start(std::string text) -> void {
+  cancel();
+  auto job{std::make_shared<Job>()};
+  job->corpus = corpus_;
+  // Every record containing the new text also contains any part of it, so a
+  // finished query the new one contains has already found every candidate.
+  if (finished_ != nullptr and not finished_->text.empty() and
+      text.find(finished_->text) != std::string::npos) {
+    job->base = finished_;
+  }
+  job->text = std::move(text);
+  job_ = std::move(job);
+  if (job_->text.empty()) {
+    job_->done.store(true, std::memory_order_release);
+    return;
+  }
+  job_->matches.reserve(job_->base != nullptr ? job_->base->matches.size()
+                                              : corpus_->size());
+  running_ = std::async(std::launch::async, [job = job_] { scan(*job); });
+}
+
+auto live::LiveSearch::cancel() -> void {
+  if (job_ != nullptr) {
+    job_->cancelled.store(true, std::memory_order_relaxed);
+  }
+  // Stops within a chunk.
+  if (running_.valid()) {
+    running_.get();
+  }
+}
+
+auto live::LiveSearch::scan(Job& job) -> void {
+  CSC_TRACE_SCOPE("LiveSearch::scan");
+  const auto& corpus{*job.corpus};
+  const std::string_view needle{job.text};
+  const auto publish = [&job] {
+    job.published.store(job.matches.size(), std::memory_order_release);
+    return not job.cancelled.load(std::memory_order_relaxed);
+  };
+
+  if (job.base != nullptr) {
+    const auto& candidates{job.base->matches};
+    for (std::size_t begin{0}; begin < candidates.size(); begin += Chunk) {
+      const auto end{std::min(begin + Chunk, candidates.size())};
+      for (auto i{begin}; i < end; ++i) {
+        if (corpus.at(candidates[i]).find(needle) != std::string_view::npos) {
+          job.matches.push_back(candidates[i]);
+        }
+      }
+      if (not publish()) {
+        return;
+      }
+    }
+  } else {
+    // One pass over each chunk's text rather than a search per record; the
+    // NUL separators keep a match from spanning two records.
+    const std::string_view text{corpus.text};
+    for (std::size_t begin{0}; begin < corpus.size(); begin += Chunk) {
+      const auto end{std::min(begin + Chunk, corpus.size())};
+      const auto chunk{text.substr(0, corpus.starts[end])};
+      // Matches come in order, so the record holding each is found by
+      // walking on from the last rather than by a search per match.
+      auto record{begin};
+      auto at{chunk.find(needle, corpus.starts[begin])};
+      while (at != std::string_view::npos) {
+        while (corpus.starts[record + 1] <= at) {
+          ++record;
+        }
+        job.matches.push_back(static_cast<std::uint32_t>(record));
+        at = chunk.find(needle, corpus.starts[++record]);
+      }
+      if (not publish()) {
+        return;
+      }
+    }
+  }
+  // Refined queries hold on to their base only while scanning.
+  job.base.reset();
+  job.done.store(true, std::memory_order_release);
+}
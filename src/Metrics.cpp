@@ -0,0 +1,237 @@
+#include "csc/Metrics.hpp"
+
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+using namespace csc;           // NOLINT
+using namespace csc::metrics;  // NOLINT
+
+namespace {
+
+constexpr double NanosPerSecond{1e9};
+constexpr double NanosPerMicro{1e3};
+
+/// Prometheus bucket bounds run over these powers of two nanoseconds, about
+/// 1 us to 17 s.
+constexpr unsigned FirstBoundBits{10};
+constexpr unsigned LastBoundBits{34};
+
+/// \brief `name{labels}`, or just `name` without labels.
+auto series(std::string_view name, std::string_view labels,
+            std::string_view extra = {}) -> std::string {
+  std::string text{name};
+  if (labels.empty() and extra.empty()) {
+    return text;
+  }
+  text += '{';
+  text += labels;
+  if (not labels.empty() and not extra.empty()) {
+    text += ',';
+  }
+  text += extra;
+  text += '}';
+  return text;
+}
+
+/// \brief `# HELP` and `# TYPE` once per metric name.
+auto describe(std::string& out, std::unordered_set<std::string_view>& seen,
+              std::string_view name, std::string_view help,
+              std::string_view type) -> void {
+  if (seen.insert(name).second) {
+    std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n",
+                   name, help, name, type);
+  }
+}
+
+}  // namespace
+
+auto metrics::detail::next_shard() noexcept -> std::size_t {
+  static std::atomic<std::size_t> next{0};
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto Counter::value() const noexcept -> std::uint64_t {
+  std::uint64_t total{0};
+  for (const auto& shard : shards_) {
+    total += shard.value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+auto Histogram::snapshot() const noexcept -> Snapshot {
+  Snapshot snapshot;
+  for (std::size_t i{0}; i < Buckets; ++i) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+auto Histogram::Snapshot::quantile(double quantile) const noexcept
+    -> std::uint64_t {
+  if (count == 0) {
+    return 0;
+  }
+  const auto rank{static_cast<std::uint64_t>(
+      std::ceil(quantile * static_cast<double>(count)))};
+  std::uint64_t seen{0};
+  for (std::size_t i{0}; i < Buckets; ++i) {
+    seen += buckets[i];
+    if (seen >= std::max<std::uint64_t>(rank, 1)) {
+      return i + 1 < Buckets ? lower_bound(i + 1) : lower_bound(i);
+    }
+  }
+  return lower_bound(Buckets - 1);
+}
+
+auto Histogram::Snapshot::count_below(std::uint64_t nanos) const noexcept
+    -> std::uint64_t {
+  const auto end{bucket_of(nanos)};
+  return std::accumulate(buckets.begin(),
+                         buckets.begin() + static_cast<std::ptrdiff_t>(end),
+                         std::uint64_t{0});
+}
+
+auto Registry::counter(std::string name, std::string help,
+                       std::string labels) -> Counter& {
+  const std::lock_guard lock{mutex_};
+  return counters_
+      .emplace_back(std::move(name), std::move(help), std::move(labels))
+      .metric;
+}
+
+auto Registry::gauge(std::string name, std::string help,
+                     std::string labels) -> Gauge& {
+  const std::lock_guard lock{mutex_};
+  return gauges_
+      .emplace_back(std::move(name), std::move(help), std::move(labels))
+      .metric;
+}
+
+auto Registry::histogram(std::string name, std::string help,
+                         std::string labels) -> Histogram& {
+  const std::lock_guard lock{mutex_};
+  return histograms_
+      .emplace_back(std::move(name), std::move(help), std::move(labels))
+      .metric;
+}
+
+auto Registry::write_text(std::ostream& out) const -> void {
+  const std::lock_guard lock{mutex_};
+  std::string text;
+  for (const auto& [name, help, labels, metric] : counters_) {
+    std::format_to(std::back_inserter(text), "{} {}\n", series(name, labels),
+                   metric.value());
+  }
+  for (const auto& [name, help, labels, metric] : gauges_) {
+    std::format_to(std::back_inserter(text), "{} {}\n", series(name, labels),
+                   metric.value());
+  }
+  for (const auto& [name, help, labels, metric] : histograms_) {
+    const auto snapshot{metric.snapshot()};
+    const auto micros = [](double nanos) { return nanos / NanosPerMicro; };
+    const auto mean{snapshot.count == 0
+                        ? 0.0
+                        : static_cast<double>(snapshot.sum) /
+                              static_cast<double>(snapshot.count)};
+    std::format_to(
+        std::back_inserter(text),
+        "{} count={} mean={:.1f}us p50={:.1f}us p90={:.1f}us p99={:.1f}us\n",
+        series(name, labels), snapshot.count, micros(mean),
+        micros(static_cast<double>(snapshot.quantile(0.50))),
+        micros(static_cast<double>(snapshot.quantile(0.90))),
+        micros(static_cast<double>(snapshot.quantile(0.99))));
+  }
+  out << text;
+}
+
+auto Registry::write_prometheus(std::ostream& out) const -> void {
+  const std::lock_guard lock{mutex_};
+  std::string text;
+  std::unordered_set<std::string_view> seen;
+  for (const auto& [name, help, labels, metric] : counters_) {
+    describe(text, seen, name, help, "counter");
+    std::format_to(std::back_inserter(text), "{} {}\n", series(name, labels),
+                   metric.value());
+  }
+  for (const auto& [name, help, labels, metric] : gauges_) {
+    describe(text, seen, name, help, "gauge");
+    std::format_to(std::back_inserter(text), "{} {}\n", series(name, labels),
+                   metric.value());
+  }
+  for (const auto& [name, help, labels, metric] : histograms_) {
+    describe(text, seen, name, help, "histogram");
+    const auto snapshot{metric.snapshot()};
+    const auto bucket{name + "_bucket"};
+    for (auto bits{FirstBoundBits}; bits <= LastBoundBits; ++bits) {
+      const auto bound{std::uint64_t{1} << bits};
+      const auto le{std::format(
+          "le=\"{}\"", static_cast<double>(bound) / NanosPerSecond)};
+      std::format_to(std::back_inserter(text), "{} {}\n",
+                     series(bucket, labels, le),
+                     snapshot.count_below(bound));
+    }
+    std::format_to(std::back_inserter(text), "{} {}\n{} {}\n{} {}\n",
+                   series(bucket, labels, "le=\"+Inf\""), snapshot.count,
+                   series(name + "_sum", labels),
+                   static_cast<double>(snapshot.sum) / NanosPerSecond,
+                   series(name + "_count", labels), snapshot.count);
+  }
+  out << text;
+}
+
+auto Registry::write_file(const std::filesystem::path& path) const -> void {
+  std::ofstream file{path, std::ios::binary};
+  if (file) {
+    if (path.extension() == ".prom") {
+      write_prometheus(file);
+    } else {
+      write_text(file);
+    }
+  }
+  if (not file) {
+    throw std::runtime_error{"Could not write metrics to " + path.string()};
+  }
+}
+
+auto metrics::global() -> Registry& {
+  static Registry registry;
+  return registry;
+}
+
+auto metrics::library() -> const Library& {
+  static const Library metrics{[] {
+    auto& registry{global()};
+    std::array<Histogram*, SearchCount> searches{};
+    for (std::size_t i{0}; i < SearchCount; ++i) {
+      searches[i] = &registry.histogram(
+          "csc_search_duration_seconds", "Time taken by ImageManager searches.",
+          std::format("kind=\"{}\"", search_name(static_cast<Search>(i))));
+    }
+    return Library{
+        .searches = searches,
+        .inserted = registry.counter("csc_images_inserted_total",
+                                     "Records added to an ImageManager."),
+        .removed = registry.counter("csc_images_removed_total",
+                                    "Records removed from an ImageManager."),
+        .updated = registry.counter("csc_images_updated_total",
+                                    "Records edited in an ImageManager."),
+        .catalog_size = registry.gauge(
+            "csc_catalog_images", "Live records in the catalog when sampled."),
+        .title_index_bytes = registry.gauge(
+            "csc_title_index_bytes",
+            "Memory held by the title completion index when sampled."),
+        .title_index_bytes_per_title = registry.gauge(
+            "csc_title_index_bytes_per_title",
+            "Title completion index memory per distinct title."),
+    };
+  }()};
+  return metrics;
+}
@@ -0,0 +1,306 @@
+#include "csc/Paths.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+using namespace csc;         // NOLINT
+using namespace csc::paths;  // NOLINT
+
+namespace {
+
+constexpr auto is_separator(char c) noexcept -> bool {
+#if defined(_WIN32)
+  return c == '/' or c == '\\';
+#else
+  return c == '/';
+#endif
+}
+
+/// \brief Spelled as the exporter writes it, without a copy where the native
+/// encoding is already narrow.
+auto path_text(const std::filesystem::path& path) -> decltype(auto) {
+  if constexpr (std::is_same_v<std::filesystem::path::value_type, char>) {
+    return path.native();
+  } else {
+    return path.string();
+  }
+}
+
+/// \brief Up to and including the last separator; the rest is the file name.
+auto directory_length(std::string_view text) noexcept -> std::size_t {
+  for (auto at{text.size()}; at != 0; --at) {
+    if (is_separator(text[at - 1])) {
+      return at;
+    }
+  }
+  return 0;
+}
+
+/// \brief The component of a directory's `text` starting at `at`, up to and
+/// including its separator. `text` ends with one.
+auto component_at(std::string_view text, std::size_t at) noexcept
+    -> std::string_view {
+  auto end{at};
+  while (not is_separator(text[end])) {
+    ++end;
+  }
+  return text.substr(at, end + 1 - at);
+}
+
+constexpr auto directory_key(std::uint32_t parent,
+                             std::uint32_t component) noexcept
+    -> std::uint64_t {
+  return (std::uint64_t{parent} << 32U) | component;
+}
+
+auto hash_of(std::uint32_t directory, std::string_view name) noexcept
+    -> std::uint32_t {
+  const auto hash{std::hash<std::string_view>{}(name) ^
+                  (directory * 0x9E3779B97F4A7C15ULL)};
+  return static_cast<std::uint32_t>(hash ^ (hash >> 32U));
+}
+
+auto append_varint(std::string& out, std::size_t value) -> void {
+  while (value >= 0x80U) {
+    out += static_cast<char>((value & 0x7FU) | 0x80U);
+    value >>= 7U;
+  }
+  out += static_cast<char>(value);
+}
+
+auto read_varint(std::string_view in, std::size_t& at) noexcept
+    -> std::size_t {
+  std::size_t value{0};
+  for (unsigned shift{0};; shift += 7) {
+    const auto byte{static_cast<unsigned char>(in[at++])};
+    value |= std::size_t{byte & 0x7FU} << shift;
+    if ((byte & 0x80U) == 0) {
+      return value;
+    }
+  }
+}
+
+}  // namespace
+
+auto paths::Dictionary::intern(const std::filesystem::path& path) -> PathId {
+  const auto& spelled{path_text(path)};
+  const std::string_view text{spelled};
+  const auto cut{directory_length(text)};
+  const auto name{text.substr(cut)};
+  {
+    const std::shared_lock lock{mutex_};
+    if (const auto directory = find_directory(text.substr(0, cut))) {
+      if (const auto found =
+              find(*directory, name, hash_of(*directory, name))) {
+        return *found;
+      }
+    }
+  }
+  const std::unique_lock lock{mutex_};
+  const auto directory{intern_directory(text.substr(0, cut))};
+  const auto hash{hash_of(directory, name)};
+  if (const auto found = find(directory, name, hash)) {
+    return *found;
+  }
+  return append(directory, name, hash);
+}
+
+auto paths::Dictionary::find(const std::filesystem::path& path) const
+    -> std::optional<PathId> {
+  const auto& spelled{path_text(path)};
+  const std::string_view text{spelled};
+  const auto cut{directory_length(text)};
+  const auto name{text.substr(cut)};
+  const std::shared_lock lock{mutex_};
+  const auto directory{find_directory(text.substr(0, cut))};
+  if (not directory) {
+    return std::nullopt;
+  }
+  return find(*directory, name, hash_of(*directory, name));
+}
+
+auto paths::Dictionary::path(PathId id) const -> std::filesystem::path {
+  return std::filesystem::path{text(id)};
+}
+
+auto paths::Dictionary::text(PathId id) const -> std::string {
+  const std::shared_lock lock{mutex_};
+  const auto leaf{directory_of_.at(id)};
+  std::size_t length{0};
+  for (auto at{leaf}; at != NoDirectory; at = directories_[at].parent) {
+    length += components_[directories_[at].component].size();
+  }
+  // Components are reached leaf first, so they are written from the back.
+  std::string text(length, '\0');
+  for (auto at{leaf}; at != NoDirectory; at = directories_[at].parent) {
+    const auto& component{components_[directories_[at].component]};
+    length -= component.size();
+    component.copy(text.data() + length, component.size());
+  }
+  append_name(id, text);
+  return text;
+}
+
+auto paths::Dictionary::size() const -> std::size_t {
+  const std::shared_lock lock{mutex_};
+  return directory_of_.size();
+}
+
+auto paths::Dictionary::bytes() const -> std::size_t {
+  const std::shared_lock lock{mutex_};
+  auto bytes{names_.capacity() + last_name_.capacity() +
+             (directory_of_.capacity() * sizeof(DirectoryId)) +
+             (blocks_.capacity() * sizeof(std::size_t)) +
+             (slots_.capacity() * sizeof(Slot)) +
+             (directories_.capacity() * sizeof(Directory))};
+  // Each component is held twice, and each map node costs about two
+  // pointers more than its contents.
+  for (const auto& component : components_) {
+    bytes += 2 * (sizeof(std::string) + component.capacity());
+  }
+  bytes += component_ids_.size() * (sizeof(std::uint32_t) + 2 * sizeof(void*));
+  bytes += directory_ids_.size() *
+           (sizeof(std::uint64_t) + sizeof(DirectoryId) + 2 * sizeof(void*));
+  return bytes;
+}
+
+auto paths::Dictionary::find_directory(std::string_view text) const
+    -> std::optional<DirectoryId> {
+  DirectoryId directory{NoDirectory};
+  for (std::size_t at{0}; at < text.size();) {
+    const auto component{component_at(text, at)};
+    at += component.size();
+    const auto name{component_ids_.find(component)};
+    if (name == component_ids_.end()) {
+      return std::nullopt;
+    }
+    const auto found{
+        directory_ids_.find(directory_key(directory, name->second))};
+    if (found == directory_ids_.end()) {
+      return std::nullopt;
+    }
+    directory = found->second;
+  }
+  return directory;
+}
+
+auto paths::Dictionary::intern_directory(std::string_view text)
+    -> DirectoryId {
+  DirectoryId directory{NoDirectory};
+  for (std::size_t at{0}; at < text.size();) {
+    const auto component{component_at(text, at)};
+    at += component.size();
+    // Only a component not seen before is copied into a key.
+    auto name{component_ids_.find(component)};
+    if (name == component_ids_.end()) {
+      name = component_ids_
+                 .emplace(component,
+                          static_cast<std::uint32_t>(components_.size()))
+                 .first;
+      components_.emplace_back(component);
+    }
+    const auto [found, created] = directory_ids_.try_emplace(
+        directory_key(directory, name->second),
+        static_cast<DirectoryId>(directories_.size()));
+    if (created) {
+      directories_.push_back(
+          {.parent = directory, .component = name->second});
+    }
+    directory = found->second;
+  }
+  return directory;
+}
+
+auto paths::Dictionary::find(DirectoryId directory, std::string_view name,
+                             std::uint32_t hash) const
+    -> std::optional<PathId> {
+  if (slots_.empty()) {
+    return std::nullopt;
+  }
+  // Reused, so names decoded for comparison allocate only while it grows.
+  thread_local std::string decoded;
+  const auto mask{slots_.size() - 1};
+  for (auto at{hash & mask};; at = (at + 1) & mask) {
+    const auto& slot{slots_[at]};
+    if (slot.id == Empty) {
+      return std::nullopt;
+    }
+    if (slot.hash != hash or directory_of_[slot.id] != directory) {
+      continue;
+    }
+    decoded.clear();
+    append_name(slot.id, decoded);
+    if (decoded == name) {
+      return slot.id;
+    }
+  }
+}
+
+auto paths::Dictionary::append_name(PathId id, std::string& out) const
+    -> void {
+  const auto block{id / BlockSize};
+  const auto start{out.size()};
+  auto at{blocks_[block]};
+  for (auto i{block * BlockSize};; ++i) {
+    const auto shared{read_varint(names_, at)};
+    const auto length{read_varint(names_, at)};
+    out.resize(start + shared);
+    out.append(names_, at, length);
+    at += length;
+    if (i == id) {
+      return;
+    }
+  }
+}
+
+auto paths::Dictionary::append(DirectoryId directory, std::string_view name,
+                               std::uint32_t hash) -> PathId {
+  if ((directory_of_.size() + 1) * 2 > slots_.size()) {
+    grow();
+  }
+  const auto id{static_cast<PathId>(directory_of_.size())};
+  if (id % BlockSize == 0) {
+    blocks_.push_back(names_.size());
+    last_name_.clear();
+  }
+  const auto shared{static_cast<std::size_t>(
+      std::ranges::mismatch(last_name_, name).in1 - last_name_.begin())};
+  append_varint(names_, shared);
+  append_varint(names_, name.size() - shared);
+  names_.append(name.substr(shared));
+  last_name_.assign(name);
+  directory_of_.push_back(directory);
+
+  const auto mask{slots_.size() - 1};
+  auto at{hash & mask};
+  while (slots_[at].id != Empty) {
+    at = (at + 1) & mask;
+  }
+  slots_[at] = {.id = id, .hash = hash};
+  return id;
+}
+
+auto paths::Dictionary::grow() -> void {
+  std::vector<Slot> grown(std::max(MinSlots, slots_.size() * 2),
+                          Slot{.id = Empty, .hash = 0});
+  const auto mask{grown.size() - 1};
+  for (const auto& slot : slots_) {
+    if (slot.id == Empty) {
+      continue;
+    }
+    auto at{slot.hash & mask};
+    while (grown[at].id != Empty) {
+      at = (at + 1) & mask;
+    }
+    grown[at] = slot;
+  }
+  slots_ = std::move(grown);
+}
+
+auto paths::dictionary() -> Dictionary& {
+  static Dictionary paths;
+  return paths;
+}
@@ -0,0 +1,222 @@
+#include "csc/PerceptualHash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <numeric>
+#include <string>
+
+#include "csc/Parallel.hpp"
+#include "csc/Trace.hpp"
+#include "stb_image.h"
+
+using namespace csc;  // NOLINT
+
+namespace {
+
+constexpr std::size_t Columns{9};
+constexpr std::size_t Rows{8};
+
+/// Range queries per claim in `find_clusters`.
+constexpr std::size_t QueryBatch{1024};
+
+/// \brief The pixel range `[begin, end)` of one grid cell along an axis.
+/// Never empty, so images smaller than the grid repeat pixels instead.
+constexpr auto cell_bounds(std::size_t cell, std::size_t cells,
+                           std::size_t extent) noexcept
+    -> std::pair<std::size_t, std::size_t> {
+  const auto begin{cell * extent / cells};
+  return {begin, std::max((cell + 1) * extent / cells, begin + 1)};
+}
+
+/// \brief Union-find over `0..size`, with the smaller index as the root so
+/// the result does not depend on the order of `unite` calls.
+class DisjointSets {
+ public:
+  explicit DisjointSets(std::size_t size) : parent_(size) {
+    std::iota(parent_.begin(), parent_.end(), std::size_t{0});
+  }
+
+  auto find(std::size_t item) noexcept -> std::size_t {
+    while (parent_[item] != item) {
+      parent_[item] = parent_[parent_[item]];
+      item = parent_[item];
+    }
+    return item;
+  }
+
+  auto unite(std::size_t a, std::size_t b) noexcept -> void {
+    a = find(a);
+    b = find(b);
+    if (a != b) {
+      parent_[std::max(a, b)] = std::min(a, b);
+    }
+  }
+
+ private:
+  std::vector<std::size_t> parent_;
+};
+
+}  // namespace
+
+auto phash::hash_pixels(std::span<const unsigned char> gray, std::size_t width,
+                        std::size_t height) noexcept -> Hash {
+  if (width == 0 or height == 0 or gray.size() < width * height) {
+    return 0;
+  }
+
+  std::array<std::pair<std::size_t, std::size_t>, Columns> columns{};
+  for (std::size_t column{0}; column < Columns; ++column) {
+    columns[column] = cell_bounds(column, Columns, width);
+  }
+
+  // Box filter down to the grid. Each cell row is a contiguous run of bytes,
+  // so the inner sum vectorises.
+  std::array<double, Rows * Columns> means{};
+  for (std::size_t row{0}; row < Rows; ++row) {
+    const auto [top, bottom] = cell_bounds(row, Rows, height);
+    for (std::size_t column{0}; column < Columns; ++column) {
+      const auto [left, right] = columns[column];
+      std::uint64_t sum{0};
+      for (auto y{top}; y < bottom; ++y) {
+        const auto* const pixels{gray.data() + (y * width)};
+        std::uint32_t row_sum{0};
+        for (auto x{left}; x < right; ++x) {
+          row_sum += pixels[x];
+        }
+        sum += row_sum;
+      }
+      means[(row * Columns) + column] =
+          static_cast<double>(sum) /
+          static_cast<double>((bottom - top) * (right - left));
+    }
+  }
+
+  Hash hash{0};
+  for (std::size_t row{0}; row < Rows; ++row) {
+    for (std::size_t column{0}; column + 1 < Columns; ++column) {
+      const auto cell{(row * Columns) + column};
+      hash = (hash << 1U) | Hash{means[cell] > means[cell + 1]};
+    }
+  }
+  return hash;
+}
+
+auto phash::hash_file(const std::filesystem::path& path) noexcept
+    -> std::optional<Hash> {
+  try {
+    CSC_TRACE_SCOPE("decode");
+    int width{0};
+    int height{0};
+    int channels{0};
+    const auto name{path.string()};
+    const std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> pixels{
+        stbi_load(name.c_str(), &width, &height, &channels, 1),
+        &stbi_image_free};
+    if (pixels == nullptr or width <= 0 or height <= 0) {
+      return std::nullopt;
+    }
+    const auto w{static_cast<std::size_t>(width)};
+    const auto h{static_cast<std::size_t>(height)};
+    return hash_pixels({pixels.get(), w * h}, w, h);
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+auto phash::BkTree::insert(Hash hash, Id id) -> void {
+  auto& nodes{nodes_.owned()};
+  const auto added{static_cast<std::uint32_t>(nodes.size())};
+  nodes.push_back(Node{.hash = hash, .id = id});
+  if (added == 0) {
+    return;
+  }
+
+  std::uint32_t at{0};
+  while (true) {
+    const auto edge{static_cast<std::uint8_t>(distance(hash, nodes[at].hash))};
+    auto child{nodes[at].first_child};
+    while (child != None and nodes[child].edge != edge) {
+      child = nodes[child].next_sibling;
+    }
+    if (child == None) {
+      nodes[added].edge = edge;
+      nodes[added].next_sibling = nodes[at].first_child;
+      nodes[at].first_child = added;
+      return;
+    }
+    at = child;
+  }
+}
+
+auto phash::BkTree::save(snapshot::Writer& writer) const -> void {
+  writer.add(snapshot::Section::Similar, nodes_.view());
+}
+
+auto phash::BkTree::load(const snapshot::Snapshot& snapshot) -> void {
+  nodes_.borrow(snapshot.section<Node>(snapshot::Section::Similar));
+}
+
+auto phash::find_clusters(std::span<const std::pair<std::size_t, Hash>> images,
+                          unsigned max_distance, std::size_t threads)
+    -> std::vector<std::vector<std::size_t>> {
+  DisjointSets sets{images.size()};
+
+  // Identical hashes are joined up front and share one tree node, so a
+  // picture uploaded a thousand times costs one query rather than a thousand
+  // squared pairs.
+  std::vector<std::size_t> order(images.size());
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::ranges::sort(order, {}, [&images](std::size_t i) {
+    return std::pair{images[i].second, i};
+  });
+  std::vector<std::size_t> unique;
+  for (std::size_t i{0}; i < order.size(); ++i) {
+    if (i != 0 and images[order[i]].second == images[order[i - 1]].second) {
+      sets.unite(order[i], order[i - 1]);
+    } else {
+      unique.push_back(order[i]);
+    }
+  }
+
+  BkTree tree;
+  tree.reserve(unique.size());
+  for (std::size_t u{0}; u < unique.size(); ++u) {
+    tree.insert(images[unique[u]].second, u);
+  }
+
+  const auto batches{(unique.size() + QueryBatch - 1) / QueryBatch};
+  std::vector<std::vector<std::pair<std::size_t, std::size_t>>> links(batches);
+  parallel::for_each_batch(
+      unique.size(), QueryBatch, threads,
+      [&](std::size_t begin, std::size_t end) {
+        auto& found{links[begin / QueryBatch]};
+        for (auto u{begin}; u < end; ++u) {
+          tree.for_each_within(images[unique[u]].second, max_distance,
+                               [&found, u](std::size_t other, unsigned) {
+                                 if (other > u) {
+                                   found.emplace_back(u, other);
+                                 }
+                               });
+        }
+      });
+  for (const auto& batch : links) {
+    for (const auto& [a, b] : batch) {
+      sets.unite(unique[a], unique[b]);
+    }
+  }
+
+  std::vector<std::vector<std::size_t>> members(images.size());
+  for (std::size_t i{0}; i < images.size(); ++i) {
+    members[sets.find(i)].push_back(images[i].first);
+  }
+  std::vector<std::vector<std::size_t>> clusters;
+  for (auto& cluster : members) {
+    if (cluster.size() > 1) {
+      std::ranges::sort(cluster);
+      clusters.push_back(std::move(cluster));
+    }
+  }
+  std::ranges::sort(clusters, {}, [](const auto& c) { return c.front(); });
+  return clusters;
+}
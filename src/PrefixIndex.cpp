@@ -0,0 +1,308 @@
+#include "csc/PrefixIndex.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+
+#include "csc/Trace.hpp"
+
+using namespace csc;           // NOLINT
+using namespace csc::suggest;  // NOLINT
+
+namespace {
+
+constexpr auto fold(char c) noexcept -> char {
+  return c >= 'A' and c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+auto folded(std::string_view text) -> std::string {
+  std::string out(text.size(), '\0');
+  std::ranges::transform(text, out.begin(), fold);
+  return out;
+}
+
+/// Bytes outside ASCII are kept inside words, so UTF-8 text is not split.
+constexpr auto is_word(char c) noexcept -> bool {
+  return (c >= '0' and c <= '9') or (fold(c) >= 'a' and fold(c) <= 'z') or
+         static_cast<unsigned char>(c) >= 0x80;
+}
+
+/// \brief The title and its words, each once however it is capitalised.
+auto keys_of(std::string_view title) -> std::vector<std::string_view> {
+  std::vector<std::string_view> keys;
+  std::vector<std::string> seen;
+  const auto add = [&](std::string_view key) {
+    auto lower{folded(key)};
+    if (std::ranges::find(seen, lower) == seen.end()) {
+      seen.push_back(std::move(lower));
+      keys.push_back(key);
+    }
+  };
+  if (not title.empty()) {
+    add(title);
+  }
+  for (std::size_t begin{0}; begin < title.size();) {
+    if (not is_word(title[begin])) {
+      ++begin;
+      continue;
+    }
+    auto end{begin};
+    while (end < title.size() and is_word(title[end])) {
+      ++end;
+    }
+    if (end - begin >= 2) {
+      add(title.substr(begin, end - begin));
+    }
+    begin = end;
+  }
+  return keys;
+}
+
+}  // namespace
+
+auto suggest::PrefixIndex::insert(std::string_view title) -> void {
+  for (const auto key : keys_of(title)) {
+    count(key, key.size() == title.size(), 1);
+  }
+}
+
+auto suggest::PrefixIndex::erase(std::string_view title) -> void {
+  for (const auto key : keys_of(title)) {
+    count(key, key.size() == title.size(), -1);
+  }
+}
+
+auto suggest::PrefixIndex::clear() noexcept -> void {
+  nodes_.clear();
+  nodes_.owned().emplace_back();
+  keys_.clear();
+  folded_.clear();
+  spelled_.clear();
+  titles_ = 0;
+}
+
+auto suggest::PrefixIndex::complete(std::string_view prefix,
+                                    std::size_t n) const
+    -> std::vector<Suggestion> {
+  CSC_TRACE_SCOPE("PrefixIndex::complete");
+  const auto wanted{folded(prefix)};
+  std::string_view rest{wanted};
+  std::uint32_t at{0};
+  while (not rest.empty()) {
+    auto child{nodes_[at].first_child};
+    while (child != None and nodes_[child].first != rest.front()) {
+      child = nodes_[child].next_sibling;
+    }
+    if (child == None) {
+      return {};
+    }
+    const auto edge{label(nodes_[child])};
+    const auto common{std::min(edge.size(), rest.size())};
+    if (edge.substr(0, common) != rest.substr(0, common)) {
+      return {};
+    }
+    rest.remove_prefix(common);
+    at = child;
+  }
+
+  std::vector<Suggestion> suggestions;
+  for (const auto key : nodes_[at].best) {
+    if (key == None or suggestions.size() == n) {
+      break;
+    }
+    suggestions.push_back({text(keys_[key]), keys_[key].count});
+  }
+  return suggestions;
+}
+
+auto suggest::PrefixIndex::bytes() const noexcept -> std::size_t {
+  return sizeof(*this) + (nodes_.capacity() * sizeof(Node)) +
+         (keys_.capacity() * sizeof(Key)) + folded_.capacity() +
+         spelled_.capacity() + (scratch_.capacity() * sizeof(std::uint32_t));
+}
+
+auto suggest::PrefixIndex::save(snapshot::Writer& writer) const -> void {
+  writer.add(snapshot::Section::TitleNodes, nodes_.view());
+  writer.add(snapshot::Section::TitleKeys, keys_.view());
+  writer.add(snapshot::Section::TitleFolded, folded_.view());
+  writer.add(snapshot::Section::TitleSpelled, spelled_.view());
+  writer.add_value(snapshot::Section::TitleCount, std::uint64_t{titles_});
+}
+
+auto suggest::PrefixIndex::load(const snapshot::Snapshot& snapshot) -> void {
+  const auto nodes{snapshot.section<Node>(snapshot::Section::TitleNodes)};
+  if (nodes.empty()) {
+    throw std::runtime_error{"Snapshot title index has no root"};
+  }
+  nodes_.borrow(nodes);
+  keys_.borrow(snapshot.section<Key>(snapshot::Section::TitleKeys));
+  folded_.borrow(snapshot.section<char>(snapshot::Section::TitleFolded));
+  spelled_.borrow(snapshot.section<char>(snapshot::Section::TitleSpelled));
+  titles_ = snapshot.value<std::uint64_t>(snapshot::Section::TitleCount);
+}
+
+auto suggest::PrefixIndex::count(std::string_view key, bool title, int delta)
+    -> void {
+  const auto lower{folded(key)};
+  const auto path{delta > 0 ? path_to(lower) : find_path(lower)};
+  if (path.empty()) {
+    return;
+  }
+  auto id{nodes_[path.back()].key};
+  if (delta < 0 and (id == None or keys_[id].count == 0)) {
+    return;
+  }
+  auto& keys{keys_.owned()};
+  if (id == None) {
+    id = static_cast<std::uint32_t>(keys.size());
+    nodes_.owned()[path.back()].key = id;
+    keys.emplace_back();
+  }
+  auto& entry{keys[id]};
+  if (entry.count == 0) {
+    auto& spelled{spelled_.owned()};
+    entry.text = static_cast<std::uint32_t>(spelled.size());
+    entry.length = static_cast<std::uint32_t>(key.size());
+    spelled.insert(spelled.end(), key.begin(), key.end());
+  }
+  entry.count = static_cast<std::uint32_t>(entry.count + delta);
+  if (title and (delta > 0 or entry.titles > 0)) {
+    entry.titles = static_cast<std::uint32_t>(entry.titles + delta);
+    if (entry.titles == (delta > 0 ? 1U : 0U)) {
+      titles_ = delta > 0 ? titles_ + 1 : titles_ - 1;
+    }
+  }
+  // A key gaining a record can only move up each list. One losing a record
+  // can let in a key from elsewhere in the subtree, but only where it was
+  // listed.
+  for (const auto node : std::views::reverse(path)) {
+    if (delta > 0) {
+      promote(node, id);
+    } else if (std::ranges::find(nodes_[node].best, id) !=
+               nodes_[node].best.end()) {
+      refresh(node);
+    }
+  }
+}
+
+auto suggest::PrefixIndex::path_to(std::string_view key)
+    -> std::vector<std::uint32_t> {
+  auto& nodes{nodes_.owned()};
+  std::vector<std::uint32_t> path{0};
+  std::size_t done{0};
+  while (done < key.size()) {
+    const auto at{path.back()};
+    const auto rest{key.substr(done)};
+    auto child{nodes[at].first_child};
+    while (child != None and nodes[child].first != rest.front()) {
+      child = nodes[child].next_sibling;
+    }
+
+    if (child == None) {
+      auto& folded{folded_.owned()};
+      Node leaf{.label = static_cast<std::uint32_t>(folded.size()),
+                .length = static_cast<std::uint32_t>(rest.size()),
+                .next_sibling = nodes[at].first_child,
+                .first = rest.front()};
+      folded.insert(folded.end(), rest.begin(), rest.end());
+      nodes[at].first_child = static_cast<std::uint32_t>(nodes.size());
+      path.push_back(nodes[at].first_child);
+      nodes.push_back(leaf);
+      return path;
+    }
+
+    const auto edge{label(nodes[child])};
+    const auto common{static_cast<std::uint32_t>(
+        std::ranges::mismatch(edge, rest).in1 - edge.begin())};
+    if (common < edge.size()) {
+      // The lower part moves to a new node, so the parent's links to `child`
+      // stay as they are. Both halves hold the same keys.
+      auto lower{nodes[child]};
+      lower.label += common;
+      lower.length -= common;
+      lower.first = folded_[lower.label];
+      lower.next_sibling = None;
+      auto& upper{nodes[child]};
+      upper.length = common;
+      upper.key = None;
+      upper.first_child = static_cast<std::uint32_t>(nodes.size());
+      nodes.push_back(lower);
+    }
+    path.push_back(child);
+    done += common;
+  }
+  return path;
+}
+
+auto suggest::PrefixIndex::find_path(std::string_view key) const
+    -> std::vector<std::uint32_t> {
+  std::vector<std::uint32_t> path{0};
+  std::string_view rest{key};
+  while (not rest.empty()) {
+    auto child{nodes_[path.back()].first_child};
+    while (child != None and nodes_[child].first != rest.front()) {
+      child = nodes_[child].next_sibling;
+    }
+    if (child == None or not rest.starts_with(label(nodes_[child]))) {
+      return {};
+    }
+    rest.remove_prefix(nodes_[child].length);
+    path.push_back(child);
+  }
+  return path;
+}
+
+auto suggest::PrefixIndex::promote(std::uint32_t node, std::uint32_t key)
+    -> void {
+  auto& best{nodes_.owned()[node].best};
+  auto at{std::ranges::find(best, key)};
+  if (at == best.end()) {
+    at = std::prev(best.end());
+    if (*at != None and not ranks_before(key, *at)) {
+      return;
+    }
+    *at = key;
+  }
+  while (at != best.begin() and
+         (*std::prev(at) == None or ranks_before(*at, *std::prev(at)))) {
+    std::iter_swap(at, std::prev(at));
+    --at;
+  }
+}
+
+auto suggest::PrefixIndex::refresh(std::uint32_t node) -> void {
+  scratch_.clear();
+  if (const auto key = nodes_[node].key; key != None and keys_[key].count > 0) {
+    scratch_.push_back(key);
+  }
+  for (auto child{nodes_[node].first_child}; child != None;
+       child = nodes_[child].next_sibling) {
+    for (const auto key : nodes_[child].best) {
+      if (key == None) {
+        break;
+      }
+      scratch_.push_back(key);
+    }
+  }
+  const auto kept{std::min(scratch_.size(), MaxSuggestions)};
+  std::ranges::partial_sort(scratch_, scratch_.begin() + kept,
+                            [this](std::uint32_t a, std::uint32_t b) {
+                              return ranks_before(a, b);
+                            });
+  auto& best{nodes_.owned()[node].best};
+  best = filled();
+  std::ranges::copy_n(scratch_.begin(), kept, best.begin());
+}
+
+auto suggest::PrefixIndex::ranks_before(std::uint32_t a,
+                                        std::uint32_t b) const noexcept
+    -> bool {
+  const auto& first{keys_[a]};
+  const auto& second{keys_[b]};
+  if (first.count != second.count) {
+    return first.count > second.count;
+  }
+  return text(first) < text(second);
+}
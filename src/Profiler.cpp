@@ -0,0 +1,98 @@
+#include "csc/Profiler.hpp"
+
+#include <algorithm>
+
+using namespace csc;           // NOLINT
+using namespace csc::profile;  // NOLINT
+
+namespace {
+
+constexpr double NanosPerMilli{1e6};
+
+auto percentiles(std::span<std::uint64_t> nanos) -> Percentiles {
+  if (nanos.empty()) {
+    return {};
+  }
+  std::ranges::sort(nanos);
+  const auto at = [&nanos](double quantile) {
+    const auto index{static_cast<std::size_t>(
+        quantile * static_cast<double>(nanos.size() - 1))};
+    return static_cast<double>(nanos[index]) / NanosPerMilli;
+  };
+  double sum{0};
+  for (const auto value : nanos) {
+    sum += static_cast<double>(value);
+  }
+  return {at(0.50), at(0.99),
+          sum / static_cast<double>(nanos.size()) / NanosPerMilli};
+}
+
+}  // namespace
+
+auto profile::global() noexcept -> Profiler& {
+  static Profiler profiler;
+  return profiler;
+}
+
+auto Profiler::end_frame(std::chrono::nanoseconds frame) noexcept -> void {
+  const auto slot{current_.load(std::memory_order_relaxed)};
+  ring_[slot].total.store(static_cast<std::uint64_t>(frame.count()),
+                          std::memory_order_relaxed);
+
+  const auto next{(slot + 1) % Frames};
+  ring_[next].total.store(0, std::memory_order_relaxed);
+  for (auto& stage : ring_[next].stages) {
+    stage.store(0, std::memory_order_relaxed);
+  }
+  current_.store(next, std::memory_order_release);
+  completed_ = std::min(completed_ + 1, Frames - 1);
+}
+
+auto Profiler::reset() noexcept -> void {
+  for (auto& frame : ring_) {
+    frame.total.store(0, std::memory_order_relaxed);
+    for (auto& stage : frame.stages) {
+      stage.store(0, std::memory_order_relaxed);
+    }
+  }
+  completed_ = 0;
+}
+
+template <typename Field>
+auto Profiler::completed(Field&& field) const
+    -> std::array<std::uint64_t, Frames> {
+  std::array<std::uint64_t, Frames> values{};
+  const auto current{current_.load(std::memory_order_acquire)};
+  for (std::size_t i{0}; i < completed_; ++i) {
+    const auto slot{(current + Frames - completed_ + i) % Frames};
+    values[i] = field(ring_[slot]).load(std::memory_order_relaxed);
+  }
+  return values;
+}
+
+auto Profiler::frame_times(std::span<float> out) const noexcept
+    -> std::size_t {
+  const auto values{
+      completed([](const Frame& frame) -> const auto& { return frame.total; })};
+  const auto count{std::min(out.size(), completed_)};
+  const auto skip{completed_ - count};
+  for (std::size_t i{0}; i < count; ++i) {
+    out[i] = static_cast<float>(static_cast<double>(values[skip + i]) /
+                                NanosPerMilli);
+  }
+  return count;
+}
+
+auto Profiler::frame_percentiles() const -> Percentiles {
+  auto values{
+      completed([](const Frame& frame) -> const auto& { return frame.total; })};
+  return percentiles(std::span{values}.first(completed_));
+}
+
+auto Profiler::stage_percentiles(Stage stage) const -> Percentiles {
+  const auto index{static_cast<std::size_t>(stage)};
+  auto values{completed([index](const Frame& frame) -> const auto& {
+    return frame.stages[index];
+  })};
+  return percentiles(std::span{values}.first(completed_));
+}
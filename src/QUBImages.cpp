@@ -1,9 +1,50 @@
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+#include "csc/Batch.hpp"
 #include "csc/Console.hpp"
+#include "csc/ImageManager.hpp"
+#include "csc/RequiredImages.hpp"
+#include "csc/Trace.hpp"
 
 using namespace std::literals::chrono_literals;
 using namespace csc::date::literals;  // NOLINT
 
-auto main() -> int {
+/// \brief `QUBImages --batch <file>` runs the queries in `file` (or stdin for
+/// `-`) without any prompts and prints JSON Lines results.
+static auto run_batch(std::string_view file) -> int {
+  std::ios::sync_with_stdio(false);
+
+  auto manager{csc::required::manager_with_required_images()};
+  std::size_t failures{0};
+  if (file == "-") {
+    failures = csc::batch::run(manager, std::cin, std::cout);
+  } else {
+    std::ifstream queries{std::filesystem::path{file}};
+    if (not queries) {
+      std::cerr << "Could not open " << file << '\n';
+      return 2;
+    }
+    failures = csc::batch::run(manager, queries, std::cout);
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+auto main(int argc, char** argv) -> int {
+  const csc::trace::Session trace;
+  const std::span<char*> args{argv, static_cast<std::size_t>(argc)};
+  if (args.size() > 1 and std::string_view{args[1]} == "--batch") {
+    if (args.size() != 3) {
+      std::cerr << "Usage: " << args[0] << " [--batch <queries file | ->]\n";
+      return 2;
+    }
+    return run_batch(args[2]);
+  }
+
   csc::console::Console console{};
   console.run();
 }
@@ -1,22 +1,43 @@
 #include <algorithm>
 #include <array>
+#include <filesystem>
 #include <chrono>
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
+#include "csc/AlbumCursor.hpp"
+#include "csc/Allocations.hpp"
+#include "csc/ContentHash.hpp"
+#include "csc/Facets.hpp"
+#include "csc/FrameArena.hpp"
 #include "csc/ImageAlbum.hpp"
 #include "csc/ImageManager.hpp"
 #include "csc/ImageRecord.hpp"
+#include "csc/Ingest.hpp"
+#include "csc/LabelCache.hpp"
+#include "csc/LiveSearch.hpp"
+#include "csc/Metrics.hpp"
 #include "csc/OptionPack.hpp"
+#include "csc/Profiler.hpp"
+#include "csc/ShelfPacker.hpp"
+#include "csc/Tags.hpp"
+#include "csc/Trace.hpp"
 #include "csc/UserInterface.hpp"
 #include "csc/core.h"
 #include "csc/date.hpp"
@@ -40,7 +61,6 @@
 #endif
 
 #define _CRT_SECURE_NO_WARNINGS
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 namespace WindowConfig {
@@ -49,6 +69,18 @@ constexpr inline int Height{720};
 constexpr inline const char* Title{"QUBMediaImages"};
 }  // namespace WindowConfig
 
+namespace GridConfig {
+/// Side of the square each thumbnail is fitted into.
+constexpr inline float Thumbnail{128.0F};
+/// Rows above and below the visible ones whose thumbnails are decoded ahead.
+constexpr inline int PrefetchRows{2};
+}  // namespace GridConfig
+
+namespace OverlayConfig {
+constexpr inline float PlotWidth{320.0F};
+constexpr inline float PlotHeight{80.0F};
+}  // namespace OverlayConfig
+
 inline auto enter_pressed() noexcept -> bool {
   return ImGui::IsKeyPressed(ImGuiKey_Enter);
 }
@@ -107,7 +139,7 @@ struct GetFromTheseOptions {
   }
 
   static constexpr auto GetValue() -> std::optional<ValueType> {
-    const auto OptionDisplayStrings_CStr{map_items()};  // NOLINT
+    static const auto OptionDisplayStrings_CStr{map_items()};  // NOLINT
     static int index{0};
 
     ImGui::Combo("##Combo", &index, OptionDisplayStrings_CStr.data(), Arity);
@@ -126,19 +158,93 @@ struct GetFromTheseOptions {
 };
 
 namespace image {
-auto LoadTextureFromMemory(const void* data, size_t data_size,
-                           GLuint* out_texture, int* out_width,
-                           int* out_height) -> int {
-  // Load from file
-  int image_width = 0;
-  int image_height = 0;
-  unsigned char* image_data = stbi_load_from_memory(
-      static_cast<const unsigned char*>(data), static_cast<int>(data_size),
-      &image_width, &image_height, nullptr, 4);
-  if (image_data == nullptr) {
-    return 0;
+/// \brief Decoded 8-bit RGBA pixels.
+struct Pixels {
+  std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> rgba{nullptr,
+                                                            &stbi_image_free};
+  int width{0};
+  int height{0};
+};
+
+/// \brief 8-bit RGBA pixels shrunk for the grid.
+struct Thumbnail {
+  std::vector<unsigned char> rgba;
+  int width{0};
+  int height{0};
+};
+
+/// \brief Decodes `file_name`. Touches no GL state, so it can run on any
+/// thread.
+auto DecodeFile(const std::string& file_name) -> std::optional<Pixels> {
+  const csc::profile::ScopedTimer timer{csc::profile::Stage::Decode};
+  CSC_TRACE_SCOPE("decode");
+  Pixels pixels;
+  pixels.rgba.reset(stbi_load(file_name.c_str(), &pixels.width,
+                              &pixels.height, nullptr, 4));
+  if (pixels.rgba == nullptr) {
+    return std::nullopt;
   }
+  return pixels;
+}
 
+/// \brief Box-filters `pixels` down to fit in `max_side` square, keeping the
+/// aspect ratio. Images already small enough are copied as they are.
+auto Shrink(const Pixels& pixels, int max_side) -> Thumbnail {
+  const auto scale{std::min({static_cast<double>(max_side) / pixels.width,
+                             static_cast<double>(max_side) / pixels.height,
+                             1.0})};
+  Thumbnail thumbnail;
+  thumbnail.width = std::max(1, static_cast<int>(pixels.width * scale));
+  thumbnail.height = std::max(1, static_cast<int>(pixels.height * scale));
+  thumbnail.rgba.resize(static_cast<std::size_t>(thumbnail.width) *
+                        static_cast<std::size_t>(thumbnail.height) * 4);
+
+  // The source block of each output pixel, along one axis; never empty.
+  const auto span = [](int out, int outs, int extent) {
+    const auto begin{out * extent / outs};
+    return std::pair{begin, std::max((out + 1) * extent / outs, begin + 1)};
+  };
+  const auto stride{static_cast<std::size_t>(pixels.width) * 4};
+  auto* out{thumbnail.rgba.data()};
+  for (int y{0}; y < thumbnail.height; ++y) {
+    const auto [top, bottom] = span(y, thumbnail.height, pixels.height);
+    for (int x{0}; x < thumbnail.width; ++x) {
+      const auto [left, right] = span(x, thumbnail.width, pixels.width);
+      std::array<std::uint32_t, 4> sums{};
+      for (auto row{top}; row < bottom; ++row) {
+        const auto* pixel{pixels.rgba.get() +
+                          (static_cast<std::size_t>(row) * stride) +
+                          (static_cast<std::size_t>(left) * 4)};
+        for (auto column{left}; column < right; ++column, pixel += 4) {
+          sums[0] += pixel[0];
+          sums[1] += pixel[1];
+          sums[2] += pixel[2];
+          sums[3] += pixel[3];
+        }
+      }
+      const auto count{
+          static_cast<std::uint32_t>((bottom - top) * (right - left))};
+      for (const auto sum : sums) {
+        *out++ = static_cast<unsigned char>((sum + (count / 2)) / count);
+      }
+    }
+  }
+  return thumbnail;
+}
+
+/// \brief Decodes and shrinks `file_name`, on any thread.
+auto DecodeThumbnail(const std::string& file_name, int max_side)
+    -> std::optional<Thumbnail> {
+  auto pixels{DecodeFile(file_name)};
+  if (not pixels) {
+    return std::nullopt;
+  }
+  return Shrink(*pixels, max_side);
+}
+
+/// \brief Uploads `pixels` to a new texture. Must run on the GL thread.
+auto UploadTexture(const Pixels& pixels) -> GLuint {
+  const csc::profile::ScopedTimer timer{csc::profile::Stage::Upload};
   // Create a OpenGL texture identifier
   GLuint image_texture;
   glGenTextures(1, &image_texture);
@@ -150,35 +256,9 @@ auto LoadTextureFromMemory(const void* data, size_t data_size,
 
   // Upload pixels into texture
   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_width, image_height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, image_data);
-  stbi_image_free(image_data);
-
-  *out_texture = image_texture;
-  *out_width = image_width;
-  *out_height = image_height;
-
-  return 1;
-}
-
-auto LoadTextureFromFile(const char* file_name, GLuint* out_texture,
-                         int* out_width, int* out_height) -> bool {
-  FILE* f{fopen(file_name, "rb")};
-  if (f == nullptr) {
-    return false;
-  }
-  fseek(f, 0, SEEK_END);
-  auto file_size = static_cast<size_t>(ftell(f));
-  if (file_size == -1) {
-    return false;
-  }
-  fseek(f, 0, SEEK_SET);
-  void* file_data = IM_ALLOC(file_size);
-  fread(file_data, 1, file_size, f);
-  bool ret = LoadTextureFromMemory(file_data, file_size, out_texture, out_width,
-                                   out_height);
-  IM_FREE(file_data);
-  return ret;
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pixels.width, pixels.height, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, pixels.rgba.get());
+  return image_texture;
 }
 }  // namespace image
 
@@ -193,27 +273,465 @@ class Text {
  private:
   const char* text_;
 };
+/// \brief A GL texture, deleted with the object.
 class Image {
  public:
-  explicit Image(const char* file_name) {
-    int width;
-    int height;
-    if (!image::LoadTextureFromFile(file_name, &texture_, &width, &height)) {
-      throw std::runtime_error("Failed to load image");
+  explicit Image(const image::Pixels& pixels)
+      : texture_{image::UploadTexture(pixels)},
+        size_(static_cast<float>(pixels.width),
+              static_cast<float>(pixels.height)) {}
+  explicit Image(const char* file_name) : Image{load(file_name)} {}
+  Image(const Image&) = delete;
+  Image(Image&& other) noexcept
+      : texture_{std::exchange(other.texture_, 0)}, size_{other.size_} {}
+  auto operator=(const Image&) -> Image& = delete;
+  auto operator=(Image&& other) noexcept -> Image& {
+    std::swap(texture_, other.texture_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+  ~Image() {
+    if (texture_ != 0) {
+      glDeleteTextures(1, &texture_);
     }
-    size_ = ImVec2(width, height);
   }
-  ~Image() = default;
 
   void render() const {
     ImGui::Image((void*)(intptr_t)texture_, size_);  // NOLINT
   }
 
+  /// \brief Size of the uploaded RGBA pixels.
+  [[nodiscard]] auto bytes() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(size_.x) *
+           static_cast<std::size_t>(size_.y) * 4;
+  }
+
  private:
-  GLuint texture_;
+  static auto load(const char* file_name) -> image::Pixels {
+    auto pixels{image::DecodeFile(file_name)};
+    if (not pixels) {
+      throw std::runtime_error("Failed to load image");
+    }
+    return std::move(*pixels);
+  }
+
+  GLuint texture_{0};
   ImVec2 size_;
 };
 
+/// \brief Thumbnails packed into a few large textures. A grid drawn from one
+/// page binds one texture, and ImGui merges its consecutive draws into a
+/// single command. Pages are plain GL 3.0 / ES 2.0 textures updated with
+/// glTexSubImage2D, so software renderers such as llvmpipe handle them.
+class Atlas {
+ public:
+  using Handle = csc::atlas::ShelfPacker::Handle;
+
+  /// The size every GL 3.0 implementation must support.
+  static constexpr std::uint32_t PageSize{1024};
+  static constexpr std::uint32_t MaxPages{16};
+  /// Empty pixels around each entry, so linear filtering never samples a
+  /// neighbour.
+  static constexpr std::uint32_t Gutter{1};
+
+  /// \brief Where to draw an entry from.
+  struct Sprite {
+    GLuint texture;
+    ImVec2 size;
+    ImVec2 uv0;
+    ImVec2 uv1;
+
+    /// \brief Draws the sprite centred in the box at `origin`, shrunk to fit
+    /// if need be.
+    void render_fitted(ImVec2 origin, ImVec2 box) const {
+      const auto scale{std::min({box.x / size.x, box.y / size.y, 1.0F})};
+      const ImVec2 fitted(size.x * scale, size.y * scale);
+      const ImVec2 min(origin.x + ((box.x - fitted.x) / 2),
+                       origin.y + ((box.y - fitted.y) / 2));
+      ImGui::GetWindowDrawList()->AddImage(
+          (void*)(intptr_t)texture,  // NOLINT
+          min, ImVec2(min.x + fitted.x, min.y + fitted.y), uv0, uv1);
+    }
+  };
+
+  Atlas() = default;
+  Atlas(const Atlas&) = delete;
+  auto operator=(const Atlas&) -> Atlas& = delete;
+  ~Atlas() { clear(); }
+
+  /// \brief Deletes every page and forgets every entry.
+  auto clear() -> void {
+    for (auto& page : pages_) {
+      glDeleteTextures(1, &page.texture);
+    }
+    pages_.clear();
+    packer_ = csc::atlas::ShelfPacker{PageSize, MaxPages};
+  }
+
+  /// \brief Copies `thumbnail` into a page, first repacking the most
+  /// fragmented page if none has room.
+  /// \return Nothing if the atlas is full.
+  auto insert(const image::Thumbnail& thumbnail) -> std::optional<Handle> {
+    const auto width{static_cast<std::uint32_t>(thumbnail.width)};
+    const auto height{static_cast<std::uint32_t>(thumbnail.height)};
+    auto handle{packer_.allocate(width + Gutter, height + Gutter)};
+    if (not handle) {
+      if (const auto page = packer_.most_fragmented_page()) {
+        compact(*page);
+        handle = packer_.allocate(width + Gutter, height + Gutter);
+      }
+    }
+    if (not handle) {
+      return std::nullopt;
+    }
+
+    const auto& rect{packer_.rect(*handle)};
+    while (pages_.size() <= rect.page) {
+      add_page();
+    }
+    const csc::profile::ScopedTimer timer{csc::profile::Stage::Upload};
+    auto& page{pages_[rect.page]};
+    for (std::uint32_t row{0}; row < height; ++row) {
+      std::copy_n(thumbnail.rgba.data() + (std::size_t{row} * width * 4),
+                  std::size_t{width} * 4,
+                  page.pixels.data() + offset(rect.x, rect.y + row));
+    }
+    glBindTexture(GL_TEXTURE_2D, page.texture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(rect.x),
+                    static_cast<GLint>(rect.y), thumbnail.width,
+                    thumbnail.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                    thumbnail.rgba.data());
+    return handle;
+  }
+
+  auto erase(Handle handle) noexcept -> void { packer_.release(handle); }
+
+  [[nodiscard]] auto sprite(Handle handle) const -> Sprite {
+    const auto& rect{packer_.rect(handle)};
+    const auto width{static_cast<float>(rect.width - Gutter)};
+    const auto height{static_cast<float>(rect.height - Gutter)};
+    const auto scale{1.0F / static_cast<float>(PageSize)};
+    const ImVec2 uv0(static_cast<float>(rect.x) * scale,
+                     static_cast<float>(rect.y) * scale);
+    return {pages_[rect.page].texture, ImVec2(width, height), uv0,
+            ImVec2(uv0.x + (width * scale), uv0.y + (height * scale))};
+  }
+
+  [[nodiscard]] auto bytes(Handle handle) const noexcept -> std::size_t {
+    const auto& rect{packer_.rect(handle)};
+    return std::size_t{rect.width - Gutter} * (rect.height - Gutter) * 4;
+  }
+  [[nodiscard]] auto page_count() const noexcept -> std::size_t {
+    return pages_.size();
+  }
+
+ private:
+  /// \brief A page's texture and a copy of its pixels, kept so repacking
+  /// can move entries without reading back from GL.
+  struct Page {
+    GLuint texture;
+    std::vector<unsigned char> pixels;
+  };
+
+  static auto offset(std::uint32_t x, std::uint32_t y) noexcept
+      -> std::size_t {
+    return ((std::size_t{y} * PageSize) + x) * 4;
+  }
+
+  auto add_page() -> void {
+    const csc::profile::ScopedTimer timer{csc::profile::Stage::Upload};
+    Page page{0, std::vector<unsigned char>(offset(0, PageSize))};
+    glGenTextures(1, &page.texture);
+    glBindTexture(GL_TEXTURE_2D, page.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PageSize, PageSize, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, page.pixels.data());
+    pages_.push_back(std::move(page));
+  }
+
+  /// \brief Repacks `page` to reclaim the holes left by erased entries, and
+  /// uploads it whole.
+  auto compact(std::uint32_t index) -> void {
+    const auto moves{packer_.compact(index)};
+    if (moves.empty() or index >= pages_.size()) {
+      return;
+    }
+    const csc::profile::ScopedTimer timer{csc::profile::Stage::Upload};
+    auto& page{pages_[index]};
+    std::vector<unsigned char> repacked(page.pixels.size());
+    for (const auto& [handle, from, to] : moves) {
+      for (std::uint32_t row{0}; row < from.height; ++row) {
+        std::copy_n(page.pixels.data() + offset(from.x, from.y + row),
+                    std::size_t{from.width} * 4,
+                    repacked.data() + offset(to.x, to.y + row));
+      }
+    }
+    page.pixels = std::move(repacked);
+    glBindTexture(GL_TEXTURE_2D, page.texture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PageSize, PageSize, GL_RGBA,
+                    GL_UNSIGNED_BYTE, page.pixels.data());
+  }
+
+  csc::atlas::ShelfPacker packer_{PageSize, MaxPages};
+  std::vector<Page> pages_;
+};
+
+/// \brief Hits and misses of one kind of texture lookup, in the metrics
+/// registry.
+struct CacheCounters {
+  explicit CacheCounters(const std::string& kind)
+      : hits{csc::metrics::global().counter(
+            "csc_texture_cache_hits_total",
+            "Texture lookups served without decoding.",
+            "kind=\"" + kind + "\"")},
+        misses{csc::metrics::global().counter(
+            "csc_texture_cache_misses_total",
+            "Texture lookups that started a decode.",
+            "kind=\"" + kind + "\"")} {}
+
+  csc::metrics::Counter& hits;
+  csc::metrics::Counter& misses;
+};
+
+/// \brief Images keyed by the content hash of their file, so copies, links
+/// and differently spelled paths of one picture share one decode and one
+/// texture. Full-size textures for the single view are evicted least
+/// recently used past a memory budget; grid thumbnails live in an `Atlas`
+/// and are evicted when it fills.
+class TextureCache {
+ public:
+  /// Full-size texture memory kept before evicting.
+  static constexpr std::size_t Budget{512UZ * 1024UZ * 1024UZ};
+  /// Decodes running in the background at once.
+  static constexpr std::size_t MaxInFlight{8};
+  /// Finished decodes uploaded per frame, so a burst of them cannot stall
+  /// one frame.
+  static constexpr std::size_t UploadsPerFrame{4};
+
+  /// \brief The full-size texture for `image`, decoding it now if need be.
+  auto get(const csc::ImageRecord& image) -> const Image& {
+    const auto hash{resolve(image)};
+    if (not hash) {
+      throw std::runtime_error("Failed to load image");
+    }
+    if (auto found = textures_.find(*hash); found != textures_.end()) {
+      found->second.last_used = frame_;
+      full_counters_.hits.add();
+      return found->second.image;
+    }
+    full_counters_.misses.add();
+    Image loaded{
+        csc::paths::dictionary().text(image.get_thumbnail_id()).c_str()};
+    bytes_ += loaded.bytes();
+    const auto placed{
+        textures_.emplace(*hash, Texture{std::move(loaded), frame_})};
+    return placed.first->second.image;
+  }
+
+  /// \brief The grid thumbnail for `image` if it is in the atlas. Otherwise
+  /// starts decoding it in the background, if there is room, and returns
+  /// nothing; ask again next frame.
+  auto request(const csc::ImageRecord& image) -> std::optional<Atlas::Sprite> {
+    const auto hash{resolve(image)};
+    if (not hash) {
+      return std::nullopt;
+    }
+    if (auto found = thumbnails_.find(*hash); found != thumbnails_.end()) {
+      found->second.last_used = frame_;
+      thumbnail_counters_.hits.add();
+      return atlas_.sprite(found->second.handle);
+    }
+    if (pending_.size() < MaxInFlight and not pending_.contains(*hash) and
+        not undecodable_.contains(*hash)) {
+      thumbnail_counters_.misses.add();
+      pending_.emplace(*hash,
+                       std::async(std::launch::async, image::DecodeThumbnail,
+                                  csc::paths::dictionary().text(
+                                      image.get_thumbnail_id()),
+                                  static_cast<int>(GridConfig::Thumbnail)));
+    }
+    return std::nullopt;
+  }
+
+  /// \brief Adds finished thumbnails to the atlas and evicts full-size
+  /// textures over budget. Call once at the start of each frame, while
+  /// nothing from the last one is in use.
+  auto poll() -> void {
+    ++frame_;
+    std::size_t uploads{0};
+    for (auto it{pending_.begin()};
+         it != pending_.end() and uploads < UploadsPerFrame;) {
+      if (it->second.wait_for(std::chrono::seconds{0}) !=
+          std::future_status::ready) {
+        ++it;
+        continue;
+      }
+      if (auto thumbnail = it->second.get()) {
+        add_thumbnail(it->first, *thumbnail);
+        ++uploads;
+      } else {
+        undecodable_.insert(it->first);
+      }
+      it = pending_.erase(it);
+    }
+    if (bytes_ > Budget) {
+      evict_textures();
+    }
+  }
+
+  /// \brief Waits for the decodes in flight and deletes every texture. Call
+  /// while the GL context is still current, before it is destroyed.
+  auto clear() -> void {
+    for (auto& [hash, decode] : pending_) {
+      decode.wait();
+    }
+    pending_.clear();
+    textures_.clear();
+    thumbnails_.clear();
+    atlas_.clear();
+    bytes_ = 0;
+  }
+
+  /// \brief Whether `image`'s thumbnail could not be read or decoded. Such
+  /// files are not tried again, so the grid shows a placeholder for them.
+  [[nodiscard]] auto is_unreadable(const csc::ImageRecord& image) -> bool {
+    const auto hash{resolve(image)};
+    return not hash or undecodable_.contains(*hash);
+  }
+
+  /// \brief Texture memory not spent on paths whose content is loaded under
+  /// another path: each loaded entry once for every extra spelling of it.
+  /// Counted from what is loaded now, so evicted entries drop out.
+  [[nodiscard]] auto bytes_saved() const -> std::size_t {
+    std::size_t saved{0};
+    for (const auto& [hash, texture] : textures_) {
+      saved += texture.image.bytes() * (spellings_.at(hash) - 1);
+    }
+    for (const auto& [hash, thumbnail] : thumbnails_) {
+      saved += atlas_.bytes(thumbnail.handle) * (spellings_.at(hash) - 1);
+    }
+    return saved;
+  }
+  [[nodiscard]] auto size() const noexcept -> std::size_t {
+    return textures_.size() + thumbnails_.size();
+  }
+
+ private:
+  struct Texture {
+    Image image;
+    std::uint64_t last_used;
+  };
+  struct Thumbnail {
+    Atlas::Handle handle;
+    std::uint64_t last_used;
+  };
+
+  /// \brief The content hash of `image`'s thumbnail, hashing the file only
+  /// for records ingested without one. A file that cannot be read is only
+  /// tried once.
+  auto resolve(const csc::ImageRecord& image)
+      -> std::optional<csc::content::Hash> {
+    // Looked up by path id, as this runs for every cell in view every frame.
+    const auto path{image.get_thumbnail_id()};
+    if (auto known = paths_.find(path); known != paths_.end()) {
+      return known->second;
+    }
+    auto hash{image.get_content_hash()};
+    if (not hash) {
+      hash = csc::content::hash_file(image.get_thumbnail_path());
+    }
+    paths_.emplace(path, hash);
+    if (not hash) {
+      return std::nullopt;
+    }
+    ++spellings_[*hash];
+    return hash;
+  }
+
+  auto add_thumbnail(csc::content::Hash hash,
+                     const image::Thumbnail& thumbnail) -> void {
+    auto handle{atlas_.insert(thumbnail)};
+    if (not handle) {
+      evict_thumbnails();
+      handle = atlas_.insert(thumbnail);
+    }
+    if (handle) {
+      thumbnails_.insert_or_assign(hash, Thumbnail{*handle, frame_});
+    }
+  }
+
+  /// \brief The keys of `entries` not used this frame, least recently used
+  /// first.
+  template <typename Entries>
+  auto by_age(const Entries& entries) const
+      -> std::vector<csc::content::Hash> {
+    std::vector<std::pair<std::uint64_t, csc::content::Hash>> aged;
+    aged.reserve(entries.size());
+    for (const auto& [hash, entry] : entries) {
+      if (entry.last_used < frame_) {
+        aged.emplace_back(entry.last_used, hash);
+      }
+    }
+    std::ranges::sort(aged);
+    std::vector<csc::content::Hash> hashes;
+    hashes.reserve(aged.size());
+    for (const auto& [last_used, hash] : aged) {
+      hashes.push_back(hash);
+    }
+    return hashes;
+  }
+
+  /// \brief Drops the least recently used full-size textures, down to three
+  /// quarters of the budget so eviction is not repeated every frame.
+  auto evict_textures() -> void {
+    for (const auto hash : by_age(textures_)) {
+      if (bytes_ <= Budget / 4 * 3) {
+        break;
+      }
+      const auto found{textures_.find(hash)};
+      bytes_ -= found->second.image.bytes();
+      textures_.erase(found);
+    }
+  }
+
+  /// \brief Drops the least recently used quarter of the thumbnails, so the
+  /// atlas has room for a screenful before it fills again.
+  auto evict_thumbnails() -> void {
+    const auto hashes{by_age(thumbnails_)};
+    const auto count{std::max<std::size_t>(1, thumbnails_.size() / 4)};
+    for (std::size_t i{0}; i < std::min(count, hashes.size()); ++i) {
+      const auto found{thumbnails_.find(hashes[i])};
+      atlas_.erase(found->second.handle);
+      thumbnails_.erase(found);
+    }
+  }
+
+  /// Every path spelling seen, to the content hash it resolved to, or
+  /// nothing if the file could not be read.
+  std::unordered_map<csc::paths::PathId, std::optional<csc::content::Hash>>
+      paths_;
+  /// How many of `paths_` resolved to each content hash.
+  std::unordered_map<csc::content::Hash, std::size_t> spellings_;
+  std::unordered_map<csc::content::Hash, Texture> textures_;
+  std::unordered_map<csc::content::Hash, Thumbnail> thumbnails_;
+  std::unordered_map<csc::content::Hash,
+                     std::future<std::optional<image::Thumbnail>>>
+      pending_;
+  /// Content whose decode failed.
+  std::unordered_set<csc::content::Hash> undecodable_;
+  Atlas atlas_;
+  std::uint64_t frame_{0};
+  std::size_t bytes_{0};
+  CacheCounters full_counters_{"full"};
+  CacheCounters thumbnail_counters_{"thumbnail"};
+};
+
 }  // namespace render
 
 static void glfw_error_callback(int error, const char* description) {
@@ -235,8 +753,12 @@ constexpr inline auto GetGlslVersion() -> const char* {
 
 class MediaImages : public csc::UserInterface {
  private:
-  using ImageAtlas = std::unordered_map<std::string, render::Image>;
-  static inline ImageAtlas images;
+  static inline render::TextureCache textures;
+  static inline csc::frame::LabelCache labels;
+  /// Formatted text for the current frame.
+  static inline csc::frame::Arena frame_text;
+  /// UI-thread heap allocations during the last frame.
+  static inline std::uint64_t frame_allocations{0};
 
  public:
   auto run() -> void {
@@ -275,6 +797,8 @@ class MediaImages : public csc::UserInterface {
     while (!glfwWindowShouldClose(window_))
 #endif
     {
+      const auto frame_start{csc::profile::ScopedTimer::Clock::now()};
+      const auto allocations_at_start{csc::allocations::count()};
       glfwPollEvents();
       if (glfwGetWindowAttrib(window_, GLFW_ICONIFIED) != 0) {
         ImGui_ImplGlfw_Sleep(10);
@@ -285,30 +809,46 @@ class MediaImages : public csc::UserInterface {
       ImGui_ImplOpenGL3_NewFrame();
       ImGui_ImplGlfw_NewFrame();
       ImGui::NewFrame();
+      textures.poll();
 
       {
+        const csc::profile::ScopedTimer timer{csc::profile::Stage::Layout};
         static float f = 0.0F;
         static int counter = 0;
 
         ImGui::Begin(WindowConfig::Title);
 
         root();
+        show_overlay_toggles();
 
         ImGui::End();
+
+        show_frame_times();
+        show_statistics();
       }
 
       // Rendering
-      ImGui::Render();
-      int display_w;
-      int display_h;
-      glfwGetFramebufferSize(window_, &display_w, &display_h);
-      glViewport(0, 0, display_w, display_h);
-      glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w,
-                   clear_color.z * clear_color.w, clear_color.w);
-      glClear(GL_COLOR_BUFFER_BIT);
-      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+      {
+        const csc::profile::ScopedTimer timer{csc::profile::Stage::Render};
+        ImGui::Render();
+        int display_w;
+        int display_h;
+        glfwGetFramebufferSize(window_, &display_w, &display_h);
+        glViewport(0, 0, display_w, display_h);
+        glClearColor(clear_color.x * clear_color.w,
+                     clear_color.y * clear_color.w,
+                     clear_color.z * clear_color.w, clear_color.w);
+        glClear(GL_COLOR_BUFFER_BIT);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+      }
+      frame_text.reset();
 
       glfwSwapBuffers(window_);
+      frame_allocations = csc::allocations::count() - allocations_at_start;
+      if (auto& profiler{csc::profile::global()}; profiler.enabled()) {
+        profiler.end_frame(csc::profile::ScopedTimer::Clock::now() -
+                           frame_start);
+      }
 
       if (state_ == State::Exit) {
         glfwSetWindowShouldClose(window_, GL_TRUE);
@@ -355,7 +895,8 @@ class MediaImages : public csc::UserInterface {
     ImGui::CreateContext();
   }
   ~MediaImages() override {
-    // Cleanup
+    // Cleanup, textures first while the GL context still exists
+    textures.clear();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -367,22 +908,21 @@ class MediaImages : public csc::UserInterface {
   }
 
   void put(std::string_view message) const override {
-    ImGui::Text("%s", message.data());
+    ImGui::TextUnformatted(message.data(), message.data() + message.size());
   }
   void putln(std::string_view message) const override {
-    ImGui::Text("%s\n", message.data());
+    put(frame_text.format("{}\n", message));
+  }
+  /// Formatted output goes to the frame arena rather than a new string.
+  void vput(std::string_view fmt, std::format_args args) const override {
+    put(frame_text.vformat(fmt, args));
+  }
+  void vputln(std::string_view fmt, std::format_args args) const override {
+    putln(frame_text.vformat(fmt, args));
   }
   void show_image(const csc::ImageRecord& image) const override {
-    auto path{image.get_thumbnail_path().string()};
-    if (not images.contains(path)) {
-      load_image(path.c_str());
-    }
-    const auto& renderable_image{images.at(path)};
-    renderable_image.render();
-
-    println("Title: {}, Description: {}, Genre: {}, Date taken: {}",
-            image.get_title(), image.get_description(),
-            image.get_genre().to_string(), image.get_date_taken().to_string());
+    textures.get(image).render();
+    put(labels.get(image, get_image_manager().version()).details);
   }
 
   void clear_screen() const override {}
@@ -394,40 +934,56 @@ class MediaImages : public csc::UserInterface {
   void wait_for_enter() const noexcept override {}
 
  private:
-  static inline std::optional<csc::ImageAlbum> current_images{std::nullopt};
+  /// \brief What is being browsed: a cached result, an album of its own, or
+  /// the catalog itself, borrowed rather than copied.
+  static inline csc::query::Result current_images;
+  static inline csc::AlbumCursor cursor;
+  static inline bool statistics_open{false};
+
+  /// \brief The live records of `current_images` by position, for the grid.
+  static inline std::vector<const csc::ImageRecord*> current_records;
 
   void show_current_images() {
     static const csc::ImageRecord* image{nullptr};
     static const char* message{nullptr};
+    static bool grid_view{false};
 
-    if (not current_images.has_value() or current_images->size() == 0) {
+    if (not current_images or current_images->size() == 0) {
       ImGui::Text("There are no images");
       goto ExitButtonLabel;
     } else {
       if (not image) {
         try {
-          image = &current_images->get_first_image();
+          image = &cursor.first();
         } catch (...) {
           std::unreachable();
         }
       }
     }
 
-    if (image) {
+    if (grid_view) {
+      show_image_grid();
+    } else if (image) {
       show_image(*image);
     }
+    ImGui::Text("%zu textures, %zu KiB saved by sharing identical files",
+                textures.size(), textures.bytes_saved() / 1024);
 
-    if (ImGui::Button("Next")) {
+    if (ImGui::Button(grid_view ? "Single view" : "Grid view")) {
+      grid_view = not grid_view;
+      message = nullptr;
+    }
+    if (not grid_view and ImGui::Button("Next")) {
       try {
-        image = &current_images->get_next_image();
+        image = &cursor.next();
         message = nullptr;
       } catch (...) {
         message = "No more images";
       }
     }
-    if (ImGui::Button("Previous")) {
+    if (not grid_view and ImGui::Button("Previous")) {
       try {
-        image = &current_images->get_previous_image();
+        image = &cursor.previous();
         message = nullptr;
       } catch (...) {
         message = "No previous image";
@@ -445,14 +1001,193 @@ class MediaImages : public csc::UserInterface {
     }
   }
 
-  template <std::size_t Size>
-  using Buffer = std::array<char, Size>;
+  /// \brief Thumbnails of `current_records` in rows filling the window.
+  /// Only the rows in view are laid out and drawn, and their textures are
+  /// decoded in the background as they come into view, so a frame costs the
+  /// same for ten results as for a hundred thousand.
+  void show_image_grid() {
+    // Leave room for the status line and buttons below.
+    ImGui::BeginChild("##Grid",
+                      ImVec2(0, -4 * ImGui::GetFrameHeightWithSpacing()));
+    const auto spacing{ImGui::GetStyle().ItemSpacing};
+    const ImVec2 cell(GridConfig::Thumbnail, GridConfig::Thumbnail);
+    const auto columns{std::max(
+        1, static_cast<int>((ImGui::GetContentRegionAvail().x + spacing.x) /
+                            (cell.x + spacing.x)))};
+    const auto count{static_cast<int>(current_records.size())};
+    const auto rows{(count + columns - 1) / columns};
+    const auto record_at = [&](int row,
+                               int column) -> const csc::ImageRecord* {
+      const auto index{(row * columns) + column};
+      return index < count ? current_records[static_cast<std::size_t>(index)]
+                           : nullptr;
+    };
+
+    ImGuiListClipper clipper;
+    clipper.Begin(rows, cell.y + spacing.y);
+    auto first_row{rows};
+    auto end_row{0};
+    while (clipper.Step()) {
+      first_row = std::min(first_row, clipper.DisplayStart);
+      end_row = std::max(end_row, clipper.DisplayEnd);
+      for (auto row{clipper.DisplayStart}; row < clipper.DisplayEnd; ++row) {
+        for (auto column{0}; column < columns; ++column) {
+          const auto* record{record_at(row, column)};
+          if (record == nullptr) {
+            break;
+          }
+          if (column != 0) {
+            ImGui::SameLine();
+          }
+          show_grid_cell(*record, cell);
+        }
+      }
+    }
+    clipper.End();
+
+    // Start on the rows just out of view, after the visible ones have had
+    // first claim on the decoders.
+    const auto prefetch = [&](int begin, int end) {
+      for (auto row{std::max(0, begin)}; row < std::min(rows, end); ++row) {
+        for (auto column{0}; column < columns; ++column) {
+          if (const auto* record = record_at(row, column)) {
+            textures.request(*record);
+          }
+        }
+      }
+    };
+    prefetch(end_row, end_row + GridConfig::PrefetchRows);
+    prefetch(first_row - GridConfig::PrefetchRows, first_row);
+    ImGui::EndChild();
+  }
 
-  void load_image(const char* file_name) const {
-    render::Image my_image{file_name};
-    images.insert({std::string(file_name), my_image});
+  /// \brief One thumbnail, an empty cell until its texture is ready, or a
+  /// crossed-out cell if it cannot be.
+  void show_grid_cell(const csc::ImageRecord& image, ImVec2 cell) {
+    const auto origin{ImGui::GetCursorScreenPos()};
+    ImGui::Dummy(cell);
+    if (const auto sprite = textures.request(image)) {
+      sprite->render_fitted(origin, cell);
+    } else if (textures.is_unreadable(image)) {
+      const ImVec2 end(origin.x + cell.x, origin.y + cell.y);
+      const auto colour{IM_COL32(128, 128, 128, 255)};
+      auto* const draw{ImGui::GetWindowDrawList()};
+      draw->AddRect(origin, end, colour);
+      draw->AddLine(origin, end, colour);
+      draw->AddLine(ImVec2(end.x, origin.y), ImVec2(origin.x, end.y), colour);
+    }
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip(
+          "%s",
+          labels.get(image, get_image_manager().version()).tooltip.c_str());
+    }
   }
 
+  /// \brief Turns the frame-time overlay, and with it the profiler, and the
+  /// statistics panel on and off.
+  void show_overlay_toggles() {
+    auto& profiler{csc::profile::global()};
+    bool enabled{profiler.enabled()};
+    ImGui::Separator();
+    if (ImGui::Checkbox("Show frame times", &enabled)) {
+      profiler.enable(enabled);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Show statistics", &statistics_open);
+  }
+
+  /// \brief The metrics registry as text, and a way to save it.
+  void show_statistics() {
+    static Buffer<256> file{"metrics.prom"};
+    static std::string message;
+    if (not statistics_open) {
+      return;
+    }
+    get_image_manager().sample_metrics();
+    ImGui::SetNextWindowPos(ImVec2(10, 320), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Statistics", &statistics_open,
+                     ImGuiWindowFlags_AlwaysAutoResize)) {
+      std::ostringstream text;
+      csc::facet::write_text(
+          text, get_image_manager().facets(csc::facet::Period::Year));
+      csc::metrics::global().write_text(text);
+      const auto lines{text.str()};
+      ImGui::TextUnformatted(lines.c_str(), lines.c_str() + lines.size());
+
+      ImGui::Separator();
+      ImGui::InputText("##MetricsFile", file.data(), file.size());
+      ImGui::SameLine();
+      if (ImGui::Button("Save")) {
+        try {
+          csc::metrics::global().write_file(file.data());
+          message = "Saved (.prom files are in Prometheus format)";
+        } catch (const std::exception& e) {
+          message = e.what();
+        }
+      }
+      if (not message.empty()) {
+        ImGui::TextUnformatted(message.c_str());
+      }
+    }
+    ImGui::End();
+  }
+
+  /// \brief Times of the last `Profiler::Frames` frames, and the mean, p50
+  /// and p99 of the whole frame and of each stage in milliseconds. Decodes
+  /// and uploads done while laying out also count towards layout.
+  void show_frame_times() {
+    auto& profiler{csc::profile::global()};
+    if (not profiler.enabled()) {
+      return;
+    }
+    bool open{true};
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.85F);
+    if (ImGui::Begin("Frame times", &open,
+                     ImGuiWindowFlags_AlwaysAutoResize)) {
+      std::array<float, csc::profile::Profiler::Frames> times{};
+      const auto count{profiler.frame_times(times)};
+      ImGui::PlotLines("##Frames", times.data(), static_cast<int>(count), 0,
+                       nullptr, 0.0F, std::numeric_limits<float>::max(),
+                       ImVec2(OverlayConfig::PlotWidth,
+                              OverlayConfig::PlotHeight));
+
+      const auto row = [](const char* name, csc::profile::Percentiles times) {
+        ImGui::Text("%-7s %7.2f %7.2f %7.2f", name, times.mean, times.p50,
+                    times.p99);
+      };
+      ImGui::Text("UI thread heap allocations last frame: %llu",
+                  static_cast<unsigned long long>(frame_allocations));
+      ImGui::Text("%-7s %7s %7s %7s", "ms", "mean", "p50", "p99");
+      row("Frame", profiler.frame_percentiles());
+      for (std::size_t i{0}; i < csc::profile::StageCount; ++i) {
+        const auto stage{static_cast<csc::profile::Stage>(i)};
+        row(csc::profile::stage_name(stage).data(),
+            profiler.stage_percentiles(stage));
+      }
+    }
+    ImGui::End();
+    if (not open) {
+      profiler.enable(false);
+    }
+  }
+
+  /// \brief Runs `search` on the image manager under the search timer.
+  template <typename Search>
+  auto timed_search(Search&& search) {
+    const csc::profile::ScopedTimer timer{csc::profile::Stage::Search};
+    return std::invoke(std::forward<Search>(search), get_image_manager());
+  }
+
+  /// \brief Answers `query` through the result cache under the search timer.
+  auto timed_query(const csc::query::Query& query) -> csc::query::Result {
+    const csc::profile::ScopedTimer timer{csc::profile::Stage::Search};
+    return cached_search(query);
+  }
+
+  template <std::size_t Size>
+  using Buffer = std::array<char, Size>;
+
   void root() {
     switch (state_) {
       case State::Base: {
@@ -546,6 +1281,7 @@ class MediaImages : public csc::UserInterface {
     static Buffer<32> title{0};
     static Buffer<64> description{0};
     static int genre{0};
+    static Buffer<128> tag_list{0};
 
     static Buffer<5> year{0};
     static Buffer<3> month{0};
@@ -559,6 +1295,7 @@ class MediaImages : public csc::UserInterface {
       title[0] = 0;
       description[0] = 0;
       genre = 0;
+      tag_list[0] = 0;
 
       year[0] = 0;
       month[0] = 0;
@@ -577,6 +1314,8 @@ class MediaImages : public csc::UserInterface {
     put("Genre:");
     ImGui::Combo("##Genre", &genre, GenreExtractor::MyOptions::OptionsCStr,
                  GenreExtractor::MyOptions::Size);
+    put("Tags:");
+    ImGui::InputText("##Tags", tag_list.data(), tag_list.size());
 
     put("Year:");
     ImGui::InputText("##Year", year.data(), year.size());
@@ -597,14 +1336,17 @@ class MediaImages : public csc::UserInterface {
         auto day_ul{std::stoul(day.data())};
 
         std::filesystem::path valid_path{thumbnail_path.data()};
-        emplace_image(csc::ImageRecord{
+        csc::ImageRecord image{
             title.data(),
             description.data(),
             GenreExtractor::value_at(genre),
             {{std::chrono::year(year_ul), std::chrono::month(month_ul),
               std::chrono::day(day_ul)},
              {}},
-            std::move(valid_path)});
+            std::move(valid_path)};
+        image.set_tags(csc::tags::parse_list(tag_list.data()));
+        csc::ingest::inspect(image);
+        emplace_image(std::move(image));
 
         Reset();
 
@@ -629,12 +1371,14 @@ class MediaImages : public csc::UserInterface {
       Description,
       Genre,
       Date,
+      Tags,
     };
     static int search_criteria{0};
     using Extractor = csc::Extractor<csc::OptionPack<
         {"Id", SearchCriteria::Id}, {"Title", SearchCriteria::Title},
         {"Description", SearchCriteria::Description},
-        {"Genre", SearchCriteria::Genre}, {"Date", SearchCriteria::Date}>>;
+        {"Genre", SearchCriteria::Genre}, {"Date", SearchCriteria::Date},
+        {"Tags", SearchCriteria::Tags}>>;
 
     if (ImGui::Combo("##SearchCriteria", &search_criteria,
                      Extractor::MyOptions::OptionsCStr,
@@ -664,6 +1408,10 @@ class MediaImages : public csc::UserInterface {
         search_date();
         break;
       }
+      case SearchCriteria::Tags: {
+        search_tags();
+        break;
+      }
     }
   }
   void search_id() {
@@ -677,14 +1425,12 @@ class MediaImages : public csc::UserInterface {
         auto number_id = std::stoull(id);
 
         id[0] = 0;
-        auto image = get_image_manager().search_id(number_id);
+        auto image = timed_search(
+            [number_id](auto& images) { return images.search_id(number_id); });
 
         if (image) {
-          auto true_image = **image;
-          csc::ImageManager manager;
-          manager.add_image(true_image);
-
-          transition_to_display_with_images(manager.take_album());
+          transition_to_display_with_images(
+              csc::ImageAlbum{csc::ImageRecord{**image}});
         }
       } catch (...) {
         message = "Enter a number for the id";
@@ -696,25 +1442,113 @@ class MediaImages : public csc::UserInterface {
   }
   void search_title() {
     static std::string title(32, '\0');
+    static csc::live::LiveSearch live{csc::live::Field::Title};
     ImGui::Text("Title");
     ImGui::InputText("##Title", title.data(), title.size());
+    show_title_suggestions(title);
 
     if (enter_pressed()) {
-      auto album{get_image_manager().search_title(title)};
+      // Nothing typed lists nothing live, but Enter still shows everything.
+      if (title[0] != 0 and live.complete()) {
+        transition_to_display_with_images(matched_album(live));
+      } else {
+        transition_to_display_with_images(
+            timed_query(csc::query::Title{title.c_str()}));
+      }
       title[0] = 0;
-      transition_to_display_with_images(std::move(album));
+      return;
     }
+    show_live_matches(live, title.c_str());
   }
   void search_description() {
     static Buffer<64> description{0};
+    static csc::live::LiveSearch live{csc::live::Field::Description};
     ImGui::Text("Description");
     ImGui::InputText("##Description", description.data(), description.size());
 
     if (enter_pressed()) {
-      auto album{get_image_manager().search_description(description.data())};
+      if (description[0] != 0 and live.complete()) {
+        transition_to_display_with_images(matched_album(live));
+      } else {
+        transition_to_display_with_images(
+            timed_query(csc::query::Description{description.data()}));
+      }
       description[0] = 0;
-      transition_to_display_with_images(std::move(album));
+      return;
+    }
+    show_live_matches(live, description.data());
+  }
+  /// \brief Completions of what has been typed, as buttons that replace it.
+  void show_title_suggestions(std::string& title) {
+    // Looked up again only when the text or the catalog changes.
+    static std::string typed;
+    static std::uint64_t version{0};
+    static std::vector<std::string> suggestions;
+    if (title[0] == '\0') {
+      return;
+    }
+    const auto& manager{get_image_manager()};
+    if (typed != title.c_str() or version != manager.version()) {
+      typed = title.c_str();
+      version = manager.version();
+      suggestions.clear();
+      for (const auto& suggestion : manager.suggest_titles(typed)) {
+        suggestions.emplace_back(suggestion.text);
+      }
     }
+    for (std::size_t i{0}; i < suggestions.size(); ++i) {
+      const auto& text{suggestions[i]};
+      if (i != 0) {
+        ImGui::SameLine();
+      }
+      ImGui::PushID(static_cast<int>(i));
+      if (ImGui::SmallButton(text.c_str())) {
+        const auto length{std::min(text.size(), title.size() - 1)};
+        std::ranges::copy_n(text.begin(), static_cast<std::ptrdiff_t>(length),
+                            title.begin());
+        title[length] = '\0';
+      }
+      ImGui::PopID();
+    }
+  }
+  /// \brief Filters on every keystroke and lists what has matched so far.
+  /// The scan runs in the background, so only the rows in view cost a frame.
+  void show_live_matches(csc::live::LiveSearch& live, const char* text) {
+    const auto& manager{get_image_manager()};
+    live.update(manager, text);
+    if (*text == '\0') {
+      return;
+    }
+    const auto matches{live.matches()};
+    ImGui::Text(live.complete() ? "%zu matches" : "%zu matches so far...",
+                matches.size());
+
+    ImGui::BeginChild("##Matches",
+                      ImVec2(0, -4 * ImGui::GetFrameHeightWithSpacing()));
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(matches.size()));
+    while (clipper.Step()) {
+      for (auto row{clipper.DisplayStart}; row < clipper.DisplayEnd; ++row) {
+        const auto& image{
+            live.record(manager, matches[static_cast<std::size_t>(row)])};
+        const auto title{image.get_title()};
+        ImGui::TextUnformatted(title.data(), title.data() + title.size());
+      }
+    }
+    clipper.End();
+    ImGui::EndChild();
+  }
+  /// \brief The finished live matches as an album, without searching again.
+  auto matched_album(const csc::live::LiveSearch& live) -> csc::ImageAlbum {
+    const csc::profile::ScopedTimer timer{csc::profile::Stage::Search};
+    const auto& manager{get_image_manager()};
+    const auto matches{live.matches()};
+    csc::ImageAlbum::ImageCollection images;
+    images.reserve(matches.size());
+    for (const auto match : matches) {
+      images.push_back(live.record(manager, match));
+    }
+    return csc::ImageAlbum{std::move(images)};
   }
   void search_genre() {
     using Extraction = GetFromTheseOptions<
@@ -757,7 +1591,19 @@ class MediaImages : public csc::UserInterface {
 
     if (genre) {
       transition_to_display_with_images(
-          get_image_manager().search_genre(*genre));
+          timed_query(csc::query::Genre{*genre}));
+    }
+  }
+
+  /// \brief Genres count as tags, so `Food -dessert` works as well.
+  void search_tags() {
+    static std::string text(128, '\0');
+    ImGui::Text("Enter tags (a|b for either, -a to exclude):");
+    ImGui::InputText("##Tags", text.data(), text.size());
+
+    if (enter_pressed()) {
+      transition_to_display_with_images(timed_query(
+          csc::query::Tags{csc::tags::parse_query(text.c_str())}));
     }
   }
 
@@ -772,35 +1618,14 @@ class MediaImages : public csc::UserInterface {
     ImGui::InputText(time_label, time, std::size(time));
   }
 
+  /// \brief Accepts the same dates as imports: YYYY/MM/DD or YYYY-MM-DD, and
+  /// a time of HH:MM[:SS].
   auto input_to_date(char (&date)[11],
                      char (&time)[9]) -> std::optional<csc::date::DateTime> {
-    int year;
-    int month;
-    int day;
-    auto status = std::sscanf(date, "%d/%d/%d", &year, &month, &day);  // NOLINT
-    if (status != 3) {
-      return std::nullopt;
-    }
-
-    int hour;
-    int minute;
-    int second;
-    status = std::sscanf(time, "%d:%d:%d", &hour, &minute, &second);  // NOLINT
-    if (status != 3) {
-      return std::nullopt;
-    }
-
-    // NOLINTBEGIN
-    using d = std::chrono::day;
-    using m = std::chrono::month;
-    using y = std::chrono::year;
-    return csc::date::DateTime{
-        std::chrono::year_month_day{y(year), m(month), d(day)},
-        csc::date::Time{std::size_t(hour), std::size_t(minute),
-                        std::size_t(second)}};
-    // NOLINTEND
-
-    return std::nullopt;
+    std::string text{date};
+    text += ' ';
+    text += time;
+    return csc::date::parse_iso8601(text);
   }
 
   void search_date() {
@@ -822,7 +1647,7 @@ class MediaImages : public csc::UserInterface {
       auto to = input_to_date(date2, time2);
 
       if (from and to) {
-        auto images = get_image_manager().search_between_dates(*from, *to);
+        auto images = timed_query(csc::query::Dates{*from, *to});
         transition_to_display_with_images(std::move(images));
       }
       date1[0] = 0;
@@ -840,20 +1665,27 @@ class MediaImages : public csc::UserInterface {
   constexpr inline void transition_to_search_image() {
     state_ = State::SearchImage;
   }
-  inline void transition_to_display_with_images(
-      const csc::ImageManager& images) {
-    transition_to_display_with_images(images.get_all_images());
-  }
   inline void transition_to_display_with_images(csc::ImageAlbum&& images) {
-    current_images.emplace(std::move(images));
-    state_ = State::DisplayAll;
+    transition_to_display_with_images(
+        std::make_shared<const csc::ImageAlbum>(std::move(images)));
   }
-  inline void transition_to_display_with_images(const csc::ImageAlbum& images) {
-    current_images.emplace(images);
+  inline void transition_to_display_with_images(csc::query::Result images) {
+    current_images = std::move(images);
+    cursor = csc::AlbumCursor{*current_images};
+    index_current_images();
     state_ = State::DisplayAll;
   }
-  constexpr inline void transition_to_display_all() {
-    transition_to_display_with_images(get_all_images());
+  inline void index_current_images() {
+    current_records.clear();
+    for (const auto& image : *current_images) {
+      current_records.push_back(&image);
+    }
+  }
+  /// \brief Browses the catalog in place. It owns nothing, as the catalog
+  /// outlives the display and only changes in other states.
+  inline void transition_to_display_all() {
+    transition_to_display_with_images(
+        csc::query::Result{std::shared_ptr<void>{}, &get_all_images()});
   }
   constexpr inline void transition_to_exit() { state_ = State::Exit; }
 
@@ -869,6 +1701,7 @@ class MediaImages : public csc::UserInterface {
 
 // Main code
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) -> int {
+  const csc::trace::Session trace;
   MediaImages media_images{WindowConfig::Width, WindowConfig::Height,
                            WindowConfig::Title};
   media_images.run();
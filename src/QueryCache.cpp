@@ -0,0 +1,231 @@
+#include "csc/QueryCache.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "csc/ImageManager.hpp"
+#include "csc/Metrics.hpp"
+
+using namespace csc;         // NOLINT
+using namespace csc::query;  // NOLINT
+
+namespace {
+
+/// Results bigger than this share of the budget are returned uncached, so
+/// one huge answer cannot flush everything else.
+constexpr std::size_t LargestShare{4};
+
+template <typename Value>
+  requires(std::is_trivially_copyable_v<Value>)
+auto append_bytes(std::string& out, const Value& value) -> void {
+  const auto* const bytes{reinterpret_cast<const char*>(&value)};
+  out.append(bytes, sizeof(value));
+}
+
+auto append_date(std::string& out, const date::DateTime& date) -> void {
+  date.format_iso8601_to(std::back_inserter(out));
+  out += '\0';
+}
+
+/// \brief Sorted and deduplicated, so the same set of tags gives one key in
+/// whatever order it was written.
+auto append_tag_set(std::string& out, std::vector<tags::TagId> ids) -> void {
+  std::ranges::sort(ids);
+  const auto [first, last] = std::ranges::unique(ids);
+  ids.erase(first, last);
+  append_bytes(out, ids.size());
+  for (const auto id : ids) {
+    append_bytes(out, id);
+  }
+}
+
+struct CacheMetrics {
+  metrics::Counter& hits;
+  metrics::Counter& misses;
+  metrics::Gauge& bytes;
+};
+
+auto cache_metrics() -> const CacheMetrics& {
+  static const CacheMetrics metrics{[] {
+    auto& registry{metrics::global()};
+    return CacheMetrics{
+        .hits = registry.counter("csc_query_cache_hits_total",
+                                 "Searches answered from the result cache."),
+        .misses = registry.counter("csc_query_cache_misses_total",
+                                   "Searches the result cache had to run."),
+        .bytes = registry.gauge("csc_query_cache_bytes",
+                                "Approximate memory held by result caches."),
+    };
+  }()};
+  return metrics;
+}
+
+}  // namespace
+
+auto query::key(const Query& query) -> std::string {
+  std::string out;
+  append_bytes(out, static_cast<std::uint8_t>(query.index()));
+  std::visit(
+      [&out]<typename Criterion>(const Criterion& criterion) {
+        if constexpr (std::is_same_v<Criterion, Title> or
+                      std::is_same_v<Criterion, Description>) {
+          out += criterion.text;
+        } else if constexpr (std::is_same_v<Criterion, Genre>) {
+          append_bytes(out, criterion.genre.index());
+        } else if constexpr (std::is_same_v<Criterion, Dates>) {
+          // Every backwards range matches nothing, so they share one key.
+          if (criterion.from <= criterion.to) {
+            append_date(out, criterion.from);
+            append_date(out, criterion.to);
+          }
+        } else if constexpr (std::is_same_v<Criterion, MinSize>) {
+          append_bytes(out, criterion.width);
+          append_bytes(out, criterion.height);
+        } else if constexpr (std::is_same_v<Criterion, Orientation>) {
+          append_bytes(out, criterion.orientation);
+        } else if constexpr (std::is_same_v<Criterion, Similar>) {
+          append_bytes(out, criterion.hash);
+          append_bytes(out, std::min(criterion.max_distance, 64U));
+        } else if constexpr (std::is_same_v<Criterion, Colour>) {
+          append_bytes(out, criterion.signature);
+          append_bytes(out, criterion.k);
+        } else if constexpr (std::is_same_v<Criterion, Tags>) {
+          std::vector<std::string> groups;
+          for (const auto& group : criterion.query.groups) {
+            append_tag_set(groups.emplace_back(), group);
+          }
+          std::ranges::sort(groups);
+          append_bytes(out, groups.size());
+          for (const auto& group : groups) {
+            out += group;
+          }
+          append_tag_set(out, criterion.query.excluded);
+        }
+      },
+      query);
+  return out;
+}
+
+auto query::run(const ImageManager& manager, const Query& query,
+                std::pmr::memory_resource* resource) -> ImageAlbum {
+  return std::visit(
+      [&manager, resource]<typename Criterion>(const Criterion& criterion) {
+        if constexpr (std::is_same_v<Criterion, Title>) {
+          return manager.search_title(criterion.text, resource);
+        } else if constexpr (std::is_same_v<Criterion, Description>) {
+          return manager.search_description(criterion.text, resource);
+        } else if constexpr (std::is_same_v<Criterion, Genre>) {
+          return manager.search_genre(criterion.genre, resource);
+        } else if constexpr (std::is_same_v<Criterion, Dates>) {
+          return manager.search_between_dates(criterion.from, criterion.to,
+                                              resource);
+        } else if constexpr (std::is_same_v<Criterion, MinSize>) {
+          return manager.search_min_size(criterion.width, criterion.height,
+                                         resource);
+        } else if constexpr (std::is_same_v<Criterion, Orientation>) {
+          return manager.search_orientation(criterion.orientation, resource);
+        } else if constexpr (std::is_same_v<Criterion, Similar>) {
+          return manager.search_similar(criterion.hash, criterion.max_distance,
+                                        resource);
+        } else if constexpr (std::is_same_v<Criterion, Colour>) {
+          return manager.search_colour(criterion.signature, criterion.k,
+                                       resource);
+        } else {
+          return manager.search_tags(criterion.query, resource);
+        }
+      },
+      query);
+}
+
+auto query::approximate_bytes(const ImageAlbum& album) noexcept
+    -> std::size_t {
+  const auto& images{album.get_images()};
+  auto bytes{sizeof(ImageAlbum) + (images.capacity() * sizeof(ImageRecord))};
+  for (const auto& image : images) {
+    bytes += image.get_title().size() + image.get_description().size() +
+             (image.get_tags().size() * sizeof(tags::TagId));
+  }
+  return bytes;
+}
+
+ResultCache::~ResultCache() {
+  cache_metrics().bytes.add(-static_cast<std::int64_t>(bytes_));
+}
+
+auto ResultCache::search(const ImageManager& manager, const Query& query)
+    -> Result {
+  auto query_key{key(query)};
+  const auto version{manager.version()};
+  {
+    const std::lock_guard lock{mutex_};
+    if (const auto found = index_.find(query_key); found != index_.end()) {
+      const auto entry{found->second};
+      if (entry->version == version) {
+        entries_.splice(entries_.begin(), entries_, entry);
+        ++hits_;
+        cache_metrics().hits.add();
+        return entry->result;
+      }
+      erase(entry);
+    }
+    ++misses_;
+  }
+  cache_metrics().misses.add();
+
+  auto album{std::make_shared<const ImageAlbum>(run(manager, query))};
+  const auto bytes{approximate_bytes(*album) + (2 * query_key.size())};
+  if (bytes > budget_ / LargestShare) {
+    return album;
+  }
+
+  const std::lock_guard lock{mutex_};
+  // Another thread may have run the same query meanwhile.
+  if (const auto found = index_.find(query_key); found != index_.end()) {
+    erase(found->second);
+  }
+  entries_.push_front(Entry{std::move(query_key), album, version, bytes});
+  index_.emplace(entries_.front().key, entries_.begin());
+  bytes_ += bytes;
+  cache_metrics().bytes.add(static_cast<std::int64_t>(bytes));
+  while (bytes_ > budget_) {
+    erase(std::prev(entries_.end()));
+  }
+  return album;
+}
+
+auto ResultCache::erase(Entries::iterator entry) -> void {
+  bytes_ -= entry->bytes;
+  cache_metrics().bytes.add(-static_cast<std::int64_t>(entry->bytes));
+  index_.erase(entry->key);
+  entries_.erase(entry);
+}
+
+auto ResultCache::clear() -> void {
+  const std::lock_guard lock{mutex_};
+  cache_metrics().bytes.add(-static_cast<std::int64_t>(bytes_));
+  index_.clear();
+  entries_.clear();
+  bytes_ = 0;
+}
+
+auto ResultCache::hits() const -> std::uint64_t {
+  const std::lock_guard lock{mutex_};
+  return hits_;
+}
+
+auto ResultCache::misses() const -> std::uint64_t {
+  const std::lock_guard lock{mutex_};
+  return misses_;
+}
+
+auto ResultCache::bytes() const -> std::size_t {
+  const std::lock_guard lock{mutex_};
+  return bytes_;
+}
+
+auto ResultCache::size() const -> std::size_t {
+  const std::lock_guard lock{mutex_};
+  return entries_.size();
+}
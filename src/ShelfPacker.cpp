@@ -0,0 +1,151 @@
+#include "csc/ShelfPacker.hpp"
+
+#include <algorithm>
+
+using namespace csc;         // NOLINT
+using namespace csc::atlas;  // NOLINT
+
+namespace {
+
+/// Shelf heights are rounded up to a multiple of this, so entries of nearly
+/// equal height share shelves.
+constexpr std::uint32_t ShelfQuantum{8};
+
+constexpr auto shelf_height(std::uint32_t height) noexcept -> std::uint32_t {
+  return (height + ShelfQuantum - 1) / ShelfQuantum * ShelfQuantum;
+}
+
+}  // namespace
+
+auto ShelfPacker::allocate(std::uint32_t width,
+                           std::uint32_t height) -> std::optional<Handle> {
+  if (width == 0 or height == 0 or width > page_size_ or
+      height > page_size_) {
+    return std::nullopt;
+  }
+  for (std::uint32_t page{0}; page < pages_.size(); ++page) {
+    if (auto entry = place(page, width, height)) {
+      return store(*entry);
+    }
+  }
+  if (pages_.size() == max_pages_) {
+    return std::nullopt;
+  }
+  pages_.emplace_back();
+  return store(*place(static_cast<std::uint32_t>(pages_.size() - 1), width,
+                      height));
+}
+
+auto ShelfPacker::release(Handle handle) noexcept -> void {
+  auto& entry{entries_[handle]};
+  if (not entry.live) {
+    return;
+  }
+  entry.live = false;
+  free_handles_.push_back(handle);
+
+  auto& page{pages_[entry.rect.page]};
+  const auto area{std::uint64_t{entry.rect.width} * entry.rect.height};
+  page.live_area -= area;
+  if (--page.live_count == 0) {
+    page = Page{};
+    return;
+  }
+  auto& shelf{page.shelves[entry.shelf]};
+  if (entry.rect.x + entry.rect.width == shelf.used) {
+    shelf.used = entry.rect.x;
+    page.reserved_area -= area;
+  }
+}
+
+auto ShelfPacker::compact(std::uint32_t page) -> std::vector<Move> {
+  std::vector<Move> moves;
+  for (Handle handle{0}; handle < entries_.size(); ++handle) {
+    const auto& entry{entries_[handle]};
+    if (entry.live and entry.rect.page == page) {
+      moves.push_back({handle, entry.rect, entry.rect});
+    }
+  }
+  std::ranges::sort(moves, [](const Move& a, const Move& b) {
+    return a.from.height != b.from.height ? a.from.height > b.from.height
+                                          : a.from.width > b.from.width;
+  });
+
+  const auto old_page{pages_[page]};
+  auto& repacked{pages_[page]};
+  repacked = Page{};
+  std::vector<Entry> placed;
+  placed.reserve(moves.size());
+  for (const auto& move : moves) {
+    auto entry{place(page, move.from.width, move.from.height)};
+    if (not entry) {
+      repacked = old_page;
+      return {};
+    }
+    placed.push_back(*entry);
+  }
+  for (std::size_t i{0}; i < moves.size(); ++i) {
+    moves[i].to = placed[i].rect;
+    entries_[moves[i].handle] = placed[i];
+  }
+  return moves;
+}
+
+auto ShelfPacker::most_fragmented_page() const noexcept
+    -> std::optional<std::uint32_t> {
+  std::optional<std::uint32_t> worst;
+  std::uint64_t worst_waste{0};
+  for (std::uint32_t page{0}; page < pages_.size(); ++page) {
+    const auto waste{pages_[page].reserved_area - pages_[page].live_area};
+    if (waste > worst_waste) {
+      worst = page;
+      worst_waste = waste;
+    }
+  }
+  return worst;
+}
+
+auto ShelfPacker::place(std::uint32_t page, std::uint32_t width,
+                        std::uint32_t height) -> std::optional<Entry> {
+  auto& target{pages_[page]};
+  const auto wanted{std::min(shelf_height(height), page_size_)};
+
+  // Best fit: the shortest shelf tall enough, within a quarter of waste.
+  std::optional<std::uint32_t> best;
+  for (std::uint32_t i{0}; i < target.shelves.size(); ++i) {
+    const auto& shelf{target.shelves[i]};
+    if (shelf.height >= wanted and shelf.height - wanted <= shelf.height / 4 and
+        page_size_ - shelf.used >= width and
+        (not best or shelf.height < target.shelves[*best].height)) {
+      best = i;
+    }
+  }
+  if (not best) {
+    if (page_size_ - target.bottom < wanted) {
+      return std::nullopt;
+    }
+    best = static_cast<std::uint32_t>(target.shelves.size());
+    target.shelves.push_back({target.bottom, wanted, 0});
+    target.bottom += wanted;
+  }
+
+  auto& shelf{target.shelves[*best]};
+  const Entry entry{{page, shelf.used, shelf.y, width, height}, *best, true};
+  shelf.used += width;
+  const auto area{std::uint64_t{width} * height};
+  target.reserved_area += area;
+  target.live_area += area;
+  ++target.live_count;
+  return entry;
+}
+
+auto ShelfPacker::store(const Entry& entry) -> Handle {
+  if (free_handles_.empty()) {
+    entries_.push_back(entry);
+    return static_cast<Handle>(entries_.size() - 1);
+  }
+  const auto handle{free_handles_.back()};
+  free_handles_.pop_back();
+  entries_[handle] = entry;
+  return handle;
+}
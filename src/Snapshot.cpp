@@ -0,0 +1,294 @@
+#include "csc/Snapshot.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+#include "csc/ContentHash.hpp"
+#include "csc/ImageAlbum.hpp"
+#include "csc/Tags.hpp"
+#include "csc/Trace.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace csc;            // NOLINT
+using namespace csc::snapshot;  // NOLINT
+
+namespace {
+
+/// "CSCSNAP1" read as a little-endian word; a big-endian reader sees another.
+constexpr std::uint64_t Magic{0x31'50'41'4E'53'43'53'43ULL};
+
+/// Sections start on cache lines, and so on any element's alignment.
+constexpr std::size_t Alignment{64};
+
+struct Header {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t sections;
+  /// Of the whole file, so truncation is caught before anything is read.
+  std::uint64_t size;
+  std::uint64_t fingerprint;
+  /// XXH64 of the section table, then of the sections.
+  std::uint64_t table_checksum;
+  std::uint64_t data_checksum;
+};
+
+constexpr auto align_up(std::size_t offset, std::size_t alignment) noexcept
+    -> std::size_t {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+/// \brief Where the sections begin, after the header and `sections` entries.
+constexpr auto data_offset(std::size_t sections) noexcept -> std::size_t {
+  return align_up(sizeof(Header) + (sections * sizeof(Entry)), Alignment);
+}
+
+auto checksum(const std::byte* data, std::size_t size) noexcept
+    -> std::uint64_t {
+  return content::hash_bytes(
+      {reinterpret_cast<const unsigned char*>(data), size});  // NOLINT
+}
+
+auto read_header(const std::byte* data) noexcept -> Header {
+  Header header{};
+  std::memcpy(&header, data, sizeof header);
+  return header;
+}
+
+auto is_valid(const std::byte* data, std::size_t size) noexcept -> bool {
+  if (size < sizeof(Header)) {
+    return false;
+  }
+  const auto header{read_header(data)};
+  if (header.magic != Magic or header.version != FormatVersion or
+      header.size != size or
+      header.sections > (size - sizeof(Header)) / sizeof(Entry)) {
+    return false;
+  }
+  const auto base{data_offset(header.sections)};
+  if (base > size or
+      checksum(data + sizeof(Header), base - sizeof(Header)) !=
+          header.table_checksum or
+      checksum(data + base, size - base) != header.data_checksum) {
+    return false;
+  }
+  for (std::size_t i{0}; i < header.sections; ++i) {
+    Entry entry{};
+    std::memcpy(&entry, data + sizeof(Header) + (i * sizeof(Entry)),
+                sizeof entry);
+    if (entry.offset < base or entry.offset > size or
+        entry.size > size - entry.offset) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \brief Folds `value` into `hash`. Order matters, as slots do.
+constexpr auto combine(std::uint64_t hash, std::uint64_t value) noexcept
+    -> std::uint64_t {
+  return (std::rotl(hash, 27) ^ (value * 0x9E3779B185EBCA87ULL)) *
+         0xC2B2AE3D27D4EB4FULL;
+}
+
+auto hash_text(std::string_view text) noexcept -> std::uint64_t {
+  return content::hash_bytes(
+      {reinterpret_cast<const unsigned char*>(text.data()),  // NOLINT
+       text.size()});
+}
+
+}  // namespace
+
+auto snapshot::Writer::add_bytes(Section section, std::size_t element_size,
+                                 std::size_t alignment,
+                                 std::span<const std::byte> bytes) -> void {
+  data_.resize(align_up(data_.size(), std::max(alignment, Alignment)), '\0');
+  entries_.push_back({.section = section,
+                      .element_size = static_cast<std::uint32_t>(element_size),
+                      .offset = data_.size(),
+                      .size = bytes.size()});
+  data_.append(reinterpret_cast<const char*>(bytes.data()),  // NOLINT
+               bytes.size());
+}
+
+auto snapshot::Writer::write(const std::filesystem::path& path,
+                             std::uint64_t fingerprint) const -> void {
+  CSC_TRACE_SCOPE("snapshot::Writer::write");
+  const auto base{data_offset(entries_.size())};
+  std::string table(base - sizeof(Header), '\0');
+  for (std::size_t i{0}; i < entries_.size(); ++i) {
+    auto entry{entries_[i]};
+    entry.offset += base;
+    std::memcpy(table.data() + (i * sizeof(Entry)), &entry, sizeof entry);
+  }
+
+  const auto as_bytes = [](const std::string& text) {
+    return reinterpret_cast<const std::byte*>(text.data());  // NOLINT
+  };
+  const Header header{
+      .magic = Magic,
+      .version = FormatVersion,
+      .sections = static_cast<std::uint32_t>(entries_.size()),
+      .size = base + data_.size(),
+      .fingerprint = fingerprint,
+      .table_checksum = checksum(as_bytes(table), table.size()),
+      .data_checksum = checksum(as_bytes(data_), data_.size())};
+
+  auto temporary{path};
+  temporary += ".tmp";
+  {
+    std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(&header),  // NOLINT
+               sizeof header);
+    file.write(table.data(), static_cast<std::streamsize>(table.size()));
+    file.write(data_.data(), static_cast<std::streamsize>(data_.size()));
+    if (not file.flush()) {
+      throw std::runtime_error{"Could not write snapshot to " +
+                               path.string()};
+    }
+  }
+  std::filesystem::rename(temporary, path);
+}
+
+auto snapshot::Snapshot::open(const std::filesystem::path& path)
+    -> std::optional<Snapshot> {
+  CSC_TRACE_SCOPE("snapshot::Snapshot::open");
+#if defined(_WIN32)
+  const auto file{CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    return std::nullopt;
+  }
+  LARGE_INTEGER file_size{};
+  const auto mapping{
+      GetFileSizeEx(file, &file_size) and file_size.QuadPart > 0
+          ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+          : nullptr};
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return std::nullopt;
+  }
+  const auto* view{MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)};
+  CloseHandle(mapping);
+  if (view == nullptr) {
+    return std::nullopt;
+  }
+  const auto size{static_cast<std::size_t>(file_size.QuadPart)};
+#else
+  const auto file{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (file < 0) {
+    return std::nullopt;
+  }
+  struct stat info{};
+  if (::fstat(file, &info) != 0 or info.st_size <= 0) {
+    ::close(file);
+    return std::nullopt;
+  }
+  const auto size{static_cast<std::size_t>(info.st_size)};
+  auto* view{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0)};
+  ::close(file);
+  if (view == MAP_FAILED) {
+    return std::nullopt;
+  }
+#endif
+
+  Snapshot snapshot{static_cast<const std::byte*>(view), size};
+  if (not is_valid(snapshot.data_, snapshot.size_)) {
+    return std::nullopt;
+  }
+  return snapshot;
+}
+
+snapshot::Snapshot::~Snapshot() {
+  if (data_ == nullptr) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+#else
+  ::munmap(const_cast<std::byte*>(data_), size_);  // NOLINT
+#endif
+}
+
+auto snapshot::Snapshot::fingerprint() const noexcept -> std::uint64_t {
+  return read_header(data_).fingerprint;
+}
+
+auto snapshot::Snapshot::find(Section section, std::size_t element_size,
+                              std::size_t alignment) const
+    -> std::span<const std::byte> {
+  const auto header{read_header(data_)};
+  for (std::size_t i{0}; i < header.sections; ++i) {
+    Entry entry{};
+    std::memcpy(&entry, data_ + sizeof(Header) + (i * sizeof(Entry)),
+                sizeof entry);
+    if (entry.section != section) {
+      continue;
+    }
+    if (entry.element_size != element_size or
+        entry.offset % alignment != 0 or entry.size % element_size != 0) {
+      break;
+    }
+    return {data_ + entry.offset, entry.size};
+  }
+  throw std::runtime_error{
+      std::format("Snapshot section {} is missing or laid out differently",
+                  static_cast<std::uint32_t>(section))};
+}
+
+auto snapshot::fingerprint(const ImageAlbum& album) -> std::uint64_t {
+  CSC_TRACE_SCOPE("snapshot::fingerprint");
+  // Tag ids follow the order names were first interned in, so tags are
+  // hashed by name, and summed as each record keeps them sorted by id.
+  const auto& names{tags::dictionary()};
+  std::vector<std::uint64_t> tag_hashes;
+  const auto tag_hash = [&](tags::TagId tag) {
+    if (tag >= tag_hashes.size()) {
+      tag_hashes.resize(std::max<std::size_t>(names.size(), tag + 1), 0);
+    }
+    if (tag_hashes[tag] == 0) {
+      tag_hashes[tag] = hash_text(names.name(tag)) | 1U;
+    }
+    return tag_hashes[tag];
+  };
+
+  std::uint64_t hash{album.size()};
+  for (const auto& image : album) {
+    const auto& taken{image.get_date_taken()};
+    const auto days{
+        std::chrono::sys_days{taken.get_date()}.time_since_epoch().count()};
+    hash = combine(hash, hash_text(image.get_title()));
+    hash = combine(hash, image.get_genre().index());
+    hash = combine(hash, static_cast<std::uint64_t>(days));
+    hash = combine(hash, taken.get_time().count());
+
+    std::uint64_t tags{0};
+    for (const auto tag : image.get_tags()) {
+      tags += tag_hash(tag);
+    }
+    hash = combine(hash, tags);
+
+    const auto perceptual{image.get_perceptual_hash()};
+    hash = combine(hash, perceptual.has_value());
+    hash = combine(hash, perceptual.value_or(0));
+    const auto& signature{image.get_colour_signature()};
+    hash = combine(hash, signature ? content::hash_bytes(*signature) : 0);
+  }
+  return hash;
+}
@@ -0,0 +1,4 @@
+// The one translation unit that compiles stb_image, shared by the library's
+// decoders and the GUI's texture loading.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
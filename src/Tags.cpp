@@ -0,0 +1,648 @@
+#include "csc/Tags.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+
+#include "csc/ImageRecord.hpp"
+
+using namespace csc;        // NOLINT
+using namespace csc::tags;  // NOLINT
+
+namespace {
+
+constexpr std::string_view Separators{" \t\r\n\v\f;"};
+
+auto fold(std::string_view name) -> std::string {
+  std::string folded{name};
+  for (auto& c : folded) {
+    if (c >= 'A' and c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+  }
+  return folded;
+}
+
+/// \brief Calls `visit(piece)` for every non-empty piece of `text` between
+/// any of `separators`.
+template <typename Visit>
+auto split(std::string_view text, std::string_view separators,
+           Visit&& visit) -> void {
+  std::size_t at{0};
+  while (at < text.size()) {
+    const auto end{std::min(text.find_first_of(separators, at), text.size())};
+    if (end != at) {
+      visit(text.substr(at, end - at));
+    }
+    at = end + 1;
+  }
+}
+
+auto popcount(std::span<const std::uint64_t> words) noexcept
+    -> std::uint32_t {
+  std::uint32_t count{0};
+  for (const auto word : words) {
+    count += static_cast<std::uint32_t>(std::popcount(word));
+  }
+  return count;
+}
+
+constexpr auto has_bit(std::span<const std::uint64_t> words,
+                       std::uint16_t low) noexcept -> bool {
+  return ((words[low >> 6U] >> (low & 63U)) & 1U) != 0;
+}
+
+/// \brief A bitmap group as snapshots store it. `offset` is into the words
+/// when `count` is above `Bitmap::ArrayLimit`, and into the values otherwise.
+struct FlatGroup {
+  std::uint32_t key;
+  std::uint32_t count;
+  std::uint64_t offset;
+};
+
+auto malformed() -> std::runtime_error {
+  return std::runtime_error{"Snapshot tag index is malformed"};
+}
+
+}  // namespace
+
+auto tags::valid_name(std::string_view name) noexcept -> bool {
+  return not name.empty() and name.front() != '-' and
+         std::ranges::none_of(name, [](char c) {
+           return static_cast<unsigned char>(c) <= ' ' or
+                  std::string_view{"\"\\,;|"}.contains(c);
+         });
+}
+
+tags::Dictionary::Dictionary() {
+  for (std::size_t i{0}; i < ImageRecord::Genre::Count; ++i) {
+    intern(ImageRecord::Genre::from_index(i).name());
+  }
+}
+
+auto tags::Dictionary::intern(std::string_view name) -> TagId {
+  if (not valid_name(name)) {
+    throw std::invalid_argument{std::format("Invalid tag name '{}'", name)};
+  }
+  auto key{fold(name)};
+  {
+    const std::shared_lock lock{mutex_};
+    if (const auto found = ids_.find(key); found != ids_.end()) {
+      return found->second;
+    }
+  }
+  const std::unique_lock lock{mutex_};
+  const auto [at, added] =
+      ids_.try_emplace(std::move(key), static_cast<TagId>(names_.size()));
+  if (added) {
+    names_.emplace_back(name);
+  }
+  return at->second;
+}
+
+auto tags::Dictionary::find(std::string_view name) const
+    -> std::optional<TagId> {
+  const auto key{fold(name)};
+  const std::shared_lock lock{mutex_};
+  if (const auto found = ids_.find(key); found != ids_.end()) {
+    return found->second;
+  }
+  return std::nullopt;
+}
+
+auto tags::Dictionary::name(TagId id) const -> std::string_view {
+  const std::shared_lock lock{mutex_};
+  return names_.at(id);
+}
+
+auto tags::Dictionary::size() const -> std::size_t {
+  const std::shared_lock lock{mutex_};
+  return names_.size();
+}
+
+auto tags::dictionary() -> Dictionary& {
+  static Dictionary names;
+  return names;
+}
+
+tags::TagSet::TagSet(std::initializer_list<TagId> ids) : ids_{ids} {
+  std::ranges::sort(ids_);
+  const auto [first, last] = std::ranges::unique(ids_);
+  ids_.erase(first, last);
+}
+
+auto tags::TagSet::insert(TagId id) -> bool {
+  const auto at{std::ranges::lower_bound(ids_, id)};
+  if (at != ids_.end() and *at == id) {
+    return false;
+  }
+  ids_.insert(at, id);
+  return true;
+}
+
+auto tags::TagSet::erase(TagId id) noexcept -> bool {
+  const auto at{std::ranges::lower_bound(ids_, id)};
+  if (at == ids_.end() or *at != id) {
+    return false;
+  }
+  ids_.erase(at);
+  return true;
+}
+
+auto tags::TagSet::contains(TagId id) const noexcept -> bool {
+  return std::ranges::binary_search(ids_, id);
+}
+
+auto tags::parse_list(std::string_view text, Dictionary& names) -> TagSet {
+  TagSet tags;
+  split(text, Separators,
+        [&](std::string_view name) { tags.insert(names.intern(name)); });
+  return tags;
+}
+
+auto tags::format_list(const TagSet& tags, const Dictionary& names)
+    -> std::string {
+  std::string out;
+  append_list(out, tags, names);
+  return out;
+}
+
+auto tags::append_list(std::string& out, const TagSet& tags,
+                       const Dictionary& names) -> void {
+  const char* separator{""};
+  for (const auto id : tags) {
+    out += separator;
+    out += names.name(id);
+    separator = ";";
+  }
+}
+
+auto tags::parse_query(std::string_view text, const Dictionary& names)
+    -> Query {
+  Query query;
+  split(text, " \t\r\n\v\f", [&](std::string_view term) {
+    const bool exclude{term.front() == '-'};
+    if (exclude) {
+      term.remove_prefix(1);
+    } else {
+      query.groups.emplace_back();
+    }
+    split(term, "|", [&](std::string_view name) {
+      if (const auto id = names.find(name)) {
+        (exclude ? query.excluded : query.groups.back()).push_back(*id);
+      }
+    });
+  });
+  return query;
+}
+
+auto tags::Bitmap::find(std::uint16_t key) noexcept
+    -> std::vector<Group>::iterator {
+  return std::ranges::lower_bound(groups_, key, {}, &Group::key);
+}
+
+auto tags::Bitmap::find(std::uint16_t key) const noexcept
+    -> std::vector<Group>::const_iterator {
+  return std::ranges::lower_bound(groups_, key, {}, &Group::key);
+}
+
+auto tags::Bitmap::add(std::uint32_t value) -> bool {
+  const auto key{static_cast<std::uint16_t>(value >> 16U)};
+  const auto low{static_cast<std::uint16_t>(value)};
+  auto group{find(key)};
+  if (group == groups_.end() or group->key != key) {
+    group = groups_.insert(group, Group{.key = key});
+  }
+
+  if (not group->words.empty()) {
+    if (has_bit(group->words.view(), low)) {
+      return false;
+    }
+    group->words.owned()[low >> 6U] |= std::uint64_t{1} << (low & 63U);
+  } else {
+    const auto at{static_cast<std::size_t>(
+        std::ranges::lower_bound(group->values, low) - group->values.begin())};
+    if (at != group->values.size() and group->values[at] == low) {
+      return false;
+    }
+    auto& values{group->values.owned()};
+    values.insert(values.begin() + static_cast<std::ptrdiff_t>(at), low);
+  }
+  ++group->count;
+  settle(*group);
+  return true;
+}
+
+auto tags::Bitmap::remove(std::uint32_t value) -> bool {
+  const auto key{static_cast<std::uint16_t>(value >> 16U)};
+  const auto low{static_cast<std::uint16_t>(value)};
+  const auto group{find(key)};
+  if (group == groups_.end() or group->key != key) {
+    return false;
+  }
+
+  if (not group->words.empty()) {
+    if (not has_bit(group->words.view(), low)) {
+      return false;
+    }
+    group->words.owned()[low >> 6U] &= ~(std::uint64_t{1} << (low & 63U));
+  } else {
+    const auto at{static_cast<std::size_t>(
+        std::ranges::lower_bound(group->values, low) - group->values.begin())};
+    if (at == group->values.size() or group->values[at] != low) {
+      return false;
+    }
+    auto& values{group->values.owned()};
+    values.erase(values.begin() + static_cast<std::ptrdiff_t>(at));
+  }
+  if (--group->count == 0) {
+    groups_.erase(group);
+  } else {
+    settle(*group);
+  }
+  return true;
+}
+
+auto tags::Bitmap::contains(std::uint32_t value) const noexcept -> bool {
+  const auto key{static_cast<std::uint16_t>(value >> 16U)};
+  const auto low{static_cast<std::uint16_t>(value)};
+  const auto group{find(key)};
+  if (group == groups_.end() or group->key != key) {
+    return false;
+  }
+  if (not group->words.empty()) {
+    return has_bit(group->words.view(), low);
+  }
+  return std::ranges::binary_search(group->values, low);
+}
+
+auto tags::Bitmap::cardinality() const noexcept -> std::size_t {
+  std::size_t total{0};
+  for (const auto& group : groups_) {
+    total += group.count;
+  }
+  return total;
+}
+
+auto tags::Bitmap::bytes() const noexcept -> std::size_t {
+  auto total{sizeof(*this) + (groups_.capacity() * sizeof(Group))};
+  for (const auto& group : groups_) {
+    total += (group.values.capacity() * sizeof(std::uint16_t)) +
+             (group.words.capacity() * sizeof(std::uint64_t));
+  }
+  return total;
+}
+
+auto tags::Bitmap::to_words(Group& group) -> void {
+  std::vector<std::uint64_t> words(Words, 0);
+  for (const auto low : group.values) {
+    words[low >> 6U] |= std::uint64_t{1} << (low & 63U);
+  }
+  group.words.assign(std::move(words));
+  group.values = {};
+}
+
+auto tags::Bitmap::to_values(Group& group) -> void {
+  std::vector<std::uint16_t> values;
+  values.reserve(group.count);
+  for (std::uint32_t word{0}; word < Words; ++word) {
+    for (auto bits{group.words[word]}; bits != 0; bits &= bits - 1) {
+      values.push_back(static_cast<std::uint16_t>(
+          (word << 6U) | static_cast<std::uint32_t>(std::countr_zero(bits))));
+    }
+  }
+  group.values.assign(std::move(values));
+  group.words = {};
+}
+
+auto tags::Bitmap::settle(Group& group) -> void {
+  if (group.words.empty() and group.count > ArrayLimit) {
+    to_words(group);
+  } else if (not group.words.empty() and group.count <= ArrayLimit) {
+    to_values(group);
+  }
+}
+
+auto tags::Bitmap::intersect(Group& group, const Group& other) -> void {
+  if (group.words.empty()) {
+    if (other.words.empty()) {
+      std::vector<std::uint16_t> both;
+      both.reserve(std::min(group.values.size(), other.values.size()));
+      std::ranges::set_intersection(group.values, other.values,
+                                    std::back_inserter(both));
+      group.values.assign(std::move(both));
+    } else {
+      std::erase_if(group.values.owned(), [&other](std::uint16_t low) {
+        return not has_bit(other.words.view(), low);
+      });
+    }
+    group.count = static_cast<std::uint32_t>(group.values.size());
+    return;
+  }
+
+  if (other.words.empty()) {
+    std::vector<std::uint16_t> both;
+    both.reserve(other.values.size());
+    std::ranges::copy_if(other.values, std::back_inserter(both),
+                         [&group](std::uint16_t low) {
+                           return has_bit(group.words.view(), low);
+                         });
+    group.words = {};
+    group.values.assign(std::move(both));
+    group.count = static_cast<std::uint32_t>(group.values.size());
+    return;
+  }
+  auto& words{group.words.owned()};
+  for (std::uint32_t word{0}; word < Words; ++word) {
+    words[word] &= other.words[word];
+  }
+  group.count = popcount(group.words.view());
+  settle(group);
+}
+
+auto tags::Bitmap::unite(Group& group, const Group& other) -> void {
+  if (group.words.empty() and other.words.empty()) {
+    std::vector<std::uint16_t> either;
+    either.reserve(group.values.size() + other.values.size());
+    std::ranges::set_union(group.values, other.values,
+                           std::back_inserter(either));
+    group.values.assign(std::move(either));
+    group.count = static_cast<std::uint32_t>(group.values.size());
+    settle(group);
+    return;
+  }
+
+  if (group.words.empty()) {
+    to_words(group);
+  }
+  auto& words{group.words.owned()};
+  if (other.words.empty()) {
+    for (const auto low : other.values) {
+      words[low >> 6U] |= std::uint64_t{1} << (low & 63U);
+    }
+  } else {
+    for (std::uint32_t word{0}; word < Words; ++word) {
+      words[word] |= other.words[word];
+    }
+  }
+  group.count = popcount(group.words.view());
+}
+
+auto tags::Bitmap::subtract(Group& group, const Group& other) -> void {
+  if (group.words.empty()) {
+    if (other.words.empty()) {
+      std::vector<std::uint16_t> rest;
+      rest.reserve(group.values.size());
+      std::ranges::set_difference(group.values, other.values,
+                                  std::back_inserter(rest));
+      group.values.assign(std::move(rest));
+    } else {
+      std::erase_if(group.values.owned(), [&other](std::uint16_t low) {
+        return has_bit(other.words.view(), low);
+      });
+    }
+    group.count = static_cast<std::uint32_t>(group.values.size());
+    return;
+  }
+
+  auto& words{group.words.owned()};
+  if (other.words.empty()) {
+    for (const auto low : other.values) {
+      words[low >> 6U] &= ~(std::uint64_t{1} << (low & 63U));
+    }
+  } else {
+    for (std::uint32_t word{0}; word < Words; ++word) {
+      words[word] &= ~other.words[word];
+    }
+  }
+  group.count = popcount(group.words.view());
+  settle(group);
+}
+
+auto tags::Bitmap::operator&=(const Bitmap& other) -> Bitmap& {
+  std::vector<Group> kept;
+  auto theirs{other.groups_.begin()};
+  for (auto& group : groups_) {
+    while (theirs != other.groups_.end() and theirs->key < group.key) {
+      ++theirs;
+    }
+    if (theirs == other.groups_.end()) {
+      break;
+    }
+    if (theirs->key == group.key) {
+      intersect(group, *theirs);
+      if (group.count != 0) {
+        kept.push_back(std::move(group));
+      }
+    }
+  }
+  groups_ = std::move(kept);
+  return *this;
+}
+
+auto tags::Bitmap::operator|=(const Bitmap& other) -> Bitmap& {
+  std::vector<Group> merged;
+  merged.reserve(groups_.size() + other.groups_.size());
+  auto ours{groups_.begin()};
+  auto theirs{other.groups_.begin()};
+  while (ours != groups_.end() or theirs != other.groups_.end()) {
+    if (theirs == other.groups_.end() or
+        (ours != groups_.end() and ours->key < theirs->key)) {
+      merged.push_back(std::move(*ours++));
+    } else if (ours == groups_.end() or theirs->key < ours->key) {
+      merged.push_back(*theirs++);
+    } else {
+      unite(*ours, *theirs++);
+      merged.push_back(std::move(*ours++));
+    }
+  }
+  groups_ = std::move(merged);
+  return *this;
+}
+
+auto tags::Bitmap::operator-=(const Bitmap& other) -> Bitmap& {
+  auto theirs{other.groups_.begin()};
+  for (auto& group : groups_) {
+    while (theirs != other.groups_.end() and theirs->key < group.key) {
+      ++theirs;
+    }
+    if (theirs == other.groups_.end()) {
+      break;
+    }
+    if (theirs->key == group.key) {
+      subtract(group, *theirs);
+    }
+  }
+  std::erase_if(groups_, [](const Group& group) { return group.count == 0; });
+  return *this;
+}
+
+auto tags::TagIndex::insert(Id record) -> void { records_.add(record); }
+
+auto tags::TagIndex::erase(Id record) -> void { records_.remove(record); }
+
+auto tags::TagIndex::tag(Id record, TagId tag) -> void {
+  if (tag >= tagged_.size()) {
+    tagged_.resize(tag + 1);
+  }
+  tagged_[tag].add(record);
+}
+
+auto tags::TagIndex::untag(Id record, TagId tag) -> void {
+  if (tag < tagged_.size()) {
+    tagged_[tag].remove(record);
+  }
+}
+
+auto tags::TagIndex::clear() noexcept -> void {
+  tagged_.clear();
+  records_.clear();
+}
+
+auto tags::TagIndex::tagged(TagId tag) const noexcept -> const Bitmap& {
+  static const Bitmap None;
+  return tag < tagged_.size() ? tagged_[tag] : None;
+}
+
+auto tags::TagIndex::any_of(const std::vector<TagId>& tags) const -> Bitmap {
+  Bitmap either;
+  for (const auto tag : tags) {
+    either |= tagged(tag);
+  }
+  return either;
+}
+
+auto tags::TagIndex::evaluate(const Query& query) const -> Bitmap {
+  Bitmap result;
+  if (query.groups.empty()) {
+    result = records_;
+  } else {
+    std::vector<Bitmap> groups;
+    groups.reserve(query.groups.size());
+    for (const auto& group : query.groups) {
+      groups.push_back(any_of(group));
+    }
+    std::ranges::sort(groups, {}, &Bitmap::cardinality);
+    result = std::move(groups.front());
+    for (auto group{groups.begin() + 1};
+         group != groups.end() and not result.empty(); ++group) {
+      result &= *group;
+    }
+  }
+  for (const auto tag : query.excluded) {
+    if (result.empty()) {
+      break;
+    }
+    result -= tagged(tag);
+  }
+  return result;
+}
+
+auto tags::TagIndex::bytes() const noexcept -> std::size_t {
+  auto total{sizeof(*this) + records_.bytes() - sizeof(Bitmap) +
+             ((tagged_.capacity() - tagged_.size()) * sizeof(Bitmap))};
+  for (const auto& bitmap : tagged_) {
+    total += bitmap.bytes();
+  }
+  return total;
+}
+
+auto tags::TagIndex::save(snapshot::Writer& writer) const -> void {
+  std::string names;
+  std::vector<std::uint32_t> name_ends;
+  std::vector<std::uint32_t> bitmap_ends;
+  std::vector<FlatGroup> groups;
+  std::vector<std::uint16_t> values;
+  std::vector<std::uint64_t> words;
+  const auto flatten = [&](const Bitmap& bitmap) {
+    for (const auto& group : bitmap.groups_) {
+      const auto dense{not group.words.empty()};
+      groups.push_back({.key = group.key,
+                        .count = group.count,
+                        .offset = dense ? words.size() : values.size()});
+      if (dense) {
+        words.insert(words.end(), group.words.begin(), group.words.end());
+      } else {
+        values.insert(values.end(), group.values.begin(), group.values.end());
+      }
+    }
+    bitmap_ends.push_back(static_cast<std::uint32_t>(groups.size()));
+  };
+
+  for (TagId tag{0}; tag < tagged_.size(); ++tag) {
+    names += dictionary().name(tag);
+    name_ends.push_back(static_cast<std::uint32_t>(names.size()));
+    flatten(tagged_[tag]);
+  }
+  flatten(records_);
+
+  using snapshot::Section;
+  writer.add(Section::TagNames, std::span<const char>{names});
+  writer.add(Section::TagNameEnds, std::span<const std::uint32_t>{name_ends});
+  writer.add(Section::TagBitmapEnds,
+             std::span<const std::uint32_t>{bitmap_ends});
+  writer.add(Section::TagGroups, std::span<const FlatGroup>{groups});
+  writer.add(Section::TagValues, std::span<const std::uint16_t>{values});
+  writer.add(Section::TagWords, std::span<const std::uint64_t>{words});
+}
+
+auto tags::TagIndex::load(const snapshot::Snapshot& snapshot) -> void {
+  using snapshot::Section;
+  const auto names{snapshot.section<char>(Section::TagNames)};
+  const auto name_ends{snapshot.section<std::uint32_t>(Section::TagNameEnds)};
+  const auto bitmap_ends{
+      snapshot.section<std::uint32_t>(Section::TagBitmapEnds)};
+  const auto groups{snapshot.section<FlatGroup>(Section::TagGroups)};
+  const auto values{snapshot.section<std::uint16_t>(Section::TagValues)};
+  const auto words{snapshot.section<std::uint64_t>(Section::TagWords)};
+  if (bitmap_ends.size() != name_ends.size() + 1) {
+    throw malformed();
+  }
+
+  const auto unflatten = [&](std::size_t i, Bitmap& bitmap) {
+    const std::size_t first{i == 0 ? 0 : bitmap_ends[i - 1]};
+    const std::size_t last{bitmap_ends[i]};
+    if (first > last or last > groups.size()) {
+      throw malformed();
+    }
+    bitmap.groups_.clear();
+    bitmap.groups_.reserve(last - first);
+    for (const auto& flat : groups.subspan(first, last - first)) {
+      auto& group{bitmap.groups_.emplace_back(
+          Bitmap::Group{.key = static_cast<std::uint16_t>(flat.key),
+                        .count = flat.count})};
+      const auto dense{flat.count > Bitmap::ArrayLimit};
+      const auto length{dense ? std::size_t{Bitmap::Words}
+                              : std::size_t{flat.count}};
+      const auto stored{dense ? words.size() : values.size()};
+      if (flat.offset > stored or stored - flat.offset < length) {
+        throw malformed();
+      }
+      if (dense) {
+        group.words.borrow(words.subspan(flat.offset, length));
+      } else {
+        group.values.borrow(values.subspan(flat.offset, length));
+      }
+    }
+  };
+
+  clear();
+  std::size_t begin{0};
+  for (std::size_t i{0}; i < name_ends.size(); ++i) {
+    if (name_ends[i] < begin or name_ends[i] > names.size()) {
+      throw malformed();
+    }
+    const auto tag{dictionary().intern(
+        {names.data() + begin, name_ends[i] - begin})};
+    begin = name_ends[i];
+    if (tag >= tagged_.size()) {
+      tagged_.resize(tag + 1);
+    }
+    unflatten(i, tagged_[tag]);
+  }
+  unflatten(name_ends.size(), records_);
+}
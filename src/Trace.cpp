@@ -0,0 +1,202 @@
+#include "csc/Trace.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "csc/Exporter.hpp"
+
+using namespace csc;  // NOLINT
+
+namespace {
+
+struct Event {
+  const char* name;
+  std::uint64_t start;
+  std::uint64_t end;
+  std::uint32_t thread;
+};
+
+/// \brief One thread's events. Only its owner appends, so the lock is
+/// uncontended except while a trace is being written. A buffer outlives its
+/// thread, and is handed to the next new thread once the old one exits.
+struct Buffer {
+  std::mutex mutex;
+  std::vector<Event> events;
+  std::uint32_t thread{0};
+  bool retired{false};
+};
+
+class Registry {
+ public:
+  auto acquire() -> Buffer* {
+    const std::lock_guard lock{mutex_};
+    Buffer* buffer{nullptr};
+    for (const auto& existing : buffers_) {
+      if (existing->retired) {
+        buffer = existing.get();
+        break;
+      }
+    }
+    if (buffer == nullptr) {
+      buffer = buffers_.emplace_back(std::make_unique<Buffer>()).get();
+    }
+    buffer->retired = false;
+    buffer->thread = ++threads_;
+    return buffer;
+  }
+
+  auto retire(Buffer* buffer) -> void {
+    const std::lock_guard lock{mutex_};
+    buffer->retired = true;
+  }
+
+  template <typename Visit>
+  auto for_each(Visit&& visit) -> void {
+    const std::lock_guard lock{mutex_};
+    for (const auto& buffer : buffers_) {
+      const std::lock_guard buffer_lock{buffer->mutex};
+      visit(*buffer);
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+  std::uint32_t threads_{0};
+};
+
+auto registry() -> Registry& {
+  static Registry instance;
+  return instance;
+}
+
+/// \brief The calling thread's buffer, claimed on its first event.
+class ThreadBuffer {
+ public:
+  ThreadBuffer() : buffer_{registry().acquire()} {}
+  ThreadBuffer(const ThreadBuffer&) = delete;
+  auto operator=(const ThreadBuffer&) -> ThreadBuffer& = delete;
+  ~ThreadBuffer() { registry().retire(buffer_); }
+
+  auto get() const noexcept -> Buffer& { return *buffer_; }
+
+ private:
+  Buffer* buffer_;
+};
+
+const auto Epoch{std::chrono::steady_clock::now()};
+
+/// \brief Nanoseconds as the microseconds Chrome traces count in.
+auto append_micros(std::string& out, std::uint64_t nanos) -> void {
+  std::format_to(std::back_inserter(out), "{}.{:03}", nanos / 1000,
+                 nanos % 1000);
+}
+
+}  // namespace
+
+auto trace::detail::now() noexcept -> std::uint64_t {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - Epoch)
+          .count());
+}
+
+auto trace::detail::record(const char* name, std::uint64_t start,
+                           std::uint64_t end) noexcept -> void {
+  try {
+    thread_local const ThreadBuffer local;
+    auto& buffer{local.get()};
+    const std::lock_guard lock{buffer.mutex};
+    if (buffer.events.size() < MaxEventsPerThread) {
+      buffer.events.push_back({name, start, end, buffer.thread});
+    }
+  } catch (...) {
+    // Out of memory: lose the event rather than the operation it timed.
+  }
+}
+
+auto trace::start() -> void {
+  registry().for_each([](Buffer& buffer) { buffer.events.clear(); });
+  detail::recording.store(true, std::memory_order_relaxed);
+}
+
+auto trace::stop() noexcept -> void {
+  detail::recording.store(false, std::memory_order_relaxed);
+}
+
+auto trace::event_count() -> std::size_t {
+  std::size_t count{0};
+  registry().for_each(
+      [&count](const Buffer& buffer) { count += buffer.events.size(); });
+  return count;
+}
+
+auto trace::write_json(std::ostream& out) -> void {
+  std::string text{"{\"displayTimeUnit\":\"ms\",\"traceEvents\":["};
+  bool first{true};
+  registry().for_each([&](const Buffer& buffer) {
+    for (const auto& event : buffer.events) {
+      text += first ? "\n" : ",\n";
+      first = false;
+      text += "{\"name\":";
+      exporter::append_json_string(text, event.name);
+      text += ",\"cat\":\"csc\",\"ph\":\"X\",\"ts\":";
+      append_micros(text, event.start);
+      text += ",\"dur\":";
+      append_micros(text, event.end - event.start);
+      std::format_to(std::back_inserter(text), ",\"pid\":1,\"tid\":{}}}",
+                     event.thread);
+      if (text.size() >= exporter::Exporter::FlushThreshold) {
+        out << text;
+        text.clear();
+      }
+    }
+  });
+  text += "\n]}\n";
+  out << text;
+}
+
+auto trace::write_file(const std::filesystem::path& path) -> void {
+  std::ofstream file{path, std::ios::binary};
+  if (file) {
+    write_json(file);
+  }
+  if (not file) {
+    throw std::runtime_error{"Could not write trace to " + path.string()};
+  }
+}
+
+trace::Session::Session() {
+  const auto* const path{std::getenv("CSC_TRACE")};
+  if (path == nullptr or *path == '\0') {
+    return;
+  }
+  if constexpr (not Compiled) {
+    std::cerr << "CSC_TRACE is set, but this build has no trace points; "
+                 "configure with -DCSC_TRACING=ON\n";
+    return;
+  }
+  path_ = path;
+  start();
+}
+
+trace::Session::~Session() noexcept {
+  if (not path_) {
+    return;
+  }
+  stop();
+  try {
+    write_file(*path_);
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << '\n';
+  }
+}
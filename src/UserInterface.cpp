@@ -1,11 +1,22 @@
 #include "csc/UserInterface.hpp"
 
+#include <charconv>
 #include <chrono>
+#include <cstdint>
+#include <sstream>
 #include <stdexcept>
 
+#include "csc/AlbumCursor.hpp"
+#include "csc/Facets.hpp"
 #include "csc/ImageAlbum.hpp"
+#include "csc/ImageInfo.hpp"
 #include "csc/ImageRecord.hpp"
+#include "csc/Importer.hpp"
+#include "csc/Ingest.hpp"
+#include "csc/Metrics.hpp"
+#include "csc/PerceptualHash.hpp"
 #include "csc/RequiredImages.hpp"
+#include "csc/Tags.hpp"
 
 using namespace csc;  // NOLINT
 
@@ -30,16 +41,25 @@ static inline auto read_number_between(
 UserInterface::UserInterface() noexcept
     : manager_{required::manager_with_required_images()} {}
 
-auto UserInterface::show_images(ImageAlbum& images) const noexcept -> void {
+void UserInterface::vput(std::string_view fmt, std::format_args args) const {
+  put(std::vformat(fmt, args));
+}
+void UserInterface::vputln(std::string_view fmt, std::format_args args) const {
+  putln(std::vformat(fmt, args));
+}
+
+auto UserInterface::show_images(const ImageAlbum& images) const noexcept
+    -> void {
   enum class GetImage { Next, Previous, Exit };
   using MyExtractor =
       Extractor<OptionPack<{"Next image", GetImage::Next},
                            {"Previous image", GetImage::Previous},
                            {"Exit", GetImage::Exit}>>;
 
+  AlbumCursor cursor{images};
   const ImageRecord* image = nullptr;
   try {
-    image = &images.get_first_image();
+    image = &cursor.first();
   } catch (std::out_of_range& e) {
     println("No images.");
     wait_for_enter();
@@ -76,7 +96,7 @@ auto UserInterface::show_images(ImageAlbum& images) const noexcept -> void {
     switch (option) {
       case GetImage::Next: {
         try {
-          image = &images.get_next_image();
+          image = &cursor.next();
         } catch (std::out_of_range& e) {
           previous_info = Info::OutOfBoundsRight;
         }
@@ -84,7 +104,7 @@ auto UserInterface::show_images(ImageAlbum& images) const noexcept -> void {
       }
       case GetImage::Previous: {
         try {
-          image = &images.get_previous_image();
+          image = &cursor.previous();
         } catch (std::out_of_range& e) {
           previous_info = Info::OutOfBoundsLeft;
         }
@@ -117,8 +137,7 @@ auto UserInterface::display_image_with_id(const std::size_t id) const noexcept
 
 auto UserInterface::display_images_with_title(
     const std::string_view title) const noexcept -> void {
-  auto images = manager_.search_title(title);
-  show_images(images);
+  show_images(manager_.search_title(title));
 }
 
 auto UserInterface::add_image() -> void {
@@ -133,13 +152,87 @@ auto UserInterface::add_image() -> void {
   println("Enter the genre of the image.");
   auto genre{get_genre()};
 
+  println("Enter the tags of the image, separated by spaces.");
+  auto tag_set{get_tags()};
+
   println("Enter the date of the image.");
   auto date{get_date()};
 
   println("Enter the file path of the image.");
   auto file_path{get_file_path()};
 
-  manager_.add_image(ImageRecord{title, description, genre, date, file_path});
+  ImageRecord image{title, description, genre, date, file_path};
+  image.set_tags(std::move(tag_set));
+  ingest::inspect(image);
+  manager_.add_image(std::move(image));
+}
+
+auto UserInterface::update_image() -> void {
+  println("Enter the id of the image to update.");
+  auto id{read_number_between(*this, 1ULL, ImageRecord::last_id())};
+  if (not manager_.search_id(id)) {
+    println("There is no image with id {}.", id);
+    wait_for_enter();
+    return;
+  }
+
+  std::string buf;
+
+  println("Enter the new title of the image.");
+  auto title{read_input(buf)};
+
+  println("Enter the new description of the image.");
+  auto description{read_input(buf)};
+
+  println("Enter the new genre of the image.");
+  auto genre{get_genre()};
+
+  println("Enter the new tags of the image, separated by spaces.");
+  auto tag_set{get_tags()};
+
+  println("Enter the new date of the image.");
+  auto date{get_date()};
+
+  println("Enter the new file path of the image.");
+  auto file_path{get_file_path()};
+
+  manager_.update_image(id, [&](ImageRecord& image) {
+    image.set_title(std::move(title));
+    image.set_description(std::move(description));
+    image.set_genre(genre);
+    image.set_tags(std::move(tag_set));
+    image.set_date_taken(date);
+    image.set_thumbnail_path(std::move(file_path));
+    ingest::inspect(image);
+  });
+}
+
+auto UserInterface::remove_image() -> void {
+  println("Enter the id of the image to remove.");
+  auto id{read_number_between(*this, 1ULL, ImageRecord::last_id())};
+
+  if (manager_.remove_image(id)) {
+    println("Removed image {}.", id);
+  } else {
+    println("There is no image with id {}.", id);
+  }
+  wait_for_enter();
+}
+
+auto UserInterface::import_images() -> void {
+  println("Enter the path of a .csv or .jsonl file to import.");
+  auto path{get_file_path()};
+
+  try {
+    const auto report{importer::import_file(manager_, path)};
+    println("Imported {} images.", report.imported);
+    for (const auto& error : report.errors) {
+      println("Line {}: {}", error.line, error.message);
+    }
+  } catch (const std::exception& e) {
+    println("Import failed: {}", e.what());
+  }
+  wait_for_enter();
 }
 
 auto UserInterface::search_image() -> void {
@@ -149,18 +242,29 @@ auto UserInterface::search_image() -> void {
     Description,
     Genre,
     Date,
+    Size,
+    Orientation,
+    Similar,
+    Colour,
+    Tags,
   };
   using ExtractorType = Extractor<OptionPack<
       {"Id", SearchCriteria::Id}, {"Title", SearchCriteria::Title},
       {"Description", SearchCriteria::Description},
-      {"Genre", SearchCriteria::Genre}, {"Date", SearchCriteria::Date}>>;
+      {"Genre", SearchCriteria::Genre}, {"Date", SearchCriteria::Date},
+      {"Minimum size", SearchCriteria::Size},
+      {"Orientation", SearchCriteria::Orientation},
+      {"Looks like image id", SearchCriteria::Similar},
+      {"Colour like image id", SearchCriteria::Colour},
+      {"Tags", SearchCriteria::Tags}>>;
 
   auto result{ExtractorType::get(*this)};
 
+  // Results come from the cache and are browsed in place.
   switch (result) {
     case SearchCriteria::Id: {
       println("Enter the id of the image.");
-      auto id{read_number_between(*this, 1ULL, manager_.size())};
+      auto id{read_number_between(*this, 1ULL, ImageRecord::last_id())};
 
       const auto image = manager_.search_id(id);
       if (image) {
@@ -170,26 +274,28 @@ auto UserInterface::search_image() -> void {
       break;
     }
     case SearchCriteria::Title: {
-      println("Enter the title of the image.");
-      auto title{get_non_empty_string()};
+      println(
+          "Enter the title of the image, or the start of one followed by ? "
+          "for suggestions.");
+      auto title{get_title()};
 
-      auto images = manager_.search_title(title);
-      show_images(images);
+      const auto images{cached_search(query::Title{std::move(title)})};
+      show_images(*images);
       break;
     }
     case SearchCriteria::Description: {
       println("Enter the description of the image.");
       auto title{get_non_empty_string()};
 
-      auto images = manager_.search_description(title);
-      show_images(images);
+      const auto images{cached_search(query::Description{std::move(title)})};
+      show_images(*images);
       break;
     }
     case SearchCriteria::Genre: {
       println("Enter the genre of the image.");
       auto genre{get_genre()};
-      auto images = manager_.search_genre(genre);
-      show_images(images);
+      const auto images{cached_search(query::Genre{genre})};
+      show_images(*images);
       break;
     }
     case SearchCriteria::Date: {
@@ -199,16 +305,101 @@ auto UserInterface::search_image() -> void {
       println("Enter the end date of the image.");
       auto end{get_date()};
 
-      auto images = manager_.search_between_dates(start, end);
-      show_images(images);
+      const auto images{cached_search(query::Dates{start, end})};
+      show_images(*images);
+      break;
+    }
+    case SearchCriteria::Size: {
+      println("Enter the minimum width in pixels.");
+      const std::uint32_t width(read_number_between(*this, 0UZ, UINT32_MAX));
+
+      println("Enter the minimum height in pixels.");
+      const std::uint32_t height(read_number_between(*this, 0UZ, UINT32_MAX));
+
+      const auto images{cached_search(query::MinSize{width, height})};
+      show_images(*images);
+      break;
+    }
+    case SearchCriteria::Orientation: {
+      using OrientationExtractor = Extractor<OptionPack<
+          {"Landscape", ImageInfo::Orientation::Landscape},
+          {"Portrait", ImageInfo::Orientation::Portrait},
+          {"Square", ImageInfo::Orientation::Square}>>;
+      auto orientation{OrientationExtractor::get(*this)};
+      const auto images{cached_search(query::Orientation{orientation})};
+      show_images(*images);
+      break;
+    }
+    case SearchCriteria::Similar: {
+      println("Enter the id of the image to compare against.");
+      auto id{read_number_between(*this, 1ULL, ImageRecord::last_id())};
+
+      const auto image = manager_.search_id(id);
+      const auto hash{image ? (*image)->get_perceptual_hash() : std::nullopt};
+      if (not hash) {
+        println("There is no decoded image with id {}.", id);
+        wait_for_enter();
+        break;
+      }
+      const auto images{cached_search(query::Similar{*hash})};
+      show_images(*images);
+      break;
+    }
+    case SearchCriteria::Colour: {
+      println("Enter the id of the image to compare against.");
+      auto id{read_number_between(*this, 1ULL, ImageRecord::last_id())};
+
+      const auto image = manager_.search_id(id);
+      const auto signature{image ? (*image)->get_colour_signature()
+                                 : std::nullopt};
+      if (not signature) {
+        println("There is no decoded image with id {}.", id);
+        wait_for_enter();
+        break;
+      }
+
+      println("Enter how many images to find.");
+      auto k{read_number_between(*this, 1UZ, manager_.size())};
+
+      const auto images{cached_search(query::Colour{*signature, k})};
+      show_images(*images);
+      break;
+    }
+    case SearchCriteria::Tags: {
+      println(
+          "Enter tags: images need all of them, a|b needs either, -a "
+          "excludes. Genres are tags too.");
+      auto text{get_non_empty_string()};
+      const auto images{cached_search(query::Tags{tags::parse_query(text)})};
+      show_images(*images);
       break;
     }
   }
 }
 
 auto UserInterface::display_all_images() -> void {
-  auto images = manager_.get_all_images();
-  show_images(images);
+  show_images(manager_.get_all_images());
+}
+
+auto UserInterface::show_stats() -> void {
+  manager_.sample_metrics();
+  std::ostringstream text;
+  facet::write_text(text, manager_.facets(facet::Period::Year));
+  metrics::global().write_text(text);
+  put(text.str());
+
+  println("Enter a file to save these to (.prom for Prometheus), or nothing.");
+  std::string buf;
+  const auto& path{read_input(buf)};
+  if (not path.empty()) {
+    try {
+      metrics::global().write_file(path);
+      println("Saved to {}.", path);
+    } catch (const std::exception& e) {
+      println("{}", e.what());
+    }
+  }
+  wait_for_enter();
 }
 
 auto UserInterface::get_non_empty_string() const noexcept -> std::string {
@@ -222,6 +413,35 @@ auto UserInterface::get_non_empty_string() const noexcept -> std::string {
   }
 }
 
+auto UserInterface::get_title() const noexcept -> std::string {
+  auto input{get_non_empty_string()};
+  std::vector<suggest::Suggestion> suggestions;
+  while (true) {
+    std::size_t choice{0};
+    const auto* const end{input.data() + input.size()};
+    const auto [parsed, error] = std::from_chars(input.data(), end, choice);
+    if (error == std::errc{} and parsed == end and choice >= 1 and
+        choice <= suggestions.size()) {
+      return std::string{suggestions[choice - 1].text};
+    }
+    if (not input.ends_with('?')) {
+      return input;
+    }
+
+    input.pop_back();
+    suggestions = manager_.suggest_titles(input);
+    if (suggestions.empty()) {
+      println("No titles or words start with \"{}\".", input);
+    }
+    for (std::size_t i{0}; i < suggestions.size(); ++i) {
+      println("{}. {} ({} images)", i + 1, suggestions[i].text,
+              suggestions[i].count);
+    }
+    println("Enter a number to pick one, a title, or another start and ?.");
+    input = get_non_empty_string();
+  }
+}
+
 auto UserInterface::get_genre() const noexcept -> ImageRecord::Genre {
   using ExtractorType =
       Extractor<OptionPack<{"Astronomy", ImageRecord::Genre::Astronomy()},
@@ -238,6 +458,18 @@ auto UserInterface::get_genre() const noexcept -> ImageRecord::Genre {
   return result;
 }
 
+auto UserInterface::get_tags() const -> tags::TagSet {
+  std::string buf;
+  while (true) {
+    read_input(buf);
+    try {
+      return tags::parse_list(buf);
+    } catch (const std::invalid_argument& e) {
+      println("{}. Tags cannot contain \"\\,;| or start with -.", e.what());
+    }
+  }
+}
+
 auto UserInterface::get_year_month_day() const noexcept -> date::Date {
   println("Enter the year of the image.");
   std::size_t year{read_number_between(*this, 1900UZ, 2024UZ)};
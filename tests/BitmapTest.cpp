@@ -0,0 +1,150 @@
+// Intersection, union and difference of tag bitmaps must agree with a
+// std::set, both when a group stays a sorted array or a bitset and when the
+// result moves it across Bitmap::ArrayLimit in either direction.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/Tags.hpp"
+
+using csc::tags::Bitmap;
+using csc::test::expect;
+
+namespace {
+
+using Reference = std::set<std::uint32_t>;
+
+/// Group sizes either side of the switch between arrays and bitsets.
+constexpr std::array<std::size_t, 9> Counts{
+    0,
+    1,
+    Bitmap::ArrayLimit / 2,
+    Bitmap::ArrayLimit - 1,
+    Bitmap::ArrayLimit,
+    Bitmap::ArrayLimit + 1,
+    (Bitmap::ArrayLimit * 3) / 2,
+    Bitmap::ArrayLimit * 3,
+    40000};
+/// The high 16 bits of the values; group 1 is left empty so some groups are
+/// only on one side.
+constexpr std::array<std::uint32_t, 3> Keys{0, 2, 3};
+constexpr int Trials{100};
+
+struct Sample {
+  Bitmap bitmap;
+  Reference reference;
+};
+
+auto values(const Bitmap& bitmap) -> std::vector<std::uint32_t> {
+  std::vector<std::uint32_t> values;
+  bitmap.for_each([&values](std::uint32_t value) { values.push_back(value); });
+  return values;
+}
+
+/// \brief `bitmap` holds exactly `reference`, laid out as if built by `add`.
+auto check(const Bitmap& bitmap, const Reference& reference,
+           const char* what) -> void {
+  expect(std::ranges::equal(values(bitmap), reference), what);
+  expect(bitmap.cardinality() == reference.size(), what);
+  Bitmap rebuilt;
+  for (const auto value : reference) {
+    rebuilt.add(value);
+  }
+  expect(bitmap == rebuilt, what);
+}
+
+/// \brief A random group of a random size from `Counts` under each key.
+auto sample(std::mt19937& random) -> Sample {
+  Sample sample;
+  for (const auto key : Keys) {
+    const auto count{Counts[random() % Counts.size()]};
+    Reference group;
+    // Values from a narrower range overlap the other operand more often.
+    const auto span{random() % 2 == 0 ? std::uint32_t{65536}
+                                      : std::uint32_t{12000}};
+    while (group.size() < std::min<std::size_t>(count, span)) {
+      group.insert((key << 16U) | static_cast<std::uint32_t>(random() % span));
+    }
+    for (const auto value : group) {
+      sample.bitmap.add(value);
+      sample.reference.insert(value);
+    }
+  }
+  check(sample.bitmap, sample.reference, "add");
+  return sample;
+}
+
+auto check_operations() -> void {
+  std::mt19937 random{45};
+  for (int trial{0}; trial < Trials; ++trial) {
+    const auto a{sample(random)};
+    const auto b{sample(random)};
+
+    Reference both;
+    std::ranges::set_intersection(a.reference, b.reference,
+                                  std::inserter(both, both.end()));
+    check(a.bitmap & b.bitmap, both, "and");
+    Reference either;
+    std::ranges::set_union(a.reference, b.reference,
+                           std::inserter(either, either.end()));
+    check(a.bitmap | b.bitmap, either, "or");
+    Reference rest;
+    std::ranges::set_difference(a.reference, b.reference,
+                                std::inserter(rest, rest.end()));
+    check(a.bitmap - b.bitmap, rest, "andnot");
+  }
+}
+
+/// \brief A dense group shrunk by each operation to an array, and arrays grown
+/// by union to a dense group, at the exact limit.
+auto check_crossings() -> void {
+  const auto range = [](std::uint32_t first, std::uint32_t last) {
+    Sample sample;
+    for (auto value{first}; value <= last; ++value) {
+      sample.bitmap.add(value);
+      sample.reference.insert(value);
+    }
+    return sample;
+  };
+  const auto limit{static_cast<std::uint32_t>(Bitmap::ArrayLimit)};
+  // Bitsets of 2 * limit + 1 values, and the two halves of the first: an
+  // array of `limit` values and a bitset of `limit + 1`.
+  const auto first{range(0, 2 * limit)};
+  const auto second{range(limit + 1, 3 * limit)};
+  const auto low{range(0, limit - 1)};
+  const auto high{range(limit, 2 * limit)};
+
+  check(first.bitmap & second.bitmap, range(limit + 1, 2 * limit).reference,
+        "and of bitsets down to an array");
+  check(first.bitmap & high.bitmap, high.reference,
+        "and of bitsets staying a bitset");
+  check(first.bitmap - high.bitmap, low.reference,
+        "andnot of bitsets down to an array");
+  check(first.bitmap - low.bitmap, high.reference,
+        "andnot of an array keeping a bitset");
+  check(high.bitmap - range(limit, limit).bitmap,
+        range(limit + 1, 2 * limit).reference,
+        "andnot of one value down to an array");
+
+  check(low.bitmap | range(limit, limit).bitmap, range(0, limit).reference,
+        "or of arrays up to a bitset");
+  check(low.bitmap | low.bitmap, low.reference,
+        "or at the limit stays an array");
+  check(low.bitmap | high.bitmap, first.reference,
+        "or of an array into a bitset");
+}
+
+}  // namespace
+
+auto main() -> int {
+  check_operations();
+  check_crossings();
+  return csc::test::result();
+}
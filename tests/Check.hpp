@@ -0,0 +1,36 @@
+#ifndef CSC_TESTS_CHECK_HPP
+#define CSC_TESTS_CHECK_HPP
+
+#include <cstdlib>
+#include <iostream>
+#include <source_location>
+#include <string_view>
+
+namespace csc::test {
+
+inline int failures{0};
+
+/// \brief Reports `what` with its line if `condition` does not hold, and
+/// carries on so one run shows every failure.
+inline auto expect(bool condition, std::string_view what,
+                   std::source_location where =
+                       std::source_location::current()) -> void {
+  if (not condition) {
+    std::cerr << where.file_name() << ':' << where.line()
+              << ": FAILED: " << what << '\n';
+    ++failures;
+  }
+}
+
+/// \brief The exit code for `main`.
+inline auto result() -> int {
+  if (failures != 0) {
+    std::cerr << failures << " checks failed\n";
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace csc::test
+
+#endif  // CSC_TESTS_CHECK_HPP
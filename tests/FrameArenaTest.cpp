@@ -0,0 +1,108 @@
+// Once warm, formatting a frame's text must not touch the heap. Linked with
+// the counting operator new from src/Allocations.cpp.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/Allocations.hpp"
+#include "csc/FrameArena.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/LabelCache.hpp"
+#include "csc/Tags.hpp"
+#include "csc/date.hpp"
+
+using namespace std::literals::chrono_literals;
+using namespace csc::date::literals;  // NOLINT
+
+using csc::test::expect;
+
+namespace {
+
+/// Frames run before the arena and caches count as warm.
+constexpr int WarmUpFrames{2};
+constexpr int Frames{10};
+/// More than `frame::Arena::InitialCapacity` a frame, so it has to grow.
+constexpr std::size_t Lines{2000};
+
+/// \brief Heap allocations made by this thread while running `frame`.
+template <typename Frame>
+auto allocations_in(Frame&& frame) -> std::uint64_t {
+  const auto start{csc::allocations::count()};
+  frame();
+  return csc::allocations::count() - start;
+}
+
+auto arena_frames() -> void {
+  csc::frame::Arena arena;
+  const std::string_view title{"Andromeda Galaxy"};
+  const auto frame = [&] {
+    std::size_t bytes{0};
+    for (std::size_t i{0}; i < Lines; ++i) {
+      const auto line{arena.format("{}. {} ({} KiB)", i, title, i * 3)};
+      bytes += line.size();
+      expect(line.data()[line.size()] == '\0', "formatted text is terminated");
+    }
+    expect(arena.copy(title) == title, "copies match");
+    expect(arena.used() >= bytes, "used() counts what was formatted");
+    arena.reset();
+  };
+
+  expect(allocations_in(frame) != 0, "the first frame grows the arena");
+  for (int i{1}; i < WarmUpFrames; ++i) {
+    frame();
+  }
+  for (int i{0}; i < Frames; ++i) {
+    expect(allocations_in(frame) == 0, "a warm arena frame allocates nothing");
+  }
+  expect(arena.capacity() > csc::frame::Arena::InitialCapacity,
+         "the arena kept the busiest frame's capacity");
+}
+
+auto label_frames() -> void {
+  const auto tag{csc::tags::dictionary().intern("galaxy")};
+  std::vector<csc::ImageRecord> images;
+  for (int i{0}; i < 100; ++i) {
+    images.emplace_back("Image " + std::to_string(i), "A description",
+                        csc::ImageRecord::Genre::Astronomy(),
+                        csc::ImageRecord::DateType{
+                            2023y / std::chrono::January / 1d, 0_h},
+                        "Images/Andromeda.png");
+    images.back().add_tag(tag);
+  }
+
+  csc::frame::LabelCache labels;
+  std::uint64_t version{1};
+  const auto frame = [&] {
+    for (const auto& image : images) {
+      const auto& found{labels.get(image, version)};
+      expect(found.tooltip.starts_with(image.get_title()),
+             "the tooltip starts with the title");
+      expect(found.details.ends_with("Tags: galaxy"),
+             "the details list the tags");
+    }
+  };
+
+  for (int i{0}; i < WarmUpFrames; ++i) {
+    frame();
+  }
+  for (int i{0}; i < Frames; ++i) {
+    expect(allocations_in(frame) == 0, "cached labels allocate nothing");
+  }
+
+  ++version;
+  expect(allocations_in(frame) != 0, "a new catalog version reformats");
+  expect(allocations_in(frame) == 0, "and is cached again after one frame");
+}
+
+}  // namespace
+
+auto main() -> int {
+  arena_frames();
+  label_frames();
+  return csc::test::result();
+}
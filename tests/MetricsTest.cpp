@@ -0,0 +1,119 @@
+// Histogram buckets and quantiles stay within their stated precision,
+// counters lose nothing under contention, and both output formats report
+// what was recorded.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/Metrics.hpp"
+
+using csc::metrics::Histogram;
+using csc::test::expect;
+
+namespace {
+
+constexpr int Threads{8};
+constexpr std::uint64_t AddsPerThread{100000};
+
+auto check_buckets() -> void {
+  for (std::uint64_t nanos{0}; nanos < 1'000'000; nanos += 1 + nanos / 64) {
+    const auto bucket{Histogram::bucket_of(nanos)};
+    expect(Histogram::lower_bound(bucket) <= nanos and
+               nanos < Histogram::lower_bound(bucket + 1),
+           "a value lands in the bucket that covers it");
+    const auto width{Histogram::lower_bound(bucket + 1) -
+                     Histogram::lower_bound(bucket)};
+    expect(width * Histogram::SubBuckets <= std::max<std::uint64_t>(
+                                                nanos, Histogram::SubBuckets),
+           "buckets are at most 1/16 of their value wide");
+  }
+  expect(Histogram::bucket_of(~std::uint64_t{0}) == Histogram::Buckets - 1,
+         "huge values land in the last bucket");
+}
+
+auto check_quantiles() -> void {
+  Histogram histogram;
+  expect(histogram.snapshot().quantile(0.5) == 0, "empty quantile is 0");
+  // 1..1000 us, one sample each.
+  for (std::int64_t micros{1}; micros <= 1000; ++micros) {
+    histogram.record(std::chrono::microseconds{micros});
+  }
+  const auto snapshot{histogram.snapshot()};
+  expect(snapshot.count == 1000, "every sample is counted");
+  expect(snapshot.sum == 500'500'000, "the sum is exact");
+  for (const auto& [quantile, micros] :
+       {std::pair{0.5, 500.0}, std::pair{0.9, 900.0}, std::pair{0.99, 990.0}}) {
+    const auto reported{static_cast<double>(snapshot.quantile(quantile))};
+    const auto exact{micros * 1000.0};
+    expect(reported >= exact and reported <= exact * (1.0 + 1.0 / 16.0),
+           "quantiles are an upper bound within 1/16");
+  }
+  expect(snapshot.count_below(1U << 20) == 1000,
+         "count_below is exact at powers of two");
+  histogram.record(std::chrono::nanoseconds{-5});
+  expect(histogram.snapshot().buckets[0] == 1, "negative times count as 0");
+}
+
+auto check_counter() -> void {
+  csc::metrics::Counter counter;
+  std::vector<std::jthread> threads;
+  for (int t{0}; t < Threads; ++t) {
+    threads.emplace_back([&counter] {
+      for (std::uint64_t i{0}; i < AddsPerThread; ++i) {
+        counter.add();
+      }
+    });
+  }
+  threads.clear();
+  expect(counter.value() == Threads * AddsPerThread,
+         "concurrent adds are all counted");
+}
+
+auto check_output() -> void {
+  csc::metrics::Registry registry;
+  registry.counter("test_total", "A counter.").add(3);
+  registry.gauge("test_size", "A gauge.", "kind=\"a\"").set(-2);
+  auto& latency{registry.histogram("test_seconds", "A histogram.")};
+  latency.record(std::chrono::microseconds{3});
+  latency.record(std::chrono::milliseconds{2});
+
+  std::ostringstream text;
+  registry.write_text(text);
+  expect(text.str().contains("test_total 3\n"), "text has the counter");
+  expect(text.str().contains("test_size{kind=\"a\"} -2\n"),
+         "text has the labelled gauge");
+  expect(text.str().contains("test_seconds count=2 "),
+         "text has the histogram count");
+
+  std::ostringstream prometheus;
+  registry.write_prometheus(prometheus);
+  const auto exposition{prometheus.str()};
+  expect(exposition.contains("# TYPE test_total counter\ntest_total 3\n"),
+         "prometheus has the counter");
+  expect(exposition.contains("# TYPE test_seconds histogram\n"),
+         "prometheus types the histogram");
+  expect(exposition.contains("test_seconds_bucket{le=\"4.096e-06\"} 1\n"),
+         "prometheus buckets are cumulative, in seconds");
+  expect(exposition.contains("test_seconds_bucket{le=\"+Inf\"} 2\n"),
+         "the +Inf bucket holds every sample");
+  expect(exposition.contains("test_seconds_count 2\n"),
+         "prometheus has the histogram count");
+}
+
+}  // namespace
+
+auto main() -> int {
+  check_buckets();
+  check_quantiles();
+  check_counter();
+  check_output();
+  return csc::test::result();
+}
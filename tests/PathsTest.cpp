@@ -0,0 +1,177 @@
+// Every interned path must come back spelled exactly as it went in, across
+// front-coding block boundaries and however deep its directory, lookups of
+// known paths must not allocate, and threads interning the same paths at
+// once must agree on their ids.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/Allocations.hpp"
+#include "csc/Paths.hpp"
+
+using csc::paths::Dictionary;
+using csc::paths::PathId;
+using csc::test::expect;
+
+namespace {
+
+/// Names per front-coding block, as in `Dictionary`.
+constexpr std::size_t BlockSize{16};
+constexpr int Threads{8};
+constexpr std::size_t SharedPaths{3000};
+
+auto check_blocks() -> void {
+  Dictionary dictionary;
+  std::vector<std::string> names;
+  for (std::size_t i{0}; i < BlockSize * 6; ++i) {
+    // Long shared prefixes, names shorter and longer than the one before,
+    // one repeated name and one sharing nothing.
+    const auto number{std::to_string(i)};
+    if (i % 7 == 3) {
+      names.push_back("holiday_" + number + ".jpg");
+    } else if (i % 11 == 5) {
+      names.push_back("z");
+    } else {
+      // Zero padded to between one and four digits.
+      const auto digits{(i % 4) + 1};
+      const auto padding{digits > number.size() ? digits - number.size() : 0};
+      names.push_back("holiday_2024_beach_" + std::string(padding, '0') +
+                      number + ".png");
+    }
+  }
+  std::vector<PathId> ids;
+  for (const auto& name : names) {
+    ids.push_back(dictionary.intern(name));
+  }
+  for (std::size_t i{0}; i < names.size(); ++i) {
+    expect(dictionary.text(ids[i]) == names[i],
+           "a name comes back as spelled, wherever it is in its block");
+    expect(dictionary.find(names[i]) == ids[i], "find of an interned name");
+  }
+  // Ids are dense, so each multiple of BlockSize starts a block.
+  for (std::size_t id{0}; id < dictionary.size(); ++id) {
+    const auto text{dictionary.text(static_cast<PathId>(id))};
+    expect(dictionary.find(text) == id, "every id round-trips");
+    if (id % BlockSize == 0 and id != 0) {
+      expect(text != dictionary.text(static_cast<PathId>(id - 1)),
+             "distinct names either side of a block boundary");
+    }
+  }
+  expect(dictionary.size() ==
+             std::set<std::string>(names.begin(), names.end()).size(),
+         "a repeated name keeps its id");
+}
+
+auto check_directories() -> void {
+  Dictionary dictionary;
+  const std::vector<std::string> paths{
+      "rel.png",
+      "Images/cat.png",
+      "Images/dogs/dog.png",
+      "Images/dogs/puppies/small/tiny.png",
+      "Images/dogs/dog.png.bak",
+      "Other/dogs/dog.png",
+      "/absolute/path/to/a/very/long/directory/name/file.png",
+      "double//slash.png",
+      "./here/../there.png",
+      "trailing/",
+      "Images/Cat.png",
+  };
+  std::vector<PathId> ids;
+  for (const auto& path : paths) {
+    ids.push_back(dictionary.intern(path));
+  }
+  for (std::size_t i{0}; i < paths.size(); ++i) {
+    expect(dictionary.text(ids[i]) == paths[i],
+           "the full directory spelling is rebuilt");
+    expect(dictionary.path(ids[i]) == std::filesystem::path{paths[i]},
+           "path() matches text()");
+    expect(dictionary.intern(paths[i]) == ids[i], "interning again");
+  }
+  expect(dictionary.size() == paths.size(), "every spelling is its own path");
+  expect(not dictionary.find("Images/dogs/cat.png"),
+         "a known name in another known directory is not found");
+  expect(not dictionary.find("Images/cats/cat.png"),
+         "an unknown directory is not found");
+  expect(not dictionary.find("Images/dogs"), "a directory is not a path");
+}
+
+auto check_lookups_do_not_allocate() -> void {
+  if constexpr (not std::is_same_v<std::filesystem::path::value_type, char>) {
+    return;  // Spelling a wide path narrows it into a new string.
+  }
+  Dictionary dictionary;
+  const std::filesystem::path known{
+      "a_long_catalog_directory_name/another_long_subdirectory/"
+      "a_long_file_name_for_a_thumbnail.png"};
+  const auto id{dictionary.intern(known)};
+  static_cast<void>(dictionary.find(known));  // Warms the decoding buffer.
+
+  const auto before{csc::allocations::count()};
+  const auto found{dictionary.find(known)};
+  const auto again{dictionary.intern(known)};
+  expect(csc::allocations::count() == before,
+         "finding and re-interning a known path do not allocate");
+  expect(found == id and again == id, "and still find it");
+}
+
+/// \brief Threads intern the same paths in different orders, plus some of
+/// their own, all at once.
+auto check_threads() -> void {
+  Dictionary dictionary;
+  std::vector<std::string> shared;
+  for (std::size_t i{0}; i < SharedPaths; ++i) {
+    shared.push_back("Images/" + std::to_string(i % 7) + '/' +
+                     std::to_string(i % 3) + "/photo_" + std::to_string(i) +
+                     ".png");
+  }
+  std::vector<std::vector<std::string>> spelled(Threads);
+  std::vector<std::vector<PathId>> ids(Threads);
+  {
+    std::vector<std::jthread> threads;
+    for (int t{0}; t < Threads; ++t) {
+      threads.emplace_back([&, t] {
+        auto order{shared};
+        for (int own{0}; own < 200; ++own) {
+          order.push_back("Thread" + std::to_string(t) + "/own_" +
+                          std::to_string(own) + ".png");
+        }
+        std::ranges::shuffle(order, std::mt19937{static_cast<unsigned>(t)});
+        for (const auto& path : order) {
+          spelled[t].push_back(path);
+          ids[t].push_back(dictionary.intern(path));
+        }
+      });
+    }
+  }
+
+  expect(dictionary.size() == SharedPaths + (Threads * 200),
+         "each distinct path is interned once");
+  for (int t{0}; t < Threads; ++t) {
+    for (std::size_t i{0}; i < spelled[t].size(); ++i) {
+      expect(dictionary.find(spelled[t][i]) == ids[t][i],
+             "every thread got the id the dictionary keeps");
+      expect(dictionary.text(ids[t][i]) == spelled[t][i],
+             "ids interned concurrently spell their paths");
+    }
+  }
+}
+
+}  // namespace
+
+auto main() -> int {
+  check_blocks();
+  check_directories();
+  check_lookups_do_not_allocate();
+  check_threads();
+  return csc::test::result();
+}
@@ -0,0 +1,60 @@
+// Erasing titles that were never inserted, or erasing one more time than it
+// was inserted, must leave the index as it was.
+
+#include <string_view>
+
+#include "Check.hpp"
+#include "csc/PrefixIndex.hpp"
+
+using csc::test::expect;
+
+namespace {
+
+auto check_completion() -> void {
+  csc::suggest::PrefixIndex index;
+  index.insert("Sunset Beach");
+  index.insert("Sunset Beach");
+  index.insert("sunrise");
+  const auto found{index.complete("sun")};
+  expect(found.size() == 3 and found[0].count == 2 and
+             found[2].text == "sunrise",
+         "the most used completions come first");
+  expect(index.complete("BEA").size() == 1, "words complete, any case");
+  expect(index.titles() == 2, "distinct titles are counted");
+}
+
+auto check_erase_unknown() -> void {
+  csc::suggest::PrefixIndex index;
+  index.insert("Sunset Beach");
+  const auto bytes{index.bytes()};
+  index.erase("Sunrise Over Water");
+  index.erase("Sun");
+  index.erase("Moon");
+  expect(index.bytes() == bytes, "erasing unknown titles allocates nothing");
+  expect(index.titles() == 1, "erasing unknown titles counts no title");
+  expect(index.complete("sunset").size() == 2 and
+             index.complete("beach").size() == 1,
+         "erasing unknown titles keeps the known ones");
+}
+
+auto check_erase_twice() -> void {
+  csc::suggest::PrefixIndex index;
+  index.insert("Sunset");
+  index.erase("Sunset");
+  index.erase("Sunset");
+  expect(index.titles() == 0, "the title count does not wrap");
+  expect(index.complete("sun").empty(), "an erased title is not suggested");
+  index.insert("Sunset");
+  const auto found{index.complete("sun")};
+  expect(found.size() == 1 and found[0].count == 1,
+         "the count does not wrap below zero");
+}
+
+}  // namespace
+
+auto main() -> int {
+  check_completion();
+  check_erase_unknown();
+  check_erase_twice();
+  return csc::test::result();
+}
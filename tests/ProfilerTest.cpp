@@ -0,0 +1,142 @@
+// Stage times added from several threads must all land in some frame, the
+// ring must keep only its newest frames, percentiles must come from them, and
+// switching the profiler back on must start from an empty ring.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/Profiler.hpp"
+
+using csc::profile::Profiler;
+using csc::profile::Stage;
+using csc::test::expect;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+
+namespace {
+
+constexpr int Threads{4};
+constexpr std::uint64_t AddsPerThread{100000};
+
+auto near(double value, double expected) -> bool {
+  return std::abs(value - expected) < 1e-9;
+}
+
+auto frame_count(const Profiler& profiler) -> std::size_t {
+  std::array<float, Profiler::Frames> times{};
+  return profiler.frame_times(times);
+}
+
+auto check_percentiles() -> void {
+  Profiler profiler;
+  profiler.enable(true);
+  expect(frame_count(profiler) == 0, "a new profiler has no frames");
+  expect(profiler.frame_percentiles().p50 == 0, "no frames, no percentiles");
+
+  // Frames of 1..100 ms, each spending 2 ms searching.
+  for (int frame{1}; frame <= 100; ++frame) {
+    profiler.add(Stage::Search, milliseconds{2});
+    profiler.end_frame(milliseconds{frame});
+  }
+  expect(frame_count(profiler) == 100, "every frame is kept");
+  const auto frames{profiler.frame_percentiles()};
+  expect(near(frames.p50, 50) and near(frames.p99, 99) and
+             near(frames.mean, 50.5),
+         "frame percentiles");
+  const auto search{profiler.stage_percentiles(Stage::Search)};
+  expect(near(search.p50, 2) and near(search.p99, 2) and near(search.mean, 2),
+         "stage percentiles");
+  expect(profiler.stage_percentiles(Stage::Render).p99 == 0,
+         "an untimed stage is 0");
+}
+
+auto check_ring() -> void {
+  Profiler profiler;
+  profiler.enable(true);
+  for (std::size_t frame{1}; frame <= Profiler::Frames * 2; ++frame) {
+    profiler.end_frame(milliseconds{frame});
+  }
+  std::array<float, Profiler::Frames> times{};
+  const auto count{profiler.frame_times(times)};
+  expect(count == Profiler::Frames - 1, "the ring keeps its newest frames");
+  expect(times[0] == static_cast<float>(Profiler::Frames + 2) and
+             times[count - 1] == static_cast<float>(Profiler::Frames * 2),
+         "frame times run oldest first");
+
+  std::array<float, 10> last{};
+  expect(profiler.frame_times(last) == last.size() and
+             last.back() == static_cast<float>(Profiler::Frames * 2),
+         "a short span gets the newest frames");
+}
+
+/// \brief Timers on other threads race the frame owner closing frames. Every
+/// nanosecond they add is in some frame, as long as the ring does not wrap.
+auto check_threads() -> void {
+  Profiler profiler;
+  profiler.enable(true);
+  std::atomic<int> running{Threads};
+  {
+    std::vector<std::jthread> threads;
+    for (int t{0}; t < Threads; ++t) {
+      threads.emplace_back([&profiler, &running] {
+        for (std::uint64_t i{0}; i < AddsPerThread; ++i) {
+          profiler.add(Stage::Decode, nanoseconds{1});
+        }
+        running.fetch_sub(1);
+      });
+    }
+    std::size_t frames{0};
+    while (running.load() != 0 and frames < Profiler::Frames / 2) {
+      profiler.end_frame(milliseconds{1});
+      ++frames;
+      std::this_thread::yield();
+    }
+  }
+  profiler.end_frame(milliseconds{1});
+
+  const auto count{static_cast<double>(frame_count(profiler))};
+  const auto decode{profiler.stage_percentiles(Stage::Decode)};
+  expect(std::llround(decode.mean * count * 1e6) ==
+             static_cast<long long>(Threads * AddsPerThread),
+         "concurrent adds all land in a frame");
+}
+
+auto check_reenable() -> void {
+  Profiler profiler;
+  profiler.enable(true);
+  for (int frame{0}; frame < 50; ++frame) {
+    profiler.add(Stage::Layout, milliseconds{5});
+    profiler.end_frame(milliseconds{30});
+  }
+  profiler.add(Stage::Layout, milliseconds{5});
+  profiler.enable(false);
+  {
+    const csc::profile::ScopedTimer timer{Stage::Layout, profiler};
+  }
+  profiler.enable(true);
+  expect(frame_count(profiler) == 0, "re-enabling empties the ring");
+
+  profiler.end_frame(milliseconds{10});
+  expect(frame_count(profiler) == 1, "only the new frame is counted");
+  expect(near(profiler.frame_percentiles().p99, 10),
+         "old frames leave the percentiles");
+  expect(profiler.stage_percentiles(Stage::Layout).p99 == 0,
+         "the open frame is emptied too");
+}
+
+}  // namespace
+
+auto main() -> int {
+  check_percentiles();
+  check_ring();
+  check_threads();
+  check_reenable();
+  return csc::test::result();
+}
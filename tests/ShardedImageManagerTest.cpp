@@ -0,0 +1,193 @@
+// A sharded manager must answer every query as one ImageManager holding the
+// same records would, whether it searches its shards in turn or in parallel.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/ColourSignature.hpp"
+#include "csc/Facets.hpp"
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageInfo.hpp"
+#include "csc/ImageManager.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/ShardedImageManager.hpp"
+#include "csc/Tags.hpp"
+
+using csc::test::expect;
+
+namespace {
+
+constexpr std::array Words{"beach", "sunset", "cat",   "dog",   "tree",
+                           "river", "city",   "night", "snow", "field"};
+
+class Records {
+ public:
+  explicit Records(unsigned seed) : random_{seed} {}
+
+  auto next() -> csc::ImageRecord {
+    const auto word = [this] { return Words[pick(Words.size())]; };
+    const std::chrono::year_month_day date{
+        std::chrono::year{1990 + static_cast<int>(pick(40))},
+        std::chrono::month{1 + below(12)}, std::chrono::day{1 + below(28)}};
+    csc::ImageRecord image{
+        std::string{word()} + ' ' + word(), std::string{word()},
+        csc::ImageRecord::Genre::from_index(pick(9)),
+        csc::ImageRecord::DateType{date, csc::date::Time{}},
+        "Images/" + std::string{word()} + ".png"};
+    image.add_tag(csc::tags::dictionary().intern(word()));
+    image.set_perceptual_hash((std::uint64_t{below(UINT32_MAX)} << 32U) |
+                              below(UINT32_MAX));
+    csc::colour::Signature signature{};
+    for (auto& bin : signature) {
+      bin = static_cast<std::uint8_t>(below(16));
+    }
+    image.set_colour_signature(signature);
+    image.set_info(csc::ImageInfo{.format = csc::ImageInfo::Format::Png,
+                                  .width = 100 + below(4000),
+                                  .height = 100 + below(4000)});
+    return image;
+  }
+
+  auto pick(std::size_t count) -> std::size_t { return random_() % count; }
+  auto below(std::uint32_t count) -> std::uint32_t {
+    return static_cast<std::uint32_t>(random_() % count);
+  }
+
+ private:
+  std::mt19937 random_;
+};
+
+auto ids(const csc::ImageAlbum& album) -> std::vector<std::size_t> {
+  std::vector<std::size_t> ids;
+  for (const auto& image : album) {
+    ids.push_back(image.get_id());
+  }
+  return ids;
+}
+
+/// \brief Same ids in the same (date) order.
+auto same(const csc::ImageAlbum& sharded, const csc::ImageAlbum& single)
+    -> bool {
+  auto lhs{ids(sharded)};
+  auto rhs{ids(single)};
+  // Records on the same date may come in either order.
+  const auto by_date = [](const csc::ImageAlbum& album) {
+    return std::ranges::is_sorted(album.get_images(), std::less{});
+  };
+  std::ranges::sort(lhs);
+  std::ranges::sort(rhs);
+  return lhs == rhs and by_date(sharded);
+}
+
+auto compare(const csc::ShardedImageManager& sharded,
+             const csc::ImageManager& single, Records& records) -> void {
+  expect(sharded.size() == single.size(), "size");
+  expect(same(sharded.get_all_images(), single.get_all_images()),
+         "get_all_images");
+  expect(sharded.get_all_images().get_images().size() == single.size(),
+         "get_all_images holds no removed records");
+
+  for (const auto* word : Words) {
+    expect(same(sharded.search_title(word), single.search_title(word)),
+           "search_title");
+    expect(same(sharded.search_description(word),
+                single.search_description(word)),
+           "search_description");
+    const auto query{std::string{word} + " -night"};
+    expect(same(sharded.search_tags(query), single.search_tags(query)),
+           "search_tags");
+  }
+  for (std::size_t genre{0}; genre < 9; ++genre) {
+    const auto value{csc::ImageRecord::Genre::from_index(genre)};
+    expect(same(sharded.search_genre(value), single.search_genre(value)),
+           "search_genre");
+  }
+  const csc::ImageRecord::DateType from{
+      std::chrono::year{2000} / 1 / 1, csc::date::Time{}};
+  const csc::ImageRecord::DateType to{std::chrono::year{2010} / 1 / 1,
+                                      csc::date::Time{}};
+  expect(same(sharded.search_between_dates(from, to),
+              single.search_between_dates(from, to)),
+         "search_between_dates");
+  expect(same(sharded.search_min_size(2000, 2000),
+              single.search_min_size(2000, 2000)),
+         "search_min_size");
+  expect(same(sharded.search_orientation(csc::ImageInfo::Orientation::Portrait),
+              single.search_orientation(csc::ImageInfo::Orientation::Portrait)),
+         "search_orientation");
+
+  std::vector<const csc::ImageRecord*> live;
+  for (const auto& image : single.get_all_images()) {
+    live.push_back(&image);
+  }
+  for (int i{0}; i < 20; ++i) {
+    const auto& probe{*live[records.pick(live.size())]};
+    const auto found{sharded.search_id(probe.get_id())};
+    expect(found and found->get_title() == probe.get_title(), "search_id");
+    expect(same(sharded.search_similar(*probe.get_perceptual_hash(), 12),
+                single.search_similar(*probe.get_perceptual_hash(), 12)),
+           "search_similar");
+    expect(sharded.search_colour(*probe.get_colour_signature(), 5).size() ==
+               single.search_colour(*probe.get_colour_signature(), 5).size(),
+           "search_colour");
+  }
+
+  const auto lhs{sharded.facets(csc::facet::Period::Year)};
+  const auto rhs{single.facets(csc::facet::Period::Year)};
+  expect(lhs.total == rhs.total and lhs.genres == rhs.genres and
+             lhs.rows.size() == rhs.rows.size(),
+         "facets");
+}
+
+/// \brief Adds `count` records to both, then removes and edits some.
+auto exercise(std::size_t count, std::size_t shards) -> void {
+  Records records{static_cast<unsigned>(count + shards)};
+  csc::ShardedImageManager sharded{shards};
+  csc::ImageManager single;
+  std::vector<std::size_t> added;
+  for (std::size_t i{0}; i < count; ++i) {
+    auto image{records.next()};
+    added.push_back(image.get_id());
+    single.add_image(csc::ImageRecord{image});
+    sharded.add_image(std::move(image));
+  }
+  compare(sharded, single, records);
+
+  for (std::size_t i{0}; i < count / 5; ++i) {
+    const auto id{added[records.pick(added.size())]};
+    expect(sharded.remove_image(id) == single.remove_image(id),
+           "remove_image");
+  }
+  const auto tag{csc::tags::dictionary().intern("edited")};
+  for (std::size_t i{0}; i < count / 5; ++i) {
+    const auto id{added[records.pick(added.size())]};
+    const auto edit = [tag](csc::ImageRecord& image) {
+      image.set_title("edited");
+      image.add_tag(tag);
+    };
+    expect(sharded.update_image(id, edit) == single.update_image(id, edit),
+           "update_image");
+  }
+  compare(sharded, single, records);
+
+  sharded.compact();
+  single.compact();
+  compare(sharded, single, records);
+}
+
+}  // namespace
+
+auto main() -> int {
+  // Below ParallelThreshold the shards are searched in turn; above, at once.
+  exercise(500, 4);
+  exercise(csc::ShardedImageManager::ParallelThreshold * 3, 4);
+  exercise(1000, 1);
+  return csc::test::result();
+}
@@ -0,0 +1,100 @@
+// Random allocations, releases and compactions must never leave two live
+// entries overlapping or one outside its page.
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/ShelfPacker.hpp"
+
+using csc::test::expect;
+
+namespace {
+
+constexpr std::uint32_t PageSize{1024};
+constexpr std::uint32_t MaxPages{4};
+constexpr int Steps{20000};
+
+auto overlap(const csc::atlas::Rect& a, const csc::atlas::Rect& b) -> bool {
+  return a.page == b.page and a.x < b.x + b.width and b.x < a.x + a.width and
+         a.y < b.y + b.height and b.y < a.y + a.height;
+}
+
+/// \brief Every live entry inside its page and clear of every other.
+auto check_layout(const csc::atlas::ShelfPacker& packer,
+                  const std::vector<csc::atlas::ShelfPacker::Handle>& live)
+    -> void {
+  for (std::size_t i{0}; i < live.size(); ++i) {
+    const auto& rect{packer.rect(live[i])};
+    expect(rect.page < packer.page_count() and
+               rect.x + rect.width <= PageSize and
+               rect.y + rect.height <= PageSize,
+           "entries stay on their page");
+    for (std::size_t j{i + 1}; j < live.size(); ++j) {
+      expect(not overlap(rect, packer.rect(live[j])),
+             "live entries do not overlap");
+    }
+  }
+  expect(packer.live_count() == live.size(), "live_count");
+}
+
+auto random_operations() -> void {
+  std::mt19937 random{37};
+  const auto below = [&random](std::uint32_t count) {
+    return static_cast<std::uint32_t>(random() % count);
+  };
+  csc::atlas::ShelfPacker packer{PageSize, MaxPages};
+  std::vector<csc::atlas::ShelfPacker::Handle> live;
+
+  for (int step{0}; step < Steps; ++step) {
+    const auto choice{below(10)};
+    if (choice < 6) {
+      const auto width{1 + below(128)};
+      const auto height{1 + below(128)};
+      if (const auto handle = packer.allocate(width, height)) {
+        const auto& rect{packer.rect(*handle)};
+        expect(rect.width == width and rect.height == height,
+               "allocate keeps the size asked for");
+        live.push_back(*handle);
+      }
+    } else if (choice < 9 and not live.empty()) {
+      const auto at{below(static_cast<std::uint32_t>(live.size()))};
+      packer.release(live[at]);
+      live[at] = live.back();
+      live.pop_back();
+    } else if (const auto page = packer.most_fragmented_page()) {
+      for (const auto& move : packer.compact(*page)) {
+        expect(move.from.page == *page and move.to.page == *page,
+               "compact stays on its page");
+        expect(packer.rect(move.handle) == move.to,
+               "compact reports the new place");
+      }
+    }
+    if (step % 1000 == 0) {
+      check_layout(packer, live);
+    }
+  }
+  check_layout(packer, live);
+}
+
+auto rejects_what_cannot_fit() -> void {
+  csc::atlas::ShelfPacker packer{PageSize, 1};
+  expect(not packer.allocate(0, 10), "an empty entry is refused");
+  expect(not packer.allocate(PageSize + 1, 10), "a too wide entry is refused");
+  const auto whole{packer.allocate(PageSize, PageSize)};
+  expect(whole.has_value(), "a page-sized entry fits an empty page");
+  expect(not packer.allocate(1, 1), "a full last page refuses more");
+  packer.release(*whole);
+  expect(packer.allocate(1, 1).has_value(), "an emptied page is reused");
+}
+
+}  // namespace
+
+auto main() -> int {
+  random_operations();
+  rejects_what_cannot_fit();
+  return csc::test::result();
+}
@@ -0,0 +1,323 @@
+// A catalog loaded from its snapshot must answer every search as one built
+// from the same records does, before and after it changes, and a damaged,
+// truncated or out-of-date file must be refused rather than misread.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/ColourSignature.hpp"
+#include "csc/Facets.hpp"
+#include "csc/ImageAlbum.hpp"
+#include "csc/ImageInfo.hpp"
+#include "csc/ImageManager.hpp"
+#include "csc/ImageRecord.hpp"
+#include "csc/Snapshot.hpp"
+#include "csc/Tags.hpp"
+
+using csc::test::expect;
+
+namespace {
+
+constexpr std::array Words{"beach", "sunset", "cat",   "dog",   "tree",
+                           "river", "city",   "night", "snow", "field"};
+constexpr std::size_t Count{2000};
+
+class Records {
+ public:
+  explicit Records(unsigned seed) : random_{seed} {}
+
+  auto next() -> csc::ImageRecord {
+    const auto word = [this] { return Words[pick(Words.size())]; };
+    csc::ImageRecord image{std::string{word()} + ' ' + word(),
+                           std::string{word()},
+                           csc::ImageRecord::Genre::from_index(pick(9)),
+                           date(), "Images/" + std::string{word()} + ".png"};
+    image.add_tag(csc::tags::dictionary().intern(word()));
+    image.set_perceptual_hash((std::uint64_t{below(UINT32_MAX)} << 32U) |
+                              below(UINT32_MAX));
+    image.set_colour_signature(signature());
+    image.set_info(csc::ImageInfo{.format = csc::ImageInfo::Format::Png,
+                                  .width = 100 + below(4000),
+                                  .height = 100 + below(4000)});
+    return image;
+  }
+
+  auto date() -> csc::ImageRecord::DateType {
+    const std::chrono::year_month_day day{
+        std::chrono::year{1990 + static_cast<int>(pick(40))},
+        std::chrono::month{1 + below(12)}, std::chrono::day{1 + below(28)}};
+    return {day, csc::date::Time{}};
+  }
+  auto signature() -> csc::colour::Signature {
+    csc::colour::Signature signature{};
+    for (auto& bin : signature) {
+      bin = static_cast<std::uint8_t>(below(16));
+    }
+    return signature;
+  }
+
+  auto pick(std::size_t count) -> std::size_t { return random_() % count; }
+  auto below(std::uint32_t count) -> std::uint32_t {
+    return static_cast<std::uint32_t>(random_() % count);
+  }
+
+ private:
+  std::mt19937 random_;
+};
+
+auto ids(const csc::ImageAlbum& album) -> std::vector<std::size_t> {
+  std::vector<std::size_t> ids;
+  for (const auto& image : album) {
+    ids.push_back(image.get_id());
+  }
+  return ids;
+}
+
+auto same(const csc::ImageAlbum& lhs, const csc::ImageAlbum& rhs) -> bool {
+  return ids(lhs) == ids(rhs);
+}
+
+auto copy_records(const csc::ImageManager& manager)
+    -> csc::ImageAlbum::ImageCollection {
+  csc::ImageAlbum::ImageCollection images;
+  for (const auto& image : manager.get_all_images()) {
+    images.push_back(image);
+  }
+  return images;
+}
+
+/// \brief Completions of `prefix` with their counts, in text order, as
+/// titles used equally often may be offered in either order.
+auto suggestions(const csc::ImageManager& manager, std::string_view prefix)
+    -> std::vector<std::pair<std::string, std::uint32_t>> {
+  std::vector<std::pair<std::string, std::uint32_t>> found;
+  for (const auto& suggestion : manager.suggest_titles(prefix)) {
+    found.emplace_back(suggestion.text, suggestion.count);
+  }
+  std::ranges::sort(found);
+  return found;
+}
+
+/// \brief `mapped` answers as `built` does. Both hold the same records in the
+/// same slots, so results match id for id.
+auto compare(const csc::ImageManager& mapped, const csc::ImageManager& built,
+             Records& records) -> void {
+  expect(mapped.size() == built.size(), "size");
+  expect(same(mapped.get_all_images(), built.get_all_images()),
+         "get_all_images");
+
+  for (const auto* word : Words) {
+    expect(same(mapped.search_title(word), built.search_title(word)),
+           "search_title");
+    expect(same(mapped.search_description(word),
+                built.search_description(word)),
+           "search_description");
+    const auto query{std::string{word} + " -night"};
+    expect(same(mapped.search_tags(query), built.search_tags(query)),
+           "search_tags");
+    const auto prefix{std::string_view{word}.substr(0, 2)};
+    expect(suggestions(mapped, prefix) == suggestions(built, prefix),
+           "suggest_titles");
+  }
+  for (std::size_t genre{0}; genre < 9; ++genre) {
+    const auto value{csc::ImageRecord::Genre::from_index(genre)};
+    expect(same(mapped.search_genre(value), built.search_genre(value)),
+           "search_genre");
+  }
+  const csc::ImageRecord::DateType from{std::chrono::year{2000} / 1 / 1,
+                                        csc::date::Time{}};
+  const csc::ImageRecord::DateType to{std::chrono::year{2010} / 1 / 1,
+                                      csc::date::Time{}};
+  expect(same(mapped.search_between_dates(from, to),
+              built.search_between_dates(from, to)),
+         "search_between_dates");
+  expect(same(mapped.search_min_size(2000, 2000),
+              built.search_min_size(2000, 2000)),
+         "search_min_size");
+  expect(same(mapped.search_orientation(csc::ImageInfo::Orientation::Portrait),
+              built.search_orientation(csc::ImageInfo::Orientation::Portrait)),
+         "search_orientation");
+
+  std::vector<const csc::ImageRecord*> live;
+  for (const auto& image : built.get_all_images()) {
+    live.push_back(&image);
+  }
+  for (int i{0}; i < 20; ++i) {
+    const auto& probe{*live[records.pick(live.size())]};
+    const auto found{mapped.search_id(probe.get_id())};
+    expect(found and (*found)->get_title() == probe.get_title(), "search_id");
+    expect(same(mapped.search_similar(*probe.get_perceptual_hash(), 12),
+                built.search_similar(*probe.get_perceptual_hash(), 12)),
+           "search_similar");
+    // Ties may be broken differently by differently built trees.
+    const auto lhs{mapped.nearest_colours(*probe.get_colour_signature(), 5)};
+    const auto rhs{built.nearest_colours(*probe.get_colour_signature(), 5)};
+    expect(std::ranges::equal(lhs, rhs,
+                              [](const auto& a, const auto& b) {
+                                return a.distance == b.distance;
+                              }),
+           "nearest_colours");
+  }
+
+  for (const auto period : {csc::facet::Period::Day, csc::facet::Period::Month,
+                            csc::facet::Period::Year}) {
+    const auto lhs{mapped.facets(period)};
+    const auto rhs{built.facets(period)};
+    expect(lhs.total == rhs.total and lhs.genres == rhs.genres and
+               std::ranges::equal(lhs.rows, rhs.rows,
+                                  [](const auto& a, const auto& b) {
+                                    return a.genres == b.genres;
+                                  }),
+           "facets");
+  }
+}
+
+/// \brief Removes, edits and adds the same records in both.
+auto mutate(csc::ImageManager& mapped, csc::ImageManager& built,
+            Records& records) -> void {
+  const auto images{copy_records(built)};
+  for (std::size_t i{0}; i < Count / 10; ++i) {
+    const auto id{images[records.pick(images.size())].get_id()};
+    expect(mapped.remove_image(id) == built.remove_image(id), "remove_image");
+  }
+  const auto tag{csc::tags::dictionary().intern("edited")};
+  for (std::size_t i{0}; i < Count / 10; ++i) {
+    const auto id{images[records.pick(images.size())].get_id()};
+    const auto hash{(std::uint64_t{records.below(UINT32_MAX)} << 32U) |
+                    records.below(UINT32_MAX)};
+    const auto signature{records.signature()};
+    const auto date{records.date()};
+    const auto edit = [&](csc::ImageRecord& image) {
+      image.set_title("edited " + std::string{image.get_title()});
+      image.add_tag(tag);
+      image.set_perceptual_hash(hash);
+      image.set_colour_signature(signature);
+      image.set_date_taken(date);
+    };
+    expect(mapped.update_image(id, edit) == built.update_image(id, edit),
+           "update_image");
+  }
+  for (std::size_t i{0}; i < Count / 10; ++i) {
+    auto image{records.next()};
+    mapped.add_image(csc::ImageRecord{image});
+    built.add_image(std::move(image));
+  }
+}
+
+auto write_bytes(const std::filesystem::path& path, const std::string& bytes)
+    -> void {
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+auto read_bytes(const std::filesystem::path& path) -> std::string {
+  std::ifstream file{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>{file},
+          std::istreambuf_iterator<char>{}};
+}
+
+auto check_round_trip(const std::filesystem::path& path) -> void {
+  Records records{47};
+  csc::ImageManager original;
+  csc::ImageAlbum::ImageCollection images;
+  for (std::size_t i{0}; i < Count; ++i) {
+    images.push_back(records.next());
+  }
+  original.add_images(std::move(images));
+  original.save_snapshot(path);
+
+  csc::ImageManager mapped;
+  expect(mapped.load(copy_records(original), path), "the snapshot is mapped");
+  csc::ImageManager built;
+  expect(not built.load(copy_records(original), path.string() + ".missing"),
+         "a missing snapshot is rebuilt");
+  compare(mapped, built, records);
+  compare(mapped, original, records);
+
+  // Every mapped index is copied out on its first change.
+  mutate(mapped, built, records);
+  compare(mapped, built, records);
+  mapped.compact();
+  built.compact();
+  compare(mapped, built, records);
+
+  // The file is untouched, and still maps for the original records.
+  csc::ImageManager again;
+  expect(again.load(copy_records(original), path),
+         "the snapshot maps again after a mapped catalog changed");
+  compare(again, original, records);
+}
+
+auto check_mappable() -> void {
+  const std::vector<std::uint32_t> file{1, 2, 3};
+  csc::snapshot::Mappable<std::uint32_t> items;
+  items.borrow(file);
+  expect(items.is_borrowed() and items.capacity() == 0,
+         "borrowing holds no heap memory");
+  items.owned().push_back(4);
+  expect(not items.is_borrowed(), "a change copies the items out");
+  expect(items == csc::snapshot::Mappable<std::uint32_t>{1, 2, 3, 4},
+         "the copy keeps every borrowed item");
+  expect(file == std::vector<std::uint32_t>{1, 2, 3},
+         "the borrowed items are left alone");
+}
+
+auto check_rejected(const std::filesystem::path& path) -> void {
+  const auto good{read_bytes(path)};
+  expect(csc::snapshot::Snapshot::open(path).has_value(),
+         "the written snapshot opens");
+  const auto damaged{path.string() + ".damaged"};
+
+  write_bytes(damaged, good.substr(0, good.size() - 1));
+  expect(not csc::snapshot::Snapshot::open(damaged),
+         "a truncated snapshot is refused");
+  write_bytes(damaged, good.substr(0, 16));
+  expect(not csc::snapshot::Snapshot::open(damaged),
+         "a snapshot cut inside its header is refused");
+
+  auto flipped{good};
+  flipped[flipped.size() - 1] ^= 0x01;
+  write_bytes(damaged, flipped);
+  expect(not csc::snapshot::Snapshot::open(damaged),
+         "a flipped byte in a section is refused");
+  flipped = good;
+  flipped[flipped.size() / 2] ^= 0x40;
+  write_bytes(damaged, flipped);
+  expect(not csc::snapshot::Snapshot::open(damaged),
+         "a flipped byte mid-file is refused");
+
+  // The version follows the eight byte magic number.
+  auto bumped{good};
+  const auto version{csc::snapshot::FormatVersion + 1};
+  std::memcpy(bumped.data() + 8, &version, sizeof version);
+  write_bytes(damaged, bumped);
+  expect(not csc::snapshot::Snapshot::open(damaged),
+         "another format version is refused");
+
+  std::filesystem::remove(damaged);
+}
+
+}  // namespace
+
+auto main() -> int {
+  const auto path{std::filesystem::temp_directory_path() /
+                   "csc_snapshot_test.snap"};
+  check_mappable();
+  check_round_trip(path);
+  check_rejected(path);
+  std::filesystem::remove(path);
+  return csc::test::result();
+}
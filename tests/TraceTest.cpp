@@ -0,0 +1,353 @@
+// Scopes timed on several threads at once must all reach the trace file, as
+// Chrome Trace Event JSON that parses, with one complete event per scope on
+// the thread that ran it.
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Check.hpp"
+#include "csc/Trace.hpp"
+
+using csc::test::expect;
+
+namespace {
+
+constexpr int Threads{6};
+constexpr int ScopesPerThread{2000};
+constexpr auto Worker{"worker"};
+constexpr auto Inner{"inner \"quoted\" \\ name"};
+constexpr auto Main{"main"};
+
+/// \brief Just enough JSON to read a trace back: objects, arrays, strings and
+/// numbers, plus the literals.
+struct Json {
+  using Object = std::map<std::string, Json>;
+  using Array = std::vector<Json>;
+  std::variant<std::nullptr_t, bool, double, std::string,
+               std::shared_ptr<Array>, std::shared_ptr<Object>>
+      value;
+
+  [[nodiscard]] auto object() const -> const Object* {
+    const auto* held{std::get_if<std::shared_ptr<Object>>(&value)};
+    return held != nullptr ? held->get() : nullptr;
+  }
+  [[nodiscard]] auto array() const -> const Array* {
+    const auto* held{std::get_if<std::shared_ptr<Array>>(&value)};
+    return held != nullptr ? held->get() : nullptr;
+  }
+  [[nodiscard]] auto string() const -> const std::string* {
+    return std::get_if<std::string>(&value);
+  }
+  [[nodiscard]] auto number() const -> const double* {
+    return std::get_if<double>(&value);
+  }
+};
+
+class Parser {
+ public:
+  explicit Parser(std::string_view text) : text_{text} {}
+
+  /// \return Nothing unless all of the text is one JSON value.
+  auto parse() -> std::optional<Json> {
+    auto value{parse_value()};
+    skip_space();
+    if (not value or at_ != text_.size()) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+ private:
+  auto skip_space() -> void {
+    while (at_ < text_.size() and
+           std::isspace(static_cast<unsigned char>(text_[at_])) != 0) {
+      ++at_;
+    }
+  }
+  auto take(char c) -> bool {
+    skip_space();
+    if (at_ < text_.size() and text_[at_] == c) {
+      ++at_;
+      return true;
+    }
+    return false;
+  }
+  auto take_word(std::string_view word) -> bool {
+    if (text_.substr(at_).starts_with(word)) {
+      at_ += word.size();
+      return true;
+    }
+    return false;
+  }
+
+  auto parse_value() -> std::optional<Json> {
+    skip_space();
+    if (at_ == text_.size()) {
+      return std::nullopt;
+    }
+    switch (text_[at_]) {
+      case '{':
+        return parse_object();
+      case '[':
+        return parse_array();
+      case '"':
+        if (auto text = parse_string()) {
+          return Json{std::move(*text)};
+        }
+        return std::nullopt;
+      default:
+        break;
+    }
+    if (take_word("true")) {
+      return Json{true};
+    }
+    if (take_word("false")) {
+      return Json{false};
+    }
+    if (take_word("null")) {
+      return Json{nullptr};
+    }
+    return parse_number();
+  }
+
+  auto parse_object() -> std::optional<Json> {
+    auto object{std::make_shared<Json::Object>()};
+    take('{');
+    if (take('}')) {
+      return Json{object};
+    }
+    do {
+      skip_space();
+      auto key{parse_string()};
+      if (not key or not take(':')) {
+        return std::nullopt;
+      }
+      auto value{parse_value()};
+      if (not value) {
+        return std::nullopt;
+      }
+      object->insert_or_assign(std::move(*key), std::move(*value));
+    } while (take(','));
+    return take('}') ? std::optional{Json{object}} : std::nullopt;
+  }
+
+  auto parse_array() -> std::optional<Json> {
+    auto array{std::make_shared<Json::Array>()};
+    take('[');
+    if (take(']')) {
+      return Json{array};
+    }
+    do {
+      auto value{parse_value()};
+      if (not value) {
+        return std::nullopt;
+      }
+      array->push_back(std::move(*value));
+    } while (take(','));
+    return take(']') ? std::optional{Json{array}} : std::nullopt;
+  }
+
+  auto parse_string() -> std::optional<std::string> {
+    if (at_ == text_.size() or text_[at_] != '"') {
+      return std::nullopt;
+    }
+    ++at_;
+    std::string text;
+    while (at_ < text_.size() and text_[at_] != '"') {
+      auto c{text_[at_++]};
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return std::nullopt;
+      }
+      if (c == '\\') {
+        if (at_ == text_.size()) {
+          return std::nullopt;
+        }
+        switch (text_[at_++]) {
+          case '"':
+            c = '"';
+            break;
+          case '\\':
+            c = '\\';
+            break;
+          case '/':
+            c = '/';
+            break;
+          case 'n':
+            c = '\n';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case 'r':
+            c = '\r';
+            break;
+          case 'b':
+            c = '\b';
+            break;
+          case 'f':
+            c = '\f';
+            break;
+          case 'u':
+            // Trace names here are ASCII; keep the escape as read.
+            if (at_ + 4 > text_.size()) {
+              return std::nullopt;
+            }
+            text += "\\u";
+            text += text_.substr(at_, 4);
+            at_ += 4;
+            continue;
+          default:
+            return std::nullopt;
+        }
+      }
+      text += c;
+    }
+    if (at_ == text_.size()) {
+      return std::nullopt;
+    }
+    ++at_;
+    return text;
+  }
+
+  auto parse_number() -> std::optional<Json> {
+    const auto start{at_};
+    if (at_ < text_.size() and text_[at_] == '-') {
+      ++at_;
+    }
+    while (at_ < text_.size() and
+           (std::isdigit(static_cast<unsigned char>(text_[at_])) != 0 or
+            std::string_view{".eE+-"}.contains(text_[at_]))) {
+      ++at_;
+    }
+    if (at_ == start) {
+      return std::nullopt;
+    }
+    try {
+      return Json{std::stod(std::string{text_.substr(start, at_ - start)})};
+    } catch (const std::exception&) {
+      return std::nullopt;
+    }
+  }
+
+  std::string_view text_;
+  std::size_t at_{0};
+};
+
+auto read_file(const std::filesystem::path& path) -> std::string {
+  std::ifstream file{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>{file},
+          std::istreambuf_iterator<char>{}};
+}
+
+auto record_on_threads() -> void {
+  std::vector<std::jthread> threads;
+  for (int t{0}; t < Threads; ++t) {
+    threads.emplace_back([] {
+      for (int i{0}; i < ScopesPerThread; ++i) {
+        const csc::trace::Scope outer{Worker};
+        const csc::trace::Scope inner{Inner};
+      }
+    });
+  }
+  const csc::trace::Scope main{Main};
+}
+
+auto check_trace(const std::filesystem::path& path) -> void {
+  // Events from before `start` are discarded.
+  csc::trace::start();
+  { const csc::trace::Scope discarded{"discarded"}; }
+  csc::trace::start();
+  record_on_threads();
+  csc::trace::stop();
+  { const csc::trace::Scope ignored{"ignored"}; }
+
+  constexpr std::size_t Expected{(Threads * ScopesPerThread * 2) + 1};
+  expect(csc::trace::event_count() == Expected,
+         "every scope is recorded while recording, and only then");
+  csc::trace::write_file(path);
+
+  const auto text{read_file(path)};
+  const auto json{Parser{text}.parse()};
+  expect(json.has_value(), "the trace is valid JSON");
+  if (not json or json->object() == nullptr) {
+    return;
+  }
+  const auto& root{*json->object()};
+  const auto unit{root.find("displayTimeUnit")};
+  expect(unit != root.end() and unit->second.string() != nullptr and
+             *unit->second.string() == "ms",
+         "displayTimeUnit");
+  const auto found{root.find("traceEvents")};
+  const auto* events{found != root.end() ? found->second.array() : nullptr};
+  expect(events != nullptr and events->size() == Expected,
+         "traceEvents holds every event");
+  if (events == nullptr) {
+    return;
+  }
+
+  std::map<std::string, int> names;
+  std::map<double, std::map<std::string, int>> by_thread;
+  for (const auto& event : *events) {
+    const auto* fields{event.object()};
+    if (fields == nullptr) {
+      expect(false, "events are objects");
+      continue;
+    }
+    const auto field = [fields](const char* key) -> const Json* {
+      const auto at{fields->find(key)};
+      return at != fields->end() ? &at->second : nullptr;
+    };
+    const auto* name{field("name") ? field("name")->string() : nullptr};
+    const auto* phase{field("ph") ? field("ph")->string() : nullptr};
+    const auto* category{field("cat") ? field("cat")->string() : nullptr};
+    const auto* ts{field("ts") ? field("ts")->number() : nullptr};
+    const auto* dur{field("dur") ? field("dur")->number() : nullptr};
+    const auto* pid{field("pid") ? field("pid")->number() : nullptr};
+    const auto* tid{field("tid") ? field("tid")->number() : nullptr};
+    expect(name != nullptr and phase != nullptr and *phase == "X" and
+               category != nullptr and *category == "csc" and
+               ts != nullptr and *ts >= 0 and dur != nullptr and
+               *dur >= 0 and pid != nullptr and *pid == 1 and tid != nullptr,
+           "each event is a complete event with every field");
+    if (name != nullptr and tid != nullptr) {
+      ++names[*name];
+      ++by_thread[*tid][*name];
+    }
+  }
+
+  expect(names[Worker] == Threads * ScopesPerThread and
+             names[Inner] == Threads * ScopesPerThread and names[Main] == 1,
+         "each name appears once per scope, escaped names included");
+  expect(by_thread.size() == Threads + 1, "each thread has its own tid");
+  for (const auto& [tid, counts] : by_thread) {
+    expect((counts.size() == 1 and counts.begin()->first == Main) or
+               (counts.size() == 2 and
+                counts.at(Worker) == ScopesPerThread and
+                counts.at(Inner) == ScopesPerThread),
+           "a thread's events stay under its tid");
+  }
+}
+
+}  // namespace
+
+auto main() -> int {
+  const auto path{std::filesystem::temp_directory_path() /
+                  "csc_trace_test.json"};
+  check_trace(path);
+  std::filesystem::remove(path);
+  return csc::test::result();
+}